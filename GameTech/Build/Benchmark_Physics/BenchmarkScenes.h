@@ -0,0 +1,247 @@
+/******************************************************************************
+Class: BenchmarkScenes
+Implements:
+Author:
+	Will Hinds
+Description:
+
+	Headless versions of the physics scenes, built straight out of PhysicsNodes
+	so they can be stepped without a Window, GraphicsPipeline or any RenderNodes.
+
+	Each one follows the layout of the scene it is named after, but is scaled up
+	to (roughly) the requested number of dynamic bodies:
+		- Stacks      : Phy7_Solver pyramids of cubes, laid out in a grid
+		- BallPool    : CUDA_BallPool spheres dropped into a walled pool
+		- Cloth       : SoftBodyScene spring cloth, hanging from its top row
+		- Targets     : TargetPractise spring targets, with a sphere fired at them
+		                every few steps in place of the player
+
+	Everything is added to the PhysicsEngine, which deletes the nodes and
+	constraints again in RemoveAllPhysicsObjects.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <ncltech/PhysicsEngine.h>
+#include <ncltech/CuboidCollisionShape.h>
+#include <ncltech/SphereCollisionShape.h>
+#include <ncltech/SpringConstraint.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include <cmath>
+
+#ifndef GRAVITY
+#define GRAVITY 9.81f
+#endif
+
+//Called once per step before the physics update, for scenes that need to
+// do something other than just sit there (e.g. firing projectiles)
+typedef std::function<void(int step, int numBodies)> BenchmarkUpdateCallback;
+
+struct BenchmarkScene
+{
+	std::string							name;
+	std::function<void(int numBodies)>	build;
+	BenchmarkUpdateCallback				update;
+};
+
+namespace BenchmarkScenes
+{
+	//Uniform random value in [0, 1], in the same steps as the scenes use
+	inline float RandUnit()
+	{
+		return (float)(rand() % 101) / 100.0f;
+	}
+
+	inline PhysicsNode* AddCuboid(const Vector3& pos, const Vector3& halfdims, float inverse_mass)
+	{
+		PhysicsNode* pnode = new PhysicsNode();
+		pnode->SetPosition(pos);
+		pnode->SetInverseMass(inverse_mass);
+
+		CollisionShape* pColshape = new CuboidCollisionShape(halfdims);
+		pnode->SetCollisionShape(pColshape);
+		pnode->SetInverseInertia(pColshape->BuildInverseInertia(inverse_mass));
+		pnode->SetBoundingRadius(halfdims.Length());
+
+		PhysicsEngine::Instance()->AddPhysicsObject(pnode);
+		return pnode;
+	}
+
+	inline PhysicsNode* AddSphere(const Vector3& pos, float radius, float inverse_mass)
+	{
+		PhysicsNode* pnode = new PhysicsNode();
+		pnode->SetPosition(pos);
+		pnode->SetInverseMass(inverse_mass);
+
+		CollisionShape* pColshape = new SphereCollisionShape(radius);
+		pnode->SetCollisionShape(pColshape);
+		pnode->SetInverseInertia(pColshape->BuildInverseInertia(inverse_mass));
+		pnode->SetBoundingRadius(radius);
+
+		PhysicsEngine::Instance()->AddPhysicsObject(pnode);
+		return pnode;
+	}
+
+	//Phy7_Solver: pyramids of stackHeight cubes per side, as many as are needed for numBodies
+	inline void BuildStacks(int numBodies)
+	{
+		const int stackHeight = 6;
+		const int perStack = stackHeight * (stackHeight + 1) / 2;
+		const float spacing = stackHeight * 1.1f + 2.0f;
+
+		int numStacks = max((numBodies + perStack - 1) / perStack, 1);
+		int stacksPerRow = (int)ceilf(sqrtf((float)numStacks));
+		float halfExtent = stacksPerRow * spacing * 0.5f;
+
+		AddCuboid(Vector3(0.0f, -1.0f, 0.0f), Vector3(halfExtent + 5.0f, 1.0f, halfExtent + 5.0f), 0.0f);
+
+		for (int s = 0; s < numStacks; ++s)
+		{
+			Vector3 origin(
+				(s % stacksPerRow) * spacing - halfExtent + spacing * 0.5f,
+				0.0f,
+				(s / stacksPerRow) * spacing - halfExtent + spacing * 0.5f);
+
+			for (int y = 0; y < stackHeight; ++y)
+			{
+				for (int x = 0; x <= y; ++x)
+				{
+					PhysicsNode* cube = AddCuboid(
+						origin + Vector3(x * 1.1f - y * 0.5f, 0.5f + float(stackHeight - 1) - y, -0.5f),
+						Vector3(0.5f, 0.5f, 0.5f),
+						0.1f);
+					cube->SetElasticity(0.0f);
+					cube->SetFriction(1.0f);
+				}
+			}
+		}
+	}
+
+	//CUDA_BallPool: the pool is widened to keep the same density of balls as the
+	// scene's 450 in a 14x14 pool
+	inline void BuildBallPool(int numBodies)
+	{
+		const float poolY = 2.5f;
+		float poolX = max(7.0f * sqrtf(numBodies / 450.0f), 4.0f);
+		float poolZ = poolX;
+
+		AddCuboid(Vector3(0.0f, -1.0f, 0.0f), Vector3(poolX, 1.0f, poolZ), 0.0f);
+		AddCuboid(Vector3(0.0f, poolY, poolZ + 0.5f), Vector3(poolX, poolY, 0.5f), 0.0f);
+		AddCuboid(Vector3(0.0f, poolY, -poolZ - 0.5f), Vector3(poolX, poolY, 0.5f), 0.0f);
+		AddCuboid(Vector3(poolX + 0.5f, poolY, 0.0f), Vector3(0.5f, poolY, poolZ), 0.0f);
+		AddCuboid(Vector3(-poolX - 0.5f, poolY, 0.0f), Vector3(0.5f, poolY, poolZ), 0.0f);
+
+		for (int i = 0; i < numBodies; ++i)
+		{
+			float radius = RandUnit() * 0.4f + 0.3f;
+			float x = RandUnit() * ((poolX - 3) * 2) - (poolX - 3);
+			float y = RandUnit() * (poolY + 20) + 2;
+			float z = RandUnit() * ((poolZ - 3) * 2) - (poolZ - 3);
+
+			PhysicsNode* ball = AddSphere(Vector3(x, y, z), radius, 0.005f / radius);
+			ball->SetElasticity(0.0f);
+			ball->SetFriction(1.0f);
+		}
+	}
+
+	//SoftBodyScene: a cloth twice as wide as it is tall, with the top row pinned in place
+	inline void BuildCloth(int numBodies)
+	{
+		const float separation = 0.5f;
+		const float invMass = 0.01f;
+
+		int sizeX = max((int)(sqrtf(numBodies * 2.0f) + 0.5f), 2);
+		int sizeY = max(numBodies / sizeX, 2);
+		float minX = -sizeX * separation * 0.5f;
+		float minY = 5.0f;
+
+		AddCuboid(Vector3(0.0f, -1.5f, 0.0f), Vector3(max(20.0f, -minX + 5.0f), 1.0f, 20.0f), 0.0f);
+
+		std::vector<PhysicsNode*> points(sizeX * sizeY);
+		for (int i = 0; i < sizeX; ++i)
+		{
+			for (int j = 0; j < sizeY; ++j)
+			{
+				PhysicsNode* point = AddSphere(
+					Vector3(i * separation + minX, j * separation + minY, 0.0f),
+					separation / 2,
+					j == sizeY - 1 ? 0.0f : invMass);
+				point->SetElasticity(0.2f);
+				points[i * sizeY + j] = point;
+			}
+		}
+
+		auto AddSpring = [](PhysicsNode* a, PhysicsNode* b)
+		{
+			PhysicsEngine::Instance()->AddConstraint(new SpringConstraint(a, b,
+				a->GetPosition(), b->GetPosition(), 1.0f, 1.0f));
+		};
+
+		for (int i = 0; i < sizeX; ++i)
+		{
+			for (int j = 0; j < sizeY; ++j)
+			{
+				PhysicsNode* point = points[i * sizeY + j];
+				bool lastX = (i == sizeX - 1), lastY = (j == sizeY - 1);
+
+				if (!lastY)					AddSpring(point, points[i * sizeY + j + 1]);
+				if (!lastX)					AddSpring(point, points[(i + 1) * sizeY + j]);
+				if (!lastX && !lastY)		AddSpring(point, points[(i + 1) * sizeY + j + 1]);
+			}
+		}
+	}
+
+	//TargetPractise: a grid of targets held up by springs
+	inline void BuildTargets(int numBodies)
+	{
+		const float spacing = 5.0f;
+		const float invMass = 0.1f;
+
+		int numX = max((int)ceilf(sqrtf((float)numBodies)), 1);
+		int numY = max((numBodies + numX - 1) / numX, 1);
+
+		for (int i = 0; i < numX; ++i)
+		{
+			for (int j = 0; j < numY; ++j)
+			{
+				Vector3 pos(i * spacing, j * spacing, RandUnit() * 4);
+				PhysicsNode* target = AddCuboid(pos, Vector3(1.0f, 1.0f, 0.2f), invMass);
+				target->SetElasticity(0.5f);
+				target->SetFriction(1.0f);
+				target->SetForce(Vector3(0.0f, 2 * GRAVITY / invMass, 0.0f));
+
+				PhysicsEngine::Instance()->AddConstraint(new SpringConstraint(target, pos, pos, 5.0f, 0.1f));
+			}
+		}
+	}
+
+	//Fires a sphere from in front of the targets at a random one, every fireInterval steps
+	inline void UpdateTargets(int step, int numBodies)
+	{
+		const int fireInterval = 10;
+		const float radius = 0.5f;
+		if (step % fireInterval != 0)
+			return;
+
+		int numX = max((int)ceilf(sqrtf((float)numBodies)), 1);
+		Vector3 aim(RandUnit() * (numX - 1) * 5.0f, RandUnit() * (numX - 1) * 5.0f, 0.0f);
+		Vector3 from(aim.x, aim.y, 30.0f);
+
+		PhysicsNode* sphere = AddSphere(from, radius, 0.005f / radius);
+		sphere->SetLinearVelocity((aim - from).Normalise() * 60 * radius);
+	}
+
+	//All scenes, sized by the benchmark's body count
+	inline std::vector<BenchmarkScene> GetScenes()
+	{
+		std::vector<BenchmarkScene> scenes;
+		scenes.push_back({ "stacks",	BuildStacks,	nullptr });
+		scenes.push_back({ "ballpool",	BuildBallPool,	nullptr });
+		scenes.push_back({ "cloth",		BuildCloth,		nullptr });
+		scenes.push_back({ "targets",	BuildTargets,	UpdateTargets });
+		return scenes;
+	}
+}
@@ -0,0 +1,362 @@
+// Headless physics benchmark
+//  - Steps each of the BenchmarkScenes for a fixed number of steps with every
+//    broadphase and body count asked for, then writes out the average time
+//    spent in each stage of the physics engine along with the number of
+//    collision pairs, manifolds and contact points, as CSV or JSON.
+//  - bodies is the number of dynamic nodes the scene actually built (which can
+//    be more than asked for, to fill out a grid), and bodies_end the number at
+//    the end of the run (targets keeps firing more spheres in).
+//  - allocs_per_step is the average number of heap allocations made by the
+//    physics thread in each step, only counted when built with
+//    PHYSICS_COUNT_ALLOCATIONS (-DPHYSICS_COUNT_ALLOCATIONS=ON), otherwise 0.
+//    A settled scene (e.g. stacks) should show 0.
+//  - Also builds without Visual Studio or OpenGL (e.g. on Linux) through
+//    GameTech/Build/CMakeLists.txt
+//
+// Usage: Benchmark_Physics [options]
+//   --scene <name|all>         stacks, ballpool, cloth, targets (default all)
+//   --broadphase <name|all>    bruteforce, octree, sap, aabbtree, spatialhash (default all)
+//   --narrowphase <name|all>   dispatch, sat, gjk (default dispatch)
+//   --bodies <n[,n,...]>       dynamic bodies asked for per scene, one run each (default 100,250,500,1000)
+//   --steps <n>                timed steps per run (default 600)
+//   --warmup <n>               untimed steps before timing starts (default 60)
+//   --format <csv|json>        output format (default csv)
+//   --out <file>               write to a file instead of stdout
+//   --sphere-accel <cpu|cuda>  collide dynamic spheres with the accelerated backend instead
+//   --no-sleep                 turn body sleeping off
+//   --deterministic            fixed seed, so every broadphase runs the same simulation
+
+#include <ncltech/PhysicsEngine.h>
+#include "BenchmarkScenes.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct BenchmarkOptions
+{
+	std::vector<std::string>	scenes;
+	std::vector<BroadphaseMode>	broadphases;
+	std::vector<NarrowphaseMode>	narrowphases;
+	std::vector<int>			bodyCounts;
+	int							steps;
+	int							warmup;
+	bool						json;
+	bool						sleeping;
+	bool						deterministic;
+	bool						sphereAccel;
+	SphereAccelBackend			sphereAccelBackend;
+	std::string					outFile;
+};
+
+//Averages of the engine's step stats over a whole run
+struct BenchmarkResult
+{
+	std::string		scene;
+	std::string		broadphase;
+	std::string		narrowphase;
+	std::string		sphereAccel;
+	int				bodies;			//Dynamic nodes after the scene was built
+	int				bodiesEnd;		//...and after the last step
+	int				steps;
+
+	double			integrationMs, broadphaseMs, narrowphaseMs, solverMs;
+	double			stepMs, maxStepMs;
+	double			colPairs, manifolds, contacts, awakeNodes;
+	double			satCacheHitRate;	//Fraction of SAT pairs separated by last step's axis
+	double			allocsPerStep;
+};
+
+static const char* broadphaseArgs[BROADPHASE_MAX] = { "bruteforce", "octree", "sap", "aabbtree", "spatialhash" };
+static const char* narrowphaseArgs[NARROWPHASE_MAX] = { "dispatch", "sat", "gjk" };
+
+void PrintUsage()
+{
+	printf("Usage: Benchmark_Physics [--scene <name|all>] [--broadphase <name|all>] [--narrowphase <name|all>]\n");
+	printf("                         [--bodies <n[,n,...]>]\n");
+	printf("                         [--steps <n>] [--warmup <n>] [--format <csv|json>] [--out <file>]\n");
+	printf("                         [--sphere-accel <cpu|cuda>] [--no-sleep] [--deterministic]\n");
+}
+
+std::vector<std::string> SplitList(const std::string& list)
+{
+	std::vector<std::string> items;
+	size_t start = 0;
+	while (start <= list.size())
+	{
+		size_t end = list.find(',', start);
+		if (end == std::string::npos) end = list.size();
+		if (end > start) items.push_back(list.substr(start, end - start));
+		start = end + 1;
+	}
+	return items;
+}
+
+bool ParseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+	std::vector<BenchmarkScene> allScenes = BenchmarkScenes::GetScenes();
+
+	options.steps = 600;
+	options.warmup = 60;
+	options.json = false;
+	options.sleeping = true;
+	options.deterministic = false;
+	options.sphereAccel = false;
+	options.sphereAccelBackend = SPHEREACCEL_CPU;
+
+	std::string sceneArg = "all", broadphaseArg = "all", narrowphaseArg = "dispatch", bodiesArg = "100,250,500,1000";
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+
+		if (arg == "--scene" && hasValue)				sceneArg = argv[++i];
+		else if (arg == "--broadphase" && hasValue)		broadphaseArg = argv[++i];
+		else if (arg == "--narrowphase" && hasValue)	narrowphaseArg = argv[++i];
+		else if (arg == "--bodies" && hasValue)			bodiesArg = argv[++i];
+		else if (arg == "--steps" && hasValue)			options.steps = atoi(argv[++i]);
+		else if (arg == "--warmup" && hasValue)			options.warmup = atoi(argv[++i]);
+		else if (arg == "--format" && hasValue)			options.json = (strcmp(argv[++i], "json") == 0);
+		else if (arg == "--out" && hasValue)			options.outFile = argv[++i];
+		else if (arg == "--sphere-accel" && hasValue)
+		{
+			options.sphereAccel = true;
+			options.sphereAccelBackend = (strcmp(argv[++i], "cuda") == 0) ? SPHEREACCEL_CUDA : SPHEREACCEL_CPU;
+		}
+		else if (arg == "--no-sleep")					options.sleeping = false;
+		else if (arg == "--deterministic")				options.deterministic = true;
+		else
+		{
+			fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+			return false;
+		}
+	}
+
+	for (const std::string& name : SplitList(sceneArg))
+	{
+		bool found = false;
+		for (const BenchmarkScene& scene : allScenes)
+		{
+			if (name == "all" || name == scene.name)
+			{
+				options.scenes.push_back(scene.name);
+				found = true;
+			}
+		}
+		if (!found)
+		{
+			fprintf(stderr, "Unknown scene: %s\n", name.c_str());
+			return false;
+		}
+	}
+
+	for (const std::string& name : SplitList(broadphaseArg))
+	{
+		bool found = false;
+		for (int mode = 0; mode < BROADPHASE_MAX; ++mode)
+		{
+			if (name == "all" || name == broadphaseArgs[mode])
+			{
+				options.broadphases.push_back((BroadphaseMode)mode);
+				found = true;
+			}
+		}
+		if (!found)
+		{
+			fprintf(stderr, "Unknown broadphase: %s\n", name.c_str());
+			return false;
+		}
+	}
+
+	for (const std::string& name : SplitList(narrowphaseArg))
+	{
+		bool found = false;
+		for (int mode = 0; mode < NARROWPHASE_MAX; ++mode)
+		{
+			if (name == "all" || name == narrowphaseArgs[mode])
+			{
+				options.narrowphases.push_back((NarrowphaseMode)mode);
+				found = true;
+			}
+		}
+		if (!found)
+		{
+			fprintf(stderr, "Unknown narrowphase: %s\n", name.c_str());
+			return false;
+		}
+	}
+
+	for (const std::string& count : SplitList(bodiesArg))
+		options.bodyCounts.push_back(max(atoi(count.c_str()), 1));
+
+	return options.steps > 0 && options.warmup >= 0
+		&& !options.scenes.empty() && !options.broadphases.empty() && !options.narrowphases.empty()
+		&& !options.bodyCounts.empty();
+}
+
+BenchmarkResult RunBenchmark(const BenchmarkScene& scene, BroadphaseMode mode, NarrowphaseMode narrowphase, int numBodies, const BenchmarkOptions& options)
+{
+	PhysicsEngine* physics = PhysicsEngine::Instance();
+
+	//Same reset as a scene switch, so every run starts from the same point
+	physics->RemoveAllPhysicsObjects();
+	physics->SetDefaults();
+	physics->SetBroadphaseMode(mode);
+	physics->SetNarrowphaseMode(narrowphase);
+	if (physics->Sleeping() != options.sleeping)
+		physics->ToggleSleeping();
+	physics->SetSphereAccelBackend(options.sphereAccelBackend);
+	if (physics->GetGPUAccelerationState() != options.sphereAccel)
+		physics->ToggleGPUAcceleration();
+
+	scene.build(numBodies);
+
+	BenchmarkResult result = {};
+	result.scene = scene.name;
+	result.broadphase = broadphaseArgs[mode];
+	result.narrowphase = narrowphaseArgs[narrowphase];
+	result.sphereAccel = options.sphereAccel ? physics->GetSphereAccelBackendName() : "off";
+	result.bodies = (int)physics->NumDynamicNodes();
+	result.steps = options.steps;
+
+	//Each Update of exactly one timestep runs exactly one physics step
+	const float dt = physics->GetUpdateTimestep();
+	size_t satCacheTests = 0, satCacheHits = 0;
+	for (int step = 0; step < options.warmup + options.steps; ++step)
+	{
+		if (scene.update) scene.update(step, numBodies);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		physics->Update(dt);
+		auto end = std::chrono::high_resolution_clock::now();
+
+		if (step < options.warmup)
+			continue;
+
+		double stepMs = std::chrono::duration<double, std::milli>(end - start).count();
+		const PhysicsStepStats& stats = physics->GetLastStepStats();
+
+		result.integrationMs += stats.integrationMs;
+		result.broadphaseMs += stats.broadphaseMs;
+		result.narrowphaseMs += stats.narrowphaseMs;
+		result.solverMs += stats.solverMs;
+		result.stepMs += stepMs;
+		result.maxStepMs = max(result.maxStepMs, stepMs);
+		result.colPairs += stats.numColPairs;
+		result.manifolds += stats.numManifolds;
+		result.contacts += stats.numContacts;
+		result.awakeNodes += stats.numAwakeNodes;
+		satCacheTests += stats.numSATCacheTests;
+		satCacheHits += stats.numSATCacheHits;
+		result.allocsPerStep += physics->NumStepAllocations();
+	}
+
+	double invSteps = 1.0 / options.steps;
+	result.integrationMs *= invSteps;
+	result.broadphaseMs *= invSteps;
+	result.narrowphaseMs *= invSteps;
+	result.solverMs *= invSteps;
+	result.stepMs *= invSteps;
+	result.colPairs *= invSteps;
+	result.manifolds *= invSteps;
+	result.contacts *= invSteps;
+	result.awakeNodes *= invSteps;
+	result.bodiesEnd = (int)physics->NumDynamicNodes();
+	result.allocsPerStep *= invSteps;
+	result.satCacheHitRate = satCacheTests > 0 ? (double)satCacheHits / satCacheTests : 0.0;
+	return result;
+}
+
+void WriteCSV(FILE* out, const std::vector<BenchmarkResult>& results)
+{
+	fprintf(out, "scene,broadphase,narrowphase,sphere_accel,bodies,bodies_end,steps,integration_ms,broadphase_ms,narrowphase_ms,solver_ms,step_ms,max_step_ms,col_pairs,manifolds,contacts,awake_nodes,sat_cache_hit_rate,allocs_per_step\n");
+	for (const BenchmarkResult& r : results)
+	{
+		fprintf(out, "%s,%s,%s,%s,%d,%d,%d,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.1f,%.1f,%.1f,%.1f,%.3f,%.2f\n",
+			r.scene.c_str(), r.broadphase.c_str(), r.narrowphase.c_str(), r.sphereAccel.c_str(), r.bodies, r.bodiesEnd, r.steps,
+			r.integrationMs, r.broadphaseMs, r.narrowphaseMs, r.solverMs, r.stepMs, r.maxStepMs,
+			r.colPairs, r.manifolds, r.contacts, r.awakeNodes, r.satCacheHitRate, r.allocsPerStep);
+	}
+}
+
+void WriteJSON(FILE* out, const std::vector<BenchmarkResult>& results)
+{
+	fprintf(out, "[\n");
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchmarkResult& r = results[i];
+		fprintf(out, "  { \"scene\": \"%s\", \"broadphase\": \"%s\", \"narrowphase\": \"%s\", \"sphere_accel\": \"%s\", \"bodies\": %d, \"bodies_end\": %d, \"steps\": %d,\n",
+			r.scene.c_str(), r.broadphase.c_str(), r.narrowphase.c_str(), r.sphereAccel.c_str(), r.bodies, r.bodiesEnd, r.steps);
+		fprintf(out, "    \"integration_ms\": %.4f, \"broadphase_ms\": %.4f, \"narrowphase_ms\": %.4f, \"solver_ms\": %.4f,\n",
+			r.integrationMs, r.broadphaseMs, r.narrowphaseMs, r.solverMs);
+		fprintf(out, "    \"step_ms\": %.4f, \"max_step_ms\": %.4f,\n", r.stepMs, r.maxStepMs);
+		fprintf(out, "    \"col_pairs\": %.1f, \"manifolds\": %.1f, \"contacts\": %.1f, \"awake_nodes\": %.1f,\n",
+			r.colPairs, r.manifolds, r.contacts, r.awakeNodes);
+		fprintf(out, "    \"sat_cache_hit_rate\": %.3f, \"allocs_per_step\": %.2f }%s\n", r.satCacheHitRate, r.allocsPerStep, (i + 1 < results.size()) ? "," : "");
+	}
+	fprintf(out, "]\n");
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	PhysicsEngine* physics = PhysicsEngine::Instance();
+	physics->SetDeterministic(options.deterministic);
+
+	std::vector<BenchmarkScene> allScenes = BenchmarkScenes::GetScenes();
+	std::vector<BenchmarkResult> results;
+
+	for (const BenchmarkScene& scene : allScenes)
+	{
+		if (std::find(options.scenes.begin(), options.scenes.end(), scene.name) == options.scenes.end())
+			continue;
+
+		for (int numBodies : options.bodyCounts)
+		{
+			for (BroadphaseMode mode : options.broadphases)
+			{
+				for (NarrowphaseMode narrowphase : options.narrowphases)
+				{
+					//Scenes with rand() in them are seeded the same for every run
+					srand(DETERMINISTIC_SEED);
+
+					fprintf(stderr, "%s: %d bodies, %s, %s...\n", scene.name.c_str(), numBodies, broadphaseArgs[mode], narrowphaseArgs[narrowphase]);
+					results.push_back(RunBenchmark(scene, mode, narrowphase, numBodies, options));
+				}
+			}
+		}
+	}
+
+	FILE* out = stdout;
+	if (!options.outFile.empty())
+	{
+		out = fopen(options.outFile.c_str(), "w");
+		if (!out)
+		{
+			fprintf(stderr, "Could not open %s for writing\n", options.outFile.c_str());
+			PhysicsEngine::Release();
+			return 1;
+		}
+	}
+
+	if (options.json)
+		WriteJSON(out, results);
+	else
+		WriteCSV(out, results);
+
+	if (out != stdout)
+		fclose(out);
+
+	PhysicsEngine::Release();
+	return 0;
+}
@@ -110,6 +110,9 @@ public:
 		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_U))
 			PhysicsEngine::Instance()->ToggleGPUAcceleration();
 
+		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_1))
+			PhysicsEngine::Instance()->CycleSphereAccelBackend();
+
 		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_J) || Window::GetKeyboard()->KeyTriggered(KEYBOARD_J))
 			++firedEntities;
 
@@ -118,6 +121,8 @@ public:
 		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "--- Controls ---");
 		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "    GPU Acceleration : %s ([U] to toggle)",
 			PhysicsEngine::Instance()->GetGPUAccelerationState() ? "Enabled" : "Disabled");
+		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "    Sphere Backend   : %s ([1] to cycle)",
+			PhysicsEngine::Instance()->GetSphereAccelBackendName());
 	}
 
 private:
@@ -1,5 +1,6 @@
 #include <ncltech\PhysicsEngine.h>
 #include <ncltech\SceneManager.h>
+#include <ncltech\AllocationCounter.h>
 #include <nclgl\Window.h>
 #include <nclgl\NCLDebug.h>
 #include <nclgl\PerfTimer.h>
@@ -25,6 +26,10 @@ uint shadowCycleKey = 4;
 //  - Optionally prints out an error message and
 //    stalls the runtime if requested.
 void Quit(bool error = false, const std::string &reason = "") {
+	//Stop the physics thread before the scene (and its physics objects) are deleted
+	if (PhysicsEngine::Instance()->IsThreaded())
+		PhysicsEngine::Instance()->SetThreaded(false);
+
 	//Release Singletons
 	SceneManager::Release();
 	PhysicsEngine::Release();
@@ -70,9 +75,15 @@ void PrintStatusEntries()
 	//Print Engine Options
 	NCLDebug::AddStatusEntry(status_colour_header, "NCLTech Settings");
 	NCLDebug::AddStatusEntry(status_colour, "     Physics Engine: %s (Press P to toggle)", PhysicsEngine::Instance()->IsPaused() ? "Paused  " : "Enabled ");
+	NCLDebug::AddStatusEntry(status_colour, "     Physics Thread: %s [F]", PhysicsEngine::Instance()->IsThreaded() ? "Enabled" : "Disabled");
+	NCLDebug::AddStatusEntry(status_colour, "     Deterministic : %s [E]", PhysicsEngine::Instance()->Deterministic() ? "Enabled" : "Disabled");
 	NCLDebug::AddStatusEntry(status_colour, "     Monitor V-Sync: %s (Press V to toggle)", GraphicsPipeline::Instance()->GetVsyncEnabled() ? "Enabled " : "Disabled");
-	NCLDebug::AddStatusEntry(status_colour, "     Octrees       : %s [O]", PhysicsEngine::Instance()->Octrees() ? "Enabled" : "Disabled");
+	NCLDebug::AddStatusEntry(status_colour, "     Broadphase    : %s [B/O]", PhysicsEngine::Instance()->GetBroadphaseName());
+	NCLDebug::AddStatusEntry(status_colour, "     Narrowphase   : %s [Q]", PhysicsEngine::Instance()->GetNarrowphaseName());
 	NCLDebug::AddStatusEntry(status_colour, "     Sphere-Sphere : %s [L]", PhysicsEngine::Instance()->SphereCheck() ? "Enabled" : "Disabled");
+	NCLDebug::AddStatusEntry(status_colour, "     Sleeping      : %s [N]", PhysicsEngine::Instance()->Sleeping() ? "Enabled" : "Disabled");
+	NCLDebug::AddStatusEntry(status_colour, "     Parallel Solve: %s [I]", PhysicsEngine::Instance()->ParallelSolver() ? "Enabled" : "Disabled");
+	NCLDebug::AddStatusEntry(status_colour, "     Batched Solve : %s [U]", PhysicsEngine::Instance()->BatchedSolver() ? "Enabled" : "Disabled");
 	NCLDebug::AddStatusEntry(status_colour, "     Fire a sphere [J]");
 	NCLDebug::AddStatusEntry(status_colour, "     Fire a cube [K]");
 	NCLDebug::AddStatusEntry(status_colour, "     Use [+/-] to change fired entity size : %5.1f", firedRadius);
@@ -101,6 +112,16 @@ void PrintStatusEntries()
 		NCLDebug::AddStatusEntry(status_colour, "Collision Pairs   : %i", PhysicsEngine::Instance()->NumColPairs());
 		if (PhysicsEngine::Instance()->SphereCheck())
 			NCLDebug::AddStatusEntry(status_colour, "Sphere Checks     : %i", PhysicsEngine::Instance()->NumSphereChecks());
+		NCLDebug::AddStatusEntry(status_colour, "Awake Objects     : %i (%i islands)", PhysicsEngine::Instance()->NumAwakeNodes(), PhysicsEngine::Instance()->NumIslands());
+		NCLDebug::AddStatusEntry(status_colour, "Solver Islands    : %i (%i batches)", PhysicsEngine::Instance()->NumSolverIslands(), PhysicsEngine::Instance()->NumSolverBatches());
+		if (PhysicsEngine::Instance()->IsThreaded())
+			NCLDebug::AddStatusEntry(status_colour, "Dropped Steps     : %i", PhysicsEngine::Instance()->NumDroppedSteps());
+		if (PhysicsEngine::Instance()->Deterministic())
+			NCLDebug::AddStatusEntry(status_colour, "State Checksum    : %016llx", (unsigned long long)PhysicsEngine::Instance()->StepChecksum());
+		if (AllocationCounter::Enabled())
+			NCLDebug::AddStatusEntry(status_colour, "Step Allocations  : %i (%i pooled manifolds)", PhysicsEngine::Instance()->NumStepAllocations(), PhysicsEngine::Instance()->NumPooledManifolds());
+		else
+			NCLDebug::AddStatusEntry(status_colour, "Step Allocations  : n/a (release build)");
 	}
 	NCLDebug::AddStatusEntry(status_colour, "");
 
@@ -113,7 +134,7 @@ void PrintStatusEntries()
 		NCLDebug::AddStatusEntry(status_color_debug, "Collision Normals : %s [X]", (drawFlags & DEBUGDRAW_FLAGS_COLLISIONNORMALS) ? "Enabled " : "Disabled");
 		NCLDebug::AddStatusEntry(status_color_debug, "Collision Volumes : %s [C]", (drawFlags & DEBUGDRAW_FLAGS_COLLISIONVOLUMES) ? "Enabled " : "Disabled");
 		NCLDebug::AddStatusEntry(status_color_debug, "Manifolds         : %s [M]", (drawFlags & DEBUGDRAW_FLAGS_MANIFOLD) ? "Enabled " : "Disabled");
-		NCLDebug::AddStatusEntry(status_color_debug, "Octrees           : %s [O]", PhysicsEngine::Instance()->Octrees() ? "Enabled" : "Disabled");
+		NCLDebug::AddStatusEntry(status_color_debug, "Broadphase        : %s [B/O]", PhysicsEngine::Instance()->GetBroadphaseName());
 		NCLDebug::AddStatusEntry(status_color_debug, "Sphere-Sphere     : %s [L]", PhysicsEngine::Instance()->SphereCheck() ? "Enabled" : "Disabled");
 
 	}
@@ -166,9 +187,31 @@ void HandleKeyboardInputs()
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_O))
 		PhysicsEngine::Instance()->ToggleOctrees();
 
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_B))
+		PhysicsEngine::Instance()->CycleBroadphase();
+
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_Q))
+		PhysicsEngine::Instance()->CycleNarrowphase();
+
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_L))
 		PhysicsEngine::Instance()->ToggleSphereCheck();
 
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_N))
+		PhysicsEngine::Instance()->ToggleSleeping();
+
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_I))
+		PhysicsEngine::Instance()->ToggleParallelSolver();
+
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_U))
+		PhysicsEngine::Instance()->ToggleBatchedSolver();
+
+	//Reloads the scene, so it starts from the same point every time
+	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_E))
+	{
+		PhysicsEngine::Instance()->ToggleDeterministic();
+		SceneManager::Instance()->JumpToScene(sceneIdx);
+	}
+
 	//fire a sphere in the direction the camera is looking
 	if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_J))
 	{
@@ -225,17 +268,18 @@ int main()
 
 	Window::GetWindow().GetTimer()->GetTimedMS();
 
+	//Run the physics simulation on its own thread
+	PhysicsEngine::Instance()->SetThreaded(true);
+
 	//Create main game-loop
 	while (Window::GetWindow().UpdateWindow() && !Window::GetKeyboard()->KeyDown(KEYBOARD_ESCAPE))
 	{
 		//Start Timing
 		float dt = Window::GetWindow().GetTimer()->GetTimedMS() * 0.001f;	//How many milliseconds since last update?
 																		//Update Performance Timers (Show results every second)
-		//Print Status Entries
-		PrintStatusEntries();
-
-		//Handle Keyboard Inputs
-		HandleKeyboardInputs();
+		//Has to be done before taking the physics lock, as stopping the thread waits for it to finish
+		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_F))
+			PhysicsEngine::Instance()->ToggleThreaded();
 
 		timer_total.BeginTimingSection();
 		timer_total.UpdateRealElapsedTime(dt);
@@ -243,20 +287,33 @@ int main()
 		timer_update.UpdateRealElapsedTime(dt);
 		timer_render.UpdateRealElapsedTime(dt);
 
-		//Update Scene
-		timer_update.BeginTimingSection();
-		SceneManager::Instance()->GetCurrentScene()->OnUpdateScene(dt);
-		timer_update.EndTimingSection();
+		{
+			//Everything that touches the physics objects waits for the current step to finish.
+			// The actual rendering is done outside of this, so it can overlap the next step.
+			std::lock_guard<std::mutex> lock(PhysicsEngine::Instance()->GetPhysicsMutex());
+
+			//Print Status Entries
+			PrintStatusEntries();
 
-		//Update Physics	
-		timer_physics.BeginTimingSection();
-		PhysicsEngine::Instance()->Update(dt);
-		timer_physics.EndTimingSection();
-		PhysicsEngine::Instance()->DebugRender();
+			//Handle Keyboard Inputs
+			HandleKeyboardInputs();
+
+			//Update Scene
+			timer_update.BeginTimingSection();
+			SceneManager::Instance()->GetCurrentScene()->OnUpdateScene(dt);
+			timer_update.EndTimingSection();
+
+			//Update Physics (or just get the latest transforms from the physics thread)
+			timer_physics.BeginTimingSection();
+			PhysicsEngine::Instance()->Update(dt);
+			timer_physics.EndTimingSection();
+			PhysicsEngine::Instance()->DebugRender();
+
+			timer_render.BeginTimingSection();
+			GraphicsPipeline::Instance()->UpdateScene(dt);
+		}
 
 		//Render Scene
-		timer_render.BeginTimingSection();
-		GraphicsPipeline::Instance()->UpdateScene(dt);
 		GraphicsPipeline::Instance()->RenderScene();
 		{
 			//Forces synchronisation if vsync is disabled
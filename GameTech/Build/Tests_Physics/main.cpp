@@ -0,0 +1,215 @@
+// Headless physics regression tests
+//  - Each test builds a small scene, steps it and checks the engine ended up
+//    where it should, printing any failures and returning non-zero if there
+//    were any. Built and run through GameTech/Build/CMakeLists.txt (ctest).
+
+#include <ncltech/PhysicsEngine.h>
+#include <ncltech/ConvexHullCollisionShape.h>
+#include <ncltech/TriangleMeshCollisionShape.h>
+#include <ncltech/HeightfieldCollisionShape.h>
+#include "../Benchmark_Physics/BenchmarkScenes.h"
+#include <omp.h>
+#include <cmath>
+#include <cstdio>
+
+static int g_NumFailures = 0;
+
+#define CHECK(cond, str, ...) \
+	if (!(cond)) \
+	{ \
+		fprintf(stderr, "FAILED %s:%d: " str "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
+		g_NumFailures++; \
+	}
+
+void ResetEngine(bool simdSolver)
+{
+	PhysicsEngine* physics = PhysicsEngine::Instance();
+	physics->RemoveAllPhysicsObjects();
+	physics->SetDefaults();
+	if (!physics->WarmStarting())
+		physics->ToggleWarmStarting();
+	if (!physics->Sleeping())
+		physics->ToggleSleeping();
+	if (physics->SIMDSolver() != simdSolver)
+		physics->ToggleSIMDSolver();
+}
+
+void StepEngine(int steps)
+{
+	PhysicsEngine* physics = PhysicsEngine::Instance();
+	for (int i = 0; i < steps; ++i)
+		physics->Update(physics->GetUpdateTimestep());
+}
+
+//A sphere with no elasticity dropped on to a box has to come to rest on it. With
+// warm starting, a solver that can't take back last step's impulse keeps
+// bouncing it forever
+void TestSphereComesToRest(bool simdSolver)
+{
+	ResetEngine(simdSolver);
+	BenchmarkScenes::AddCuboid(Vector3(0.0f, -1.0f, 0.0f), Vector3(5.0f, 1.0f, 5.0f), 0.0f);
+	PhysicsNode* sphere = BenchmarkScenes::AddSphere(Vector3(0.0f, 2.0f, 0.0f), 0.5f, 1.0f);
+	sphere->SetElasticity(0.0f);
+
+	StepEngine(600);
+
+	const char* solver = simdSolver ? "SIMD" : "scalar";
+	CHECK(fabsf(sphere->GetPosition().y - 0.5f) < 0.05f, "%s solver: sphere at y=%.3f, not resting on the box", solver, sphere->GetPosition().y);
+	CHECK(!sphere->IsAwake(), "%s solver: sphere never went to sleep", solver);
+}
+
+//Once nothing new is touching, a step should reuse all of last step's storage.
+// Sleeping is turned off so the stacks are still collided and solved each step
+void TestSettledStepDoesntAllocate(bool simdSolver)
+{
+	ResetEngine(simdSolver);
+	PhysicsEngine::Instance()->ToggleSleeping();
+	BenchmarkScenes::BuildStacks(200);
+
+	StepEngine(600);
+
+	size_t allocations = 0;
+	for (int i = 0; i < 100; ++i)
+	{
+		StepEngine(1);
+		allocations += PhysicsEngine::Instance()->NumStepAllocations();
+	}
+
+	const char* solver = simdSolver ? "SIMD" : "scalar";
+	CHECK(allocations == 0, "%s solver: %d allocations in 100 steps of a settled scene", solver, (int)allocations);
+}
+
+//A hull's faces are each clipped by one plane per edge during contact generation,
+// so a prism with more sides than there are planes has to be simplified. Stood on
+// one of its caps it should still rest flat
+void TestBigHullFacesAreSimplified()
+{
+	ResetEngine(false);
+	BenchmarkScenes::AddCuboid(Vector3(0.0f, -1.0f, 0.0f), Vector3(5.0f, 1.0f, 5.0f), 0.0f);
+
+	const int numSides = MAX_CLIP_PLANES * 2;
+	std::vector<Vector3> points;
+	for (int i = 0; i < numSides; ++i)
+	{
+		float angle = 2.0f * PI * i / numSides;
+		points.push_back(Vector3(cosf(angle), -0.25f, sinf(angle)));
+		points.push_back(Vector3(cosf(angle), 0.25f, sinf(angle)));
+	}
+
+	ConvexHullCollisionShape* shape = new ConvexHullCollisionShape(points.data(), (int)points.size(), (int)points.size());
+	const Hull& hull = shape->GetHull();
+	for (size_t i = 0; i < hull.GetNumFaces(); ++i)
+		CHECK(hull.GetFace((int)i)._vert_ids.size() <= MAX_CLIP_PLANES, "hull face %d has %d vertices", (int)i, (int)hull.GetFace((int)i)._vert_ids.size());
+
+	PhysicsNode* prism = new PhysicsNode();
+	prism->SetPosition(Vector3(0.0f, 1.0f, 0.0f));
+	prism->SetInverseMass(1.0f);
+	prism->SetCollisionShape(shape);
+	prism->SetInverseInertia(shape->BuildInverseInertia(1.0f));
+	prism->SetBoundingRadius(1.1f);
+	prism->SetElasticity(0.0f);
+	PhysicsEngine::Instance()->AddPhysicsObject(prism);
+
+	StepEngine(600);
+
+	CHECK(fabsf(prism->GetPosition().y - 0.25f) < 0.05f, "prism at y=%.3f, not resting on its cap", prism->GetPosition().y);
+	CHECK(!prism->IsAwake(), "prism never went to sleep");
+}
+
+//A box covering more triangles than the query buffer starts with has to be tested
+// against all of them, not just the first ones found, to rest level on the mesh
+void TestBoxOnFineMeshRestsLevel()
+{
+	ResetEngine(false);
+
+	const int cells = 24;
+	const float cellSize = 0.5f;
+	std::vector<Vector3> vertices;
+	std::vector<uint> indices;
+	for (int z = 0; z <= cells; ++z)
+		for (int x = 0; x <= cells; ++x)
+			vertices.push_back(Vector3((x - cells / 2) * cellSize, 0.0f, (z - cells / 2) * cellSize));
+
+	for (int z = 0; z < cells; ++z)
+	{
+		for (int x = 0; x < cells; ++x)
+		{
+			uint i = z * (cells + 1) + x;
+			uint quad[6] = { i, i + cells + 1, i + 1, i + 1, i + cells + 1, i + cells + 2 };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	TriangleMeshCollisionShape* mesh = new TriangleMeshCollisionShape(vertices.data(), (uint)vertices.size(), indices.data(), (uint)indices.size());
+	PhysicsNode* ground = new PhysicsNode();
+	ground->SetInverseMass(0.0f);
+	ground->SetCollisionShape(mesh);
+	ground->SetBoundingRadius(mesh->GetBoundingRadius());
+	PhysicsEngine::Instance()->AddPhysicsObject(ground);
+
+	PhysicsNode* box = BenchmarkScenes::AddCuboid(Vector3(0.0f, 0.49f, 0.0f), Vector3(3.0f, 0.5f, 3.0f), 1.0f);
+	box->SetElasticity(0.0f);
+
+	int buffer[TRIANGLEMESH_MAX_QUERY_TRIANGLES];
+	int numOverlapping = mesh->FindOverlappingTriangles(box->GetCollisionShape(), buffer, TRIANGLEMESH_MAX_QUERY_TRIANGLES);
+	CHECK(numOverlapping > TRIANGLEMESH_MAX_QUERY_TRIANGLES, "query found %d triangles under the box, expected more than fit", numOverlapping);
+
+	StepEngine(600);
+
+	Vector3 up = box->GetOrientation().ToMatrix3() * Vector3(0.0f, 1.0f, 0.0f);
+	CHECK(fabsf(box->GetPosition().y - 0.5f) < 0.05f, "box at y=%.3f, not resting on the mesh", box->GetPosition().y);
+	CHECK(up.y > 0.999f, "box tilted, up is (%.3f, %.3f, %.3f)", up.x, up.y, up.z);
+}
+
+//Same again for a heightfield, whose cells are found without a hierarchy
+void TestBoxOnFineHeightfieldRestsLevel()
+{
+	ResetEngine(false);
+
+	const int samples = 25;
+	std::vector<float> heights(samples * samples, 0.0f);
+	HeightfieldCollisionShape* field = new HeightfieldCollisionShape(heights.data(), samples, samples, 0.5f, 0.5f);
+	PhysicsNode* ground = new PhysicsNode();
+	ground->SetInverseMass(0.0f);
+	ground->SetCollisionShape(field);
+	ground->SetBoundingRadius(field->GetBoundingRadius());
+	PhysicsEngine::Instance()->AddPhysicsObject(ground);
+
+	PhysicsNode* box = BenchmarkScenes::AddCuboid(Vector3(6.0f, 0.49f, 6.0f), Vector3(3.0f, 0.5f, 3.0f), 1.0f);
+	box->SetElasticity(0.0f);
+
+	int buffer[TRIANGLEMESH_MAX_QUERY_TRIANGLES];
+	int numOverlapping = field->FindOverlappingTriangles(box->GetCollisionShape(), buffer, TRIANGLEMESH_MAX_QUERY_TRIANGLES);
+	CHECK(numOverlapping > TRIANGLEMESH_MAX_QUERY_TRIANGLES, "query found %d heightfield triangles under the box, expected more than fit", numOverlapping);
+
+	StepEngine(600);
+
+	Vector3 up = box->GetOrientation().ToMatrix3() * Vector3(0.0f, 1.0f, 0.0f);
+	CHECK(fabsf(box->GetPosition().y - 0.5f) < 0.05f, "box at y=%.3f, not resting on the heightfield", box->GetPosition().y);
+	CHECK(up.y > 0.999f, "box tilted on the heightfield, up is (%.3f, %.3f, %.3f)", up.x, up.y, up.z);
+}
+
+int main(int argc, char** argv)
+{
+	//Allocations are only counted on the calling thread
+	omp_set_num_threads(1);
+
+	TestSphereComesToRest(false);
+	TestSphereComesToRest(true);
+	TestSettledStepDoesntAllocate(false);
+	TestSettledStepDoesntAllocate(true);
+	TestBigHullFacesAreSimplified();
+	TestBoxOnFineMeshRestsLevel();
+	TestBoxOnFineHeightfieldRestsLevel();
+
+	PhysicsEngine::Release();
+
+	if (g_NumFailures > 0)
+	{
+		fprintf(stderr, "%d check(s) failed\n", g_NumFailures);
+		return 1;
+	}
+
+	printf("All checks passed\n");
+	return 0;
+}
@@ -9,6 +9,7 @@
 #include <ncltech\GameObject.h>
 #include <ncltech\SphereCollisionShape.h>
 #include <ncltech\CuboidCollisionShape.h>
+#include <ncltech\ConvexHullCollisionShape.h>
 #include <ncltech\CommonUtils.h>
 #include <ncltech\CommonMeshes.h>
 #include "ObjectPlayer.h"
@@ -54,7 +55,7 @@ public:
 
 		player->SetPhysics(new PhysicsNode());
 		player->Physics()->SetPosition(Vector3(0.0f, 0.5f, 0.0f));
-		player->Physics()->SetCollisionShape(new CuboidCollisionShape(Vector3(0.5f, 0.5f, 1.0f)));
+		player->Physics()->SetCollisionShape(new ConvexHullCollisionShape(m_MeshPlayer));
 
 		this->AddGameObject(player);
 
@@ -13,11 +13,29 @@ public:
 	Phy7_Solver(const std::string& friendly_name)
 		: Scene(friendly_name)
 		, m_StackHeight(6)
+		, m_MaxDrift(0.0f)
+		, m_AvgDrift(0.0f)
+		, m_Elapsed(0.0f)
 	{}
 
 	int m_StackHeight;
+
+	//Stack drift benchmark - how far the cubes have moved from where they were
+	// placed, which for a perfectly stable stack would stay at zero
+	std::vector<PhysicsNode*>	m_StackNodes;
+	std::vector<Vector3>		m_StartPositions;
+	float m_MaxDrift;
+	float m_AvgDrift;
+	float m_Elapsed;
+
 	virtual void OnInitializeScene() override
 	{
+		m_StackNodes.clear();
+		m_StartPositions.clear();
+		m_MaxDrift = 0.0f;
+		m_AvgDrift = 0.0f;
+		m_Elapsed = 0.0f;
+
 		//Create Ground
 		this->AddGameObject(CommonUtils::BuildCuboidObject(
 			"Ground",
@@ -54,6 +72,9 @@ public:
 				cube->Physics()->SetFriction(1.0f);
 
 				this->AddGameObject(cube);
+
+				m_StackNodes.push_back(cube->Physics());
+				m_StartPositions.push_back(cube->Physics()->GetPosition());
 			}
 		}
 		
@@ -61,14 +82,70 @@ public:
 	}
 
 
+	virtual void OnCleanupScene() override
+	{
+		m_StackNodes.clear();
+		m_StartPositions.clear();
+		Scene::OnCleanupScene();
+	}
+
 	virtual void OnUpdateScene(float dt) override
 	{
 		Scene::OnUpdateScene(dt);
 
 		uint drawFlags = PhysicsEngine::Instance()->GetDebugDrawFlags();
+		PhysicsEngine* physics = PhysicsEngine::Instance();
+
+		if (!physics->IsPaused())
+			m_Elapsed += dt;
+
+		//Drift is measured in the plane of the stack, as the cubes are
+		// expected to settle down slightly onto each other
+		float sumDrift = 0.0f;
+		m_MaxDrift = 0.0f;
+		for (size_t i = 0; i < m_StackNodes.size(); ++i)
+		{
+			Vector3 offset = m_StackNodes[i]->GetPosition() - m_StartPositions[i];
+			float drift = sqrtf(offset.x * offset.x + offset.z * offset.z);
+			sumDrift += drift;
+			m_MaxDrift = max(m_MaxDrift, drift);
+		}
+		m_AvgDrift = m_StackNodes.size() > 0 ? sumDrift / m_StackNodes.size() : 0.0f;
 
 		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "--- Controls ---");
 		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "    Stack Height : %2d ([1]/[2] to change)", m_StackHeight);
+		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "    Solver Iterations : %2d ([3]/[4] to change)", physics->GetSolverIterations());
+		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "    Warm Starting : %s ([5] to toggle)", physics->WarmStarting() ? "Enabled" : "Disabled");
+		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "    Contact Solver : %s ([6] to toggle, [7] to benchmark)", physics->SIMDSolver() ? "SIMD" : "Scalar");
+		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "--- Stack Drift ---");
+		NCLDebug::AddStatusEntry(Vector4(1.0f, 0.9f, 0.8f, 1.0f), "    After %5.1fs : avg %.4fm, max %.4fm", m_Elapsed, m_AvgDrift, m_MaxDrift);
+
+		//Changing the solver settings logs the result of the current run and
+		// restarts the stack, so runs can be compared
+		int iterations = physics->GetSolverIterations();
+		bool warmStarting = physics->WarmStarting();
+		bool simd = physics->SIMDSolver();
+		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_3)) iterations += 5;
+		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_4)) iterations = max(iterations - 5, 1);
+		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_5)) warmStarting = !warmStarting;
+		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_6)) simd = !simd;
+
+		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_7))
+			physics->BenchmarkContactSolvers(20);
+
+		if (iterations != physics->GetSolverIterations() || warmStarting != physics->WarmStarting() || simd != physics->SIMDSolver())
+		{
+			NCLLOG("[Solver] %s, %d iterations, warm starting %s: drift avg %.4fm max %.4fm after %.1fs",
+				physics->SIMDSolver() ? "SIMD" : "Scalar", physics->GetSolverIterations(), physics->WarmStarting() ? "on" : "off",
+				m_AvgDrift, m_MaxDrift, m_Elapsed);
+
+			physics->SetSolverIterations(iterations);
+			if (warmStarting != physics->WarmStarting())
+				physics->ToggleWarmStarting();
+			if (simd != physics->SIMDSolver())
+				physics->ToggleSIMDSolver();
+			SceneManager::Instance()->JumpToScene(SceneManager::Instance()->GetCurrentSceneIndex());
+		}
 
 		if (Window::GetKeyboard()->KeyTriggered(KEYBOARD_1))
 		{
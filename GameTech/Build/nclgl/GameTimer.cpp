@@ -1,8 +1,7 @@
 #include "GameTimer.h"
 
 GameTimer::GameTimer(void)	{
-	QueryPerformanceFrequency((LARGE_INTEGER *)&frequency);
-	QueryPerformanceCounter((LARGE_INTEGER *)&start);
+	start = std::chrono::steady_clock::now();
 
 	lastTime = GetMS();
 }
@@ -11,9 +10,8 @@ GameTimer::GameTimer(void)	{
 Returns the Milliseconds since timer was started
 */
 float GameTimer::GetMS() {
-	LARGE_INTEGER t;	
-	QueryPerformanceCounter(&t);
-	return (float)((t.QuadPart  - start.QuadPart) * 1000.0 / frequency.QuadPart);
+	std::chrono::duration<double, std::milli> t = std::chrono::steady_clock::now() - start;
+	return (float)t.count();
 }
 
 float	 GameTimer::GetTimedMS() {
@@ -1,7 +1,7 @@
 /******************************************************************************
 Class:GameTimer
 Author:Rich Davison
-Description:Wraps Windows PerformanceCounter. GameTimers keep track of how much
+Description:Wraps std::chrono's steady_clock. GameTimers keep track of how much
 time has passed since they were last polled - so you could use multiple
 GameTimers to trigger events at different time periods. 
 
@@ -14,7 +14,7 @@ _-_-_-_-_-_-_-""  ""
 
 #pragma once
 
-#include "Windows.h"
+#include <chrono>
 
 class GameTimer	{
 public:
@@ -28,8 +28,7 @@ public:
 	float	GetTimedMS();
 
 protected:
-	LARGE_INTEGER	start;			//Start of timer
-	LARGE_INTEGER	frequency;		//Ticks Per Second
+	std::chrono::steady_clock::time_point	start;	//Start of timer
 
 	float lastTime;					//Last time GetTimedMS was called
 };
@@ -1,10 +1,15 @@
 #include "HeightMap.h"
 
-HeightMap::HeightMap(std::string name, const uint rawWidth, const uint rawHeight, const float HeightMapX, const float HeightMapY, const float HeightMapZ, const float HeightMapTexX, const float HeightMapTexZ) {
+HeightMap::HeightMap(std::string name, const uint rawWidth, const uint rawHeight, const float HeightMapX, const float HeightMapY, const float HeightMapZ, const float HeightMapTexX, const float HeightMapTexZ)
+	: rawWidth(0)
+	, rawHeight(0)
+{
 	std::ifstream file(name.c_str(), ios::binary);
 	if (!file) {
 		return;
 	}
+	this->rawWidth = rawWidth;
+	this->rawHeight = rawHeight;
 	numVertices = rawWidth * rawHeight;
 	numIndices = (rawWidth - 1)*(rawHeight - 1) * 6;
 	vertices = new Vector3[numVertices];
@@ -3,7 +3,7 @@
 #include <iostream>
 #include <fstream>
 
-#include "..\nclgl\mesh.h"
+#include "Mesh.h"
 
 
 #ifndef HEIGHT_MAP_DEF_OFF
@@ -22,4 +22,11 @@ public:
 	HeightMap(std::string name, const uint rawWidth = RAW_WIDTH, const uint rawHeight = RAW_HEIGHT, const float HeightMapX= HEIGHTMAP_X, const float HeightMapY = HEIGHTMAP_Y, const float HeightMapZ = HEIGHTMAP_Z, const float HeightMapTexX = HEIGHTMAP_TEX_X, const float HeightMapTexZ = HEIGHTMAP_TEX_Z);
 	~HeightMap(void) {};
 
+	//Number of samples along x and z, vertex (x, z) being vertices[x * rawWidth + z]
+	uint GetRawWidth() const	{ return rawWidth; }
+	uint GetRawHeight() const	{ return rawHeight; }
+
+protected:
+	uint rawWidth;
+	uint rawHeight;
 };
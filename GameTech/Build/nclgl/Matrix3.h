@@ -13,6 +13,7 @@ optimal however, so you should still be thinking about how it could be made bett
 #pragma once
 
 #include "Vector3.h"
+#include <cstring>
 
 class Matrix4;
 
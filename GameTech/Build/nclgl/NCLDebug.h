@@ -65,7 +65,10 @@ function as it will include the filename and linenumber it was triggered on with
 #include "Matrix3.h"
 #include "Vector4.h"
 #include "Vector3.h"
+#ifndef NCLTECH_HEADLESS
 #include "Shader.h"
+#endif
+#include <string>
 #include <vector>
 #include <mutex>
 #include <deque>
@@ -88,12 +91,12 @@ enum TextAlignment
 };
 
 #if _DEBUG
-#define NCLERROR(str, ...) {NCLDebug::LogE(__FILE__, __LINE__, str, __VA_ARGS__);  __debugbreak();}
+#define NCLERROR(str, ...) {NCLDebug::LogE(__FILE__, __LINE__, str, ##__VA_ARGS__);  __debugbreak();}
 #else
-#define NCLERROR(str, ...) {NCLDebug::LogE(__FILE__, __LINE__, str, __VA_ARGS__);} 
+#define NCLERROR(str, ...) {NCLDebug::LogE(__FILE__, __LINE__, str, ##__VA_ARGS__);} 
 #endif
 
-#define NCLLOG(str, ...) NCLDebug::Log(str, __VA_ARGS__)
+#define NCLLOG(str, ...) NCLDebug::Log(str, ##__VA_ARGS__)
 
 
 
@@ -172,6 +175,8 @@ public:
 
 
 
+#ifndef NCLTECH_HEADLESS
+	//Headless builds (see CMakeLists.txt) only log to the console, with no renderer to call these
 	//Called by GraphicsPipeline class
 	static void _ClearLog();
 
@@ -250,6 +255,7 @@ protected:
 
 	static GLuint	g_glLogFontTex;
 	static GLuint	g_glDefaultFontTex;
+#endif
 };
 
 
@@ -0,0 +1,85 @@
+/******************************************************************************
+Class: NCLDebug (Headless)
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Stand-in for NCLDebug.cpp in builds without a renderer (NCLTECH_HEADLESS, see
+	CMakeLists.txt), so the physics engine can be built and run on its own. All of
+	the draw functions do nothing, while log and status entries are printed to the
+	console.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#ifdef NCLTECH_HEADLESS
+
+#include "NCLDebug.h"
+#include <cstdarg>
+#include <cstdio>
+
+#define NCLDEBUG_FORMAT(buf, text) \
+	char buf[1024]; \
+	{ \
+		va_list args; \
+		va_start(args, text); \
+		vsnprintf(buf, sizeof(buf), text.c_str(), args); \
+		va_end(args); \
+	}
+
+void NCLDebug::DrawPoint(const Vector3& pos, float point_radius, const Vector3& color) {}
+void NCLDebug::DrawPoint(const Vector3& pos, float point_radius, const Vector4& color) {}
+void NCLDebug::DrawPointNDT(const Vector3& pos, float point_radius, const Vector3& color) {}
+void NCLDebug::DrawPointNDT(const Vector3& pos, float point_radius, const Vector4& color) {}
+
+void NCLDebug::DrawThickLine(const Vector3& start, const Vector3& end, float line_width, const Vector3& color) {}
+void NCLDebug::DrawThickLine(const Vector3& start, const Vector3& end, float line_width, const Vector4& color) {}
+void NCLDebug::DrawThickLineNDT(const Vector3& start, const Vector3& end, float line_width, const Vector3& color) {}
+void NCLDebug::DrawThickLineNDT(const Vector3& start, const Vector3& end, float line_width, const Vector4& color) {}
+
+void NCLDebug::DrawHairLine(const Vector3& start, const Vector3& end, const Vector3& color) {}
+void NCLDebug::DrawHairLine(const Vector3& start, const Vector3& end, const Vector4& color) {}
+void NCLDebug::DrawHairLineNDT(const Vector3& start, const Vector3& end, const Vector3& color) {}
+void NCLDebug::DrawHairLineNDT(const Vector3& start, const Vector3& end, const Vector4& color) {}
+
+void NCLDebug::DrawMatrix(const Matrix4& transform_mtx) {}
+void NCLDebug::DrawMatrix(const Matrix3& rotation_mtx, const Vector3& position) {}
+void NCLDebug::DrawMatrixNDT(const Matrix4& transform_mtx) {}
+void NCLDebug::DrawMatrixNDT(const Matrix3& rotation_mtx, const Vector3& position) {}
+
+void NCLDebug::DrawTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2, const Vector4& color) {}
+void NCLDebug::DrawTriangleNDT(const Vector3& v0, const Vector3& v1, const Vector3& v2, const Vector4& color) {}
+
+void NCLDebug::DrawPolygon(int n_verts, const Vector3* verts, const Vector4& color) {}
+void NCLDebug::DrawPolygonNDT(int n_verts, const Vector3* verts, const Vector4& color) {}
+
+void NCLDebug::DrawTextWs(const Vector3& pos, const float font_size, const TextAlignment alignment, const Vector4 color, const std::string text, ...) {}
+void NCLDebug::DrawTextWsNDT(const Vector3& pos, const float font_size, const TextAlignment alignment, const Vector4 color, const std::string text, ...) {}
+void NCLDebug::DrawTextCs(const Vector4& pos, const float font_size, const std::string& text, const TextAlignment alignment, const Vector4 color) {}
+
+
+void NCLDebug::AddStatusEntry(const Vector4& color, const std::string text, ...)
+{
+	NCLDEBUG_FORMAT(buf, text);
+	printf("%s\n", buf);
+}
+
+void NCLDebug::Log(const Vector3& color, const std::string text, ...)
+{
+	NCLDEBUG_FORMAT(buf, text);
+	printf("%s\n", buf);
+}
+
+void NCLDebug::Log(const std::string text, ...)
+{
+	NCLDEBUG_FORMAT(buf, text);
+	printf("%s\n", buf);
+}
+
+void NCLDebug::LogE(const char* filename, int linenumber, const std::string text, ...)
+{
+	NCLDEBUG_FORMAT(buf, text);
+	fprintf(stderr, "[ERROR] %s:%d\n\t \"%s\"\n", filename, linenumber, buf);
+}
+
+#endif
@@ -26,8 +26,8 @@ _-_-_-_-_-_-_-""  ""
 
 
 
-#include <GL\glew.h>
-#include <GL\wglew.h>
+#include <GL/glew.h>
+#include <GL/wglew.h>
 
 #include <SOIL.h>
 
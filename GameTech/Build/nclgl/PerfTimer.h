@@ -20,6 +20,7 @@ time of the various components of the game engine.
 #pragma once
 #include "GameTimer.h"
 #include "NCLDebug.h"
+#include <cstring>
 
 class PerfTimer
 {
@@ -27,6 +28,7 @@ public:
 	PerfTimer()
 		: m_UpdateInterval(1.0f)
 		, m_RealTimeElapsed(0.0f)
+		, m_LastElapsed(0.0f)
 	{
 		m_Timer.GetTimedMS();
 		memset(&m_CurrentData, 0, sizeof(PerfTimer_Data));
@@ -45,6 +47,9 @@ public:
 	//Returns the average execution time
 	inline float GetAvg() const { return m_PreviousData._sum / float(m_PreviousData._num); }
 
+	//Returns the execution time of the last timed section (not cached)
+	inline float GetLast() const { return m_LastElapsed; }
+
 	//Changes the rate at which the results are updated/replaced
 	void SetUpdateInterval(float seconds) { m_UpdateInterval = seconds; }
 
@@ -60,6 +65,7 @@ public:
 	void EndTimingSection()
 	{
 		float elapsed = m_Timer.GetTimedMS();
+		m_LastElapsed = elapsed;
 
 		//Set the min/max execution times
 		if (m_CurrentData._num == 0)
@@ -104,6 +110,7 @@ public:
 protected:
 	float m_UpdateInterval;
 	float m_RealTimeElapsed;
+	float m_LastElapsed;
 
 	GameTimer m_Timer;
 
@@ -1,5 +1,5 @@
 #pragma once
-#include "vector3.h"
+#include "Vector3.h"
 
 class Plane {
 public:
@@ -35,8 +35,18 @@ static inline double DegToRad(const double rad)	{
 typedef unsigned int uint;
 
 //I blame Microsoft...
+#ifdef _MSC_VER
 #define max(a,b)    (((a) > (b)) ? (a) : (b))
 #define min(a,b)    (((a) < (b)) ? (a) : (b))
+#else
+//Other standard libraries use min/max as names themselves, so can't have them
+// defined as macros (still taking two different types, same as the macros above)
+#include <type_traits>
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type max(const A& a, const B& b) { return (a > b) ? a : b; }
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type min(const A& a, const B& b) { return (a < b) ? a : b; }
+#endif
 
 #define SHADERDIR	"../../Data/Shaders/"
 #define MESHDIR		"../../Data/Meshes/"
@@ -0,0 +1,35 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef PHYSICS_COUNT_ALLOCATIONS
+
+static thread_local size_t g_NumAllocations = 0;
+
+static void* CountedAlloc(size_t size)
+{
+	++g_NumAllocations;
+	void* p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size)						{ return CountedAlloc(size); }
+void* operator new[](size_t size)					{ return CountedAlloc(size); }
+void operator delete(void* p) throw()				{ free(p); }
+void operator delete[](void* p) throw()				{ free(p); }
+
+size_t AllocationCounter::NumAllocations()
+{
+	return g_NumAllocations;
+}
+
+#else
+
+size_t AllocationCounter::NumAllocations()
+{
+	return 0;
+}
+
+#endif
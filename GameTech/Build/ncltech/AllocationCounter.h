@@ -0,0 +1,41 @@
+/******************************************************************************
+Namespace: AllocationCounter
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Debug counter of heap allocations, used to check that a physics step with
+	nothing new happening in it doesn't allocate anything.
+
+	When PHYSICS_COUNT_ALLOCATIONS is defined (by default in debug builds) the
+	global operator new/delete are replaced with versions that count every
+	allocation made by the program. Otherwise the count is always zero.
+
+	Each thread has its own count, so a step run on the physics thread isn't
+	charged for whatever the renderer allocates at the same time. Allocations
+	made on OpenMP's worker threads during the step aren't included either.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(_DEBUG) && !defined(PHYSICS_COUNT_ALLOCATIONS)
+#define PHYSICS_COUNT_ALLOCATIONS
+#endif
+
+namespace AllocationCounter
+{
+	// Number of heap allocations made so far by the calling thread
+	size_t NumAllocations();
+
+	inline bool Enabled()
+	{
+#ifdef PHYSICS_COUNT_ALLOCATIONS
+		return true;
+#else
+		return false;
+#endif
+	}
+}
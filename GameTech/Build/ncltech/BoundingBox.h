@@ -14,9 +14,10 @@ with graphics frustum culling by using both AABB and bounding sphere's inside Sc
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include <nclgl\Matrix4.h>
-#include <nclgl\Vector3.h>
-#include <nclgl\common.h>
+#include <nclgl/Matrix4.h>
+#include <nclgl/Vector3.h>
+#include <nclgl/common.h>
+#include <cfloat>
 
 struct BoundingBox
 {
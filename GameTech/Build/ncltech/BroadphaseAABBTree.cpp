@@ -0,0 +1,456 @@
+#include "BroadphaseAABBTree.h"
+#include "PhysicsEngine.h"
+
+static inline Vector3 MinVec(const Vector3& a, const Vector3& b)
+{
+	return Vector3(min(a.x, b.x), min(a.y, b.y), min(a.z, b.z));
+}
+
+static inline Vector3 MaxVec(const Vector3& a, const Vector3& b)
+{
+	return Vector3(max(a.x, b.x), max(a.y, b.y), max(a.z, b.z));
+}
+
+//Surface area of a box, used as the cost of a node when inserting
+static inline float SurfaceArea(const Vector3& aabbMin, const Vector3& aabbMax)
+{
+	Vector3 d = aabbMax - aabbMin;
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static inline bool Overlaps(const AABBTreeNode& a, const AABBTreeNode& b)
+{
+	return a.aabbMin.x <= b.aabbMax.x && a.aabbMax.x >= b.aabbMin.x
+		&& a.aabbMin.y <= b.aabbMax.y && a.aabbMax.y >= b.aabbMin.y
+		&& a.aabbMin.z <= b.aabbMax.z && a.aabbMax.z >= b.aabbMin.z;
+}
+
+BroadphaseAABBTree::BroadphaseAABBTree()
+	: root(AABBTREE_NULL_NODE)
+	, freeList(AABBTREE_NULL_NODE)
+	, numProxies(0)
+	, numReinserts(0)
+{
+}
+
+BroadphaseAABBTree::~BroadphaseAABBTree()
+{
+	Clear();
+}
+
+int BroadphaseAABBTree::AllocateNode()
+{
+	int idx;
+	if (freeList != AABBTREE_NULL_NODE)
+	{
+		idx = freeList;
+		freeList = nodes[idx].parent;
+	}
+	else
+	{
+		idx = (int)nodes.size();
+		nodes.push_back(AABBTreeNode());
+	}
+
+	AABBTreeNode& node = nodes[idx];
+	node.pnode = NULL;
+	node.parent = AABBTREE_NULL_NODE;
+	node.child1 = AABBTREE_NULL_NODE;
+	node.child2 = AABBTREE_NULL_NODE;
+	node.height = 0;
+	return idx;
+}
+
+void BroadphaseAABBTree::FreeNode(int idx)
+{
+	nodes[idx].parent = freeList;
+	nodes[idx].pnode = NULL;
+	nodes[idx].height = -1;
+	freeList = idx;
+}
+
+void BroadphaseAABBTree::AddNode(PhysicsNode* pnode)
+{
+	int leaf = AllocateNode();
+
+	Vector3 r = Vector3(1.0f, 1.0f, 1.0f) * (pnode->GetBoundingRadius() + AABBTREE_FAT_MARGIN);
+	nodes[leaf].aabbMin = pnode->GetPosition() - r;
+	nodes[leaf].aabbMax = pnode->GetPosition() + r;
+	nodes[leaf].pnode = pnode;
+
+	InsertLeaf(leaf);
+	pnode->SetBroadphaseProxy(leaf);
+	++numProxies;
+}
+
+void BroadphaseAABBTree::RemoveNode(PhysicsNode* pnode)
+{
+	int leaf = pnode->GetBroadphaseProxy();
+	if (leaf == AABBTREE_NULL_NODE)
+		return;
+
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	pnode->SetBroadphaseProxy(AABBTREE_NULL_NODE);
+	--numProxies;
+}
+
+void BroadphaseAABBTree::Clear()
+{
+	for (AABBTreeNode& node : nodes)
+	{
+		if (node.height == 0 && node.pnode)
+			node.pnode->SetBroadphaseProxy(AABBTREE_NULL_NODE);
+	}
+
+	nodes.clear();
+	pairStack.clear();
+	root = AABBTREE_NULL_NODE;
+	freeList = AABBTREE_NULL_NODE;
+	numProxies = 0;
+	numReinserts = 0;
+}
+
+void BroadphaseAABBTree::Update(float dt)
+{
+	numReinserts = 0;
+
+	//Leaves never change index when reinserted, so it is safe to walk the pool
+	// directly even though internal nodes get freed/allocated along the way
+	for (int i = 0; i < (int)nodes.size(); ++i)
+	{
+		if (nodes[i].height != 0 || nodes[i].pnode == NULL)
+			continue;
+
+		PhysicsNode* pnode = nodes[i].pnode;
+		const Vector3& pos = pnode->GetPosition();
+		float radius = pnode->GetBoundingRadius();
+		Vector3 tightMin = pos - Vector3(radius, radius, radius);
+		Vector3 tightMax = pos + Vector3(radius, radius, radius);
+
+		//Still inside the fat AABB, nothing to do
+		const AABBTreeNode& leaf = nodes[i];
+		if (tightMin.x >= leaf.aabbMin.x && tightMin.y >= leaf.aabbMin.y && tightMin.z >= leaf.aabbMin.z
+			&& tightMax.x <= leaf.aabbMax.x && tightMax.y <= leaf.aabbMax.y && tightMax.z <= leaf.aabbMax.z)
+			continue;
+
+		RemoveLeaf(i);
+
+		//Predict where the node is heading and stretch the box that way
+		Vector3 margin = Vector3(AABBTREE_FAT_MARGIN, AABBTREE_FAT_MARGIN, AABBTREE_FAT_MARGIN);
+		Vector3 displacement = pnode->GetLinearVelocity() * dt * AABBTREE_VELOCITY_SCALE;
+		nodes[i].aabbMin = tightMin - margin + MinVec(displacement, Vector3(0.0f, 0.0f, 0.0f));
+		nodes[i].aabbMax = tightMax + margin + MaxVec(displacement, Vector3(0.0f, 0.0f, 0.0f));
+
+		InsertLeaf(i);
+		++numReinserts;
+	}
+}
+
+void BroadphaseAABBTree::InsertLeaf(int leaf)
+{
+	if (root == AABBTREE_NULL_NODE)
+	{
+		root = leaf;
+		nodes[root].parent = AABBTREE_NULL_NODE;
+		return;
+	}
+
+	//Find the best sibling, stepping down into whichever child is cheapest
+	// until it is cheaper to just pair up with the current node
+	Vector3 leafMin = nodes[leaf].aabbMin;
+	Vector3 leafMax = nodes[leaf].aabbMax;
+	int idx = root;
+	while (!nodes[idx].IsLeaf())
+	{
+		const AABBTreeNode& node = nodes[idx];
+		int child1 = node.child1;
+		int child2 = node.child2;
+
+		float area = SurfaceArea(node.aabbMin, node.aabbMax);
+		float combinedArea = SurfaceArea(MinVec(node.aabbMin, leafMin), MaxVec(node.aabbMax, leafMax));
+
+		//Cost of creating a new parent here
+		float cost = 2.0f * combinedArea;
+
+		//Minimum cost pushed down to the children by growing this node
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { child1, child2 };
+		for (int c = 0; c < 2; ++c)
+		{
+			const AABBTreeNode& child = nodes[children[c]];
+			float newArea = SurfaceArea(MinVec(child.aabbMin, leafMin), MaxVec(child.aabbMax, leafMax));
+			if (child.IsLeaf())
+				childCost[c] = newArea + inheritanceCost;
+			else
+				childCost[c] = (newArea - SurfaceArea(child.aabbMin, child.aabbMax)) + inheritanceCost;
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		idx = (childCost[0] < childCost[1]) ? child1 : child2;
+	}
+
+	int sibling = idx;
+
+	//Create a new parent for the sibling and the leaf
+	int newParent = AllocateNode();
+	int oldParent = nodes[sibling].parent;
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].aabbMin = MinVec(nodes[sibling].aabbMin, leafMin);
+	nodes[newParent].aabbMax = MaxVec(nodes[sibling].aabbMax, leafMax);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent != AABBTREE_NULL_NODE)
+	{
+		if (nodes[oldParent].child1 == sibling)
+			nodes[oldParent].child1 = newParent;
+		else
+			nodes[oldParent].child2 = newParent;
+	}
+	else
+	{
+		root = newParent;
+	}
+
+	Refit(nodes[leaf].parent);
+}
+
+void BroadphaseAABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = AABBTREE_NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+	//The sibling takes the place of the parent
+	if (grandParent != AABBTREE_NULL_NODE)
+	{
+		if (nodes[grandParent].child1 == parent)
+			nodes[grandParent].child1 = sibling;
+		else
+			nodes[grandParent].child2 = sibling;
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		Refit(grandParent);
+	}
+	else
+	{
+		root = sibling;
+		nodes[sibling].parent = AABBTREE_NULL_NODE;
+		FreeNode(parent);
+	}
+}
+
+void BroadphaseAABBTree::Refit(int idx)
+{
+	while (idx != AABBTREE_NULL_NODE)
+	{
+		idx = Balance(idx);
+
+		AABBTreeNode& node = nodes[idx];
+		const AABBTreeNode& child1 = nodes[node.child1];
+		const AABBTreeNode& child2 = nodes[node.child2];
+
+		node.height = 1 + max(child1.height, child2.height);
+		node.aabbMin = MinVec(child1.aabbMin, child2.aabbMin);
+		node.aabbMax = MaxVec(child1.aabbMax, child2.aabbMax);
+
+		idx = node.parent;
+	}
+}
+
+int BroadphaseAABBTree::Balance(int iA)
+{
+	AABBTreeNode& A = nodes[iA];
+	if (A.IsLeaf() || A.height < 2)
+		return iA;
+
+	int iB = A.child1;
+	int iC = A.child2;
+	AABBTreeNode& B = nodes[iB];
+	AABBTreeNode& C = nodes[iC];
+
+	int balance = C.height - B.height;
+
+	//Right side is too deep, rotate C up to replace A
+	if (balance > 1)
+	{
+		int iF = C.child1;
+		int iG = C.child2;
+		AABBTreeNode& F = nodes[iF];
+		AABBTreeNode& G = nodes[iG];
+
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		if (C.parent != AABBTREE_NULL_NODE)
+		{
+			if (nodes[C.parent].child1 == iA)
+				nodes[C.parent].child1 = iC;
+			else
+				nodes[C.parent].child2 = iC;
+		}
+		else
+		{
+			root = iC;
+		}
+
+		//Keep the taller of C's children up with C, and hand the other to A
+		if (F.height > G.height)
+		{
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.aabbMin = MinVec(B.aabbMin, G.aabbMin);
+			A.aabbMax = MaxVec(B.aabbMax, G.aabbMax);
+			C.aabbMin = MinVec(A.aabbMin, F.aabbMin);
+			C.aabbMax = MaxVec(A.aabbMax, F.aabbMax);
+			A.height = 1 + max(B.height, G.height);
+			C.height = 1 + max(A.height, F.height);
+		}
+		else
+		{
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.aabbMin = MinVec(B.aabbMin, F.aabbMin);
+			A.aabbMax = MaxVec(B.aabbMax, F.aabbMax);
+			C.aabbMin = MinVec(A.aabbMin, G.aabbMin);
+			C.aabbMax = MaxVec(A.aabbMax, G.aabbMax);
+			A.height = 1 + max(B.height, F.height);
+			C.height = 1 + max(A.height, G.height);
+		}
+
+		return iC;
+	}
+
+	//Left side is too deep, rotate B up to replace A
+	if (balance < -1)
+	{
+		int iD = B.child1;
+		int iE = B.child2;
+		AABBTreeNode& D = nodes[iD];
+		AABBTreeNode& E = nodes[iE];
+
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		if (B.parent != AABBTREE_NULL_NODE)
+		{
+			if (nodes[B.parent].child1 == iA)
+				nodes[B.parent].child1 = iB;
+			else
+				nodes[B.parent].child2 = iB;
+		}
+		else
+		{
+			root = iB;
+		}
+
+		if (D.height > E.height)
+		{
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.aabbMin = MinVec(C.aabbMin, E.aabbMin);
+			A.aabbMax = MaxVec(C.aabbMax, E.aabbMax);
+			B.aabbMin = MinVec(A.aabbMin, D.aabbMin);
+			B.aabbMax = MaxVec(A.aabbMax, D.aabbMax);
+			A.height = 1 + max(C.height, E.height);
+			B.height = 1 + max(A.height, D.height);
+		}
+		else
+		{
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.aabbMin = MinVec(C.aabbMin, D.aabbMin);
+			A.aabbMax = MaxVec(C.aabbMax, D.aabbMax);
+			B.aabbMin = MinVec(A.aabbMin, E.aabbMin);
+			B.aabbMax = MaxVec(A.aabbMax, E.aabbMax);
+			A.height = 1 + max(C.height, D.height);
+			B.height = 1 + max(A.height, E.height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+void BroadphaseAABBTree::GenColPairs(std::vector<CollisionPair>& out_pairs)
+{
+	if (root == AABBTREE_NULL_NODE || nodes[root].IsLeaf())
+		return;
+
+	//Stack of node pairs still to be tested, a node paired with
+	// itself means test all the leaves below it against each other
+	pairStack.clear();
+	pairStack.push_back(root);
+	pairStack.push_back(root);
+
+	while (pairStack.size() > 0)
+	{
+		int iB = pairStack.back(); pairStack.pop_back();
+		int iA = pairStack.back(); pairStack.pop_back();
+
+		const AABBTreeNode& a = nodes[iA];
+		const AABBTreeNode& b = nodes[iB];
+
+		if (iA == iB)
+		{
+			if (a.IsLeaf())
+				continue;
+
+			pairStack.push_back(a.child1); pairStack.push_back(a.child1);
+			pairStack.push_back(a.child2); pairStack.push_back(a.child2);
+			pairStack.push_back(a.child1); pairStack.push_back(a.child2);
+			continue;
+		}
+
+		if (!Overlaps(a, b))
+			continue;
+
+		if (a.IsLeaf() && b.IsLeaf())
+		{
+			//Check they both atleast have collision shapes
+			if (a.pnode->GetCollisionShape() != NULL
+				&& b.pnode->GetCollisionShape() != NULL)
+			{
+				CollisionPair cp;
+				cp.pObjectA = a.pnode;
+				cp.pObjectB = b.pnode;
+				out_pairs.push_back(cp);
+			}
+		}
+		else if (b.IsLeaf() || (!a.IsLeaf() && SurfaceArea(a.aabbMin, a.aabbMax) > SurfaceArea(b.aabbMin, b.aabbMax)))
+		{
+			//Split the larger of the two nodes
+			int c1 = a.child1, c2 = a.child2;
+			pairStack.push_back(c1); pairStack.push_back(iB);
+			pairStack.push_back(c2); pairStack.push_back(iB);
+		}
+		else
+		{
+			int c1 = b.child1, c2 = b.child2;
+			pairStack.push_back(iA); pairStack.push_back(c1);
+			pairStack.push_back(iA); pairStack.push_back(c2);
+		}
+	}
+}
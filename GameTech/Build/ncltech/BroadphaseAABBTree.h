@@ -0,0 +1,102 @@
+/******************************************************************************
+Class: BroadphaseAABBTree
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Dynamic bounding volume hierarchy broadphase. Every physics node added to the
+	engine owns a leaf in a binary tree of axis aligned bounding boxes, where each
+	internal node encloses both of its children. Unlike the octree there is no
+	fixed world size, the tree just grows to fit whatever is inserted.
+
+	To stop every tiny movement from having to restructure the tree, the leaves
+	store a 'fat' AABB, which is the node's real bounds expanded by a margin and
+	the distance it is expected to move. Only once an object leaves its fat AABB
+	is it removed and reinserted.
+
+	Leaves are inserted next to the sibling that increases the total surface area
+	of the tree the least, and on the way back up the tree any node whose children
+	have become unbalanced is rotated, keeping the height close to log(n).
+
+	Collision pairs are found by descending the tree against itself, only
+	splitting the larger of two nodes when their boxes overlap.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PhysicsNode.h"
+#include <vector>
+
+struct CollisionPair;
+
+#define AABBTREE_NULL_NODE		-1
+
+//Distance the leaf AABBs are expanded by in every direction
+#define AABBTREE_FAT_MARGIN		0.1f
+
+//Multiplier of the distance moved in one step that the fat AABBs
+// are also stretched by in the direction of travel
+#define AABBTREE_VELOCITY_SCALE	2.0f
+
+struct AABBTreeNode
+{
+	Vector3			aabbMin;
+	Vector3			aabbMax;
+	PhysicsNode*	pnode;		//Only set for leaves
+	int				parent;		//Doubles as the next free node when in the free list
+	int				child1;
+	int				child2;
+	int				height;		//0 for leaves, -1 for free nodes
+
+	inline bool IsLeaf() const { return child1 == AABBTREE_NULL_NODE; }
+};
+
+class BroadphaseAABBTree
+{
+public:
+	BroadphaseAABBTree();
+	~BroadphaseAABBTree();
+
+	//Creates a leaf for the node and stores its id in the node's broadphase proxy
+	void AddNode(PhysicsNode* pnode);
+	void RemoveNode(PhysicsNode* pnode);
+	void Clear();
+
+	// Reinserts any leaf whose node has left its fat AABB
+	void Update(float dt);
+
+	// Descends the tree against itself and appends all overlapping leaf pairs
+	void GenColPairs(std::vector<CollisionPair>& out_pairs);
+
+	inline size_t GetNumProxies() const		{ return numProxies; }
+	inline int GetHeight() const			{ return root == AABBTREE_NULL_NODE ? 0 : nodes[root].height; }
+
+	// Number of leaves that had to be reinserted in the last update
+	inline uint GetNumReinserts() const		{ return numReinserts; }
+
+protected:
+	int AllocateNode();
+	void FreeNode(int idx);
+
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+
+	// Rotates the children of the given node if they are unbalanced,
+	// returns the index of the node now at the same position in the tree
+	int Balance(int idx);
+
+	// Walks up from the given node refitting bounds/heights and rebalancing
+	void Refit(int idx);
+
+protected:
+	std::vector<AABBTreeNode>	nodes;
+	int							root;
+	int							freeList;
+
+	std::vector<int>			pairStack;
+
+	size_t	numProxies;
+	uint	numReinserts;
+};
@@ -0,0 +1,299 @@
+#include "BroadphaseOctree.h"
+#include "PhysicsEngine.h"
+#include <nclgl/NCLDebug.h>
+#include <algorithm>
+#include <cfloat>
+
+//Spreads the bottom 10 bits of v out so there are two zero bits between each
+static inline uint SpreadBits(uint v)
+{
+	v &= 0x000003ff;
+	v = (v | (v << 16)) & 0xff0000ff;
+	v = (v | (v << 8)) & 0x0300f00f;
+	v = (v | (v << 4)) & 0x030c30c3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+//Inverse of SpreadBits
+static inline uint CompactBits(uint v)
+{
+	v &= 0x09249249;
+	v = (v | (v >> 2)) & 0x030c30c3;
+	v = (v | (v >> 4)) & 0x0300f00f;
+	v = (v | (v >> 8)) & 0xff0000ff;
+	v = (v | (v >> 16)) & 0x000003ff;
+	return v;
+}
+
+static inline uint MortonEncode(uint x, uint y, uint z)
+{
+	return SpreadBits(x) | (SpreadBits(y) << 1) | (SpreadBits(z) << 2);
+}
+
+//Checks the AABBs built from the nodes' bounding radii overlap
+static inline bool BoundsOverlap(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
+{
+	Vector3 ab = pnodeB->GetPosition() - pnodeA->GetPosition();
+	float r = pnodeA->GetBoundingRadius() + pnodeB->GetBoundingRadius();
+	return fabs(ab.x) <= r && fabs(ab.y) <= r && fabs(ab.z) <= r;
+}
+
+static inline void AddPair(PhysicsNode* pnodeA, PhysicsNode* pnodeB, std::vector<CollisionPair>& out_pairs)
+{
+	if (BoundsOverlap(pnodeA, pnodeB))
+	{
+		CollisionPair cp;
+		cp.pObjectA = pnodeA;
+		cp.pObjectB = pnodeB;
+		out_pairs.push_back(cp);
+	}
+}
+
+BroadphaseOctree::BroadphaseOctree()
+	: maxObjects(OCTREE_MAX_OBJECTS)
+	, minOctantSize(OCTREE_MIN_OCTANT_SIZE)
+	, rootMin(0.0f, 0.0f, 0.0f)
+	, rootSize(1.0f)
+	, maxDepth(0)
+	, treeDepth(0)
+{
+}
+
+BroadphaseOctree::~BroadphaseOctree()
+{
+	Clear();
+}
+
+void BroadphaseOctree::Clear()
+{
+	entries.clear();
+	sortedNodes.clear();
+	nodes.clear();
+	parentStack.clear();
+	treeDepth = 0;
+}
+
+void BroadphaseOctree::Update(const std::vector<PhysicsNode*>& pnodes)
+{
+	Clear();
+
+	//1. Fit the root to the extents of everything with a collision shape
+	Vector3 sceneMin(FLT_MAX, FLT_MAX, FLT_MAX);
+	Vector3 sceneMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (PhysicsNode* pnode : pnodes)
+	{
+		if (pnode->GetCollisionShape() == NULL)
+			continue;
+
+		Vector3 r = Vector3(1.0f, 1.0f, 1.0f) * pnode->GetBoundingRadius();
+		Vector3 lo = pnode->GetPosition() - r;
+		Vector3 hi = pnode->GetPosition() + r;
+		sceneMin = Vector3(min(sceneMin.x, lo.x), min(sceneMin.y, lo.y), min(sceneMin.z, lo.z));
+		sceneMax = Vector3(max(sceneMax.x, hi.x), max(sceneMax.y, hi.y), max(sceneMax.z, hi.z));
+
+		SortEntry entry;
+		entry.pnode = pnode;
+		entries.push_back(entry);
+	}
+
+	if (entries.size() == 0)
+		return;
+
+	//Octants are cubes, so use the largest dimension (plus a little so nothing
+	// sits exactly on the far boundary)
+	Vector3 extents = sceneMax - sceneMin;
+	rootSize = max(max(extents.x, extents.y), max(extents.z, minOctantSize)) * 1.01f;
+	rootMin = (sceneMin + sceneMax) * 0.5f - Vector3(1.0f, 1.0f, 1.0f) * (rootSize * 0.5f);
+
+	maxDepth = 0;
+	while (maxDepth < OCTREE_MAX_DEPTH && rootSize / (float)(1 << (maxDepth + 1)) >= minOctantSize)
+		++maxDepth;
+
+	//2. Find the deepest octant containing each node's AABB, any octal digits
+	//   where the codes of the two corners differ are levels the node straddles
+	const int numCells = 1 << maxDepth;
+	const float invCellSize = (float)numCells / rootSize;
+	for (SortEntry& entry : entries)
+	{
+		Vector3 rel = entry.pnode->GetPosition() - rootMin;
+		float r = entry.pnode->GetBoundingRadius();
+		float lo[3] = { rel.x - r, rel.y - r, rel.z - r };
+		float hi[3] = { rel.x + r, rel.y + r, rel.z + r };
+
+		uint cellLo[3], cellHi[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			cellLo[i] = (uint)min(max((int)(lo[i] * invCellSize), 0), numCells - 1);
+			cellHi[i] = (uint)min(max((int)(hi[i] * invCellSize), 0), numCells - 1);
+		}
+
+		uint codeLo = MortonEncode(cellLo[0], cellLo[1], cellLo[2]);
+		uint codeHi = MortonEncode(cellHi[0], cellHi[1], cellHi[2]);
+
+		uint levelsUp = 0;
+		for (uint diff = codeLo ^ codeHi; diff != 0; diff >>= 3)
+			++levelsUp;
+
+		entry.depth = maxDepth - levelsUp;
+		entry.key = (codeLo >> (3 * levelsUp)) << (3 * levelsUp);
+	}
+
+	//3. Sort by code. Nodes that stop at an octant share the padded key of its
+	//   first child, so the depth tie break puts them at the front of its range
+	std::sort(entries.begin(), entries.end(), [](const SortEntry& a, const SortEntry& b)
+	{
+		return a.key < b.key || (a.key == b.key && a.depth < b.depth);
+	});
+
+	sortedNodes.resize(entries.size());
+	for (size_t i = 0; i < entries.size(); ++i)
+		sortedNodes[i] = entries[i].pnode;
+
+	//4. Build the tree down from the root
+	OctreeNode rootNode;
+	rootNode.code = 1;
+	rootNode.depth = 0;
+	rootNode.start = 0;
+	rootNode.numOwn = 0;
+	rootNode.end = (uint)entries.size();
+	rootNode.firstChild = OCTREE_NULL_NODE;
+	nodes.push_back(rootNode);
+
+	BuildNode(0);
+}
+
+void BroadphaseOctree::BuildNode(int idx)
+{
+	//Copied out as the pool may be reallocated when the children are added
+	OctreeNode node = nodes[idx];
+	treeDepth = max(treeDepth, node.depth);
+
+	if (node.end - node.start <= maxObjects || node.depth >= maxDepth)
+	{
+		nodes[idx].numOwn = node.end - node.start;
+		return;
+	}
+
+	//Nodes straddling this octant's children are at the front of the range
+	uint i = node.start;
+	while (i < node.end && entries[i].depth == node.depth)
+		++i;
+	nodes[idx].numOwn = i - node.start;
+
+	int firstChild = (int)nodes.size();
+	nodes[idx].firstChild = firstChild;
+
+	//Children's ranges follow on from each other in octant order
+	const uint shift = 3 * (maxDepth - node.depth - 1);
+	for (uint c = 0; c < 8; ++c)
+	{
+		OctreeNode child;
+		child.code = (node.code << 3) | c;
+		child.depth = node.depth + 1;
+		child.start = i;
+		while (i < node.end && ((entries[i].key >> shift) & 7) == c)
+			++i;
+		child.end = i;
+		child.numOwn = 0;
+		child.firstChild = OCTREE_NULL_NODE;
+		nodes.push_back(child);
+	}
+
+	for (int c = 0; c < 8; ++c)
+	{
+		if (nodes[firstChild + c].end > nodes[firstChild + c].start)
+			BuildNode(firstChild + c);
+	}
+}
+
+void BroadphaseOctree::GenColPairs(std::vector<CollisionPair>& out_pairs)
+{
+	if (nodes.size() == 0)
+		return;
+
+	//Reserved up front so the spans into it stay valid as it grows
+	parentStack.clear();
+	parentStack.reserve(sortedNodes.size());
+
+	PnodeSpan noParents = { NULL, 0 };
+	GenNodePairs(0, noParents, out_pairs);
+}
+
+void BroadphaseOctree::GenNodePairs(int idx, PnodeSpan parents, std::vector<CollisionPair>& out_pairs)
+{
+	const OctreeNode& node = nodes[idx];
+	PhysicsNode* const* own = &sortedNodes[node.start];
+
+	for (uint i = 0; i < node.numOwn; ++i)
+	{
+		for (uint j = i + 1; j < node.numOwn; ++j)
+			AddPair(own[i], own[j], out_pairs);
+
+		for (size_t k = 0; k < parents.size; ++k)
+			AddPair(own[i], parents.data[k], out_pairs);
+	}
+
+	if (node.IsLeaf())
+		return;
+
+	size_t numParents = parentStack.size();
+	parentStack.insert(parentStack.end(), own, own + node.numOwn);
+
+	PnodeSpan childParents = { parentStack.data(), parentStack.size() };
+	const int firstChild = node.firstChild;
+	for (int c = 0; c < 8; ++c)
+	{
+		const OctreeNode& child = nodes[firstChild + c];
+		if (child.end > child.start)
+			GenNodePairs(firstChild + c, childParents, out_pairs);
+	}
+
+	parentStack.resize(numParents);
+}
+
+void BroadphaseOctree::GetOctantBounds(uint code, uint depth, Vector3& out_min, float& out_size) const
+{
+	//Strip the depth marker, then pad out to the maximum depth
+	uint morton = (code ^ (1u << (3 * depth))) << (3 * (maxDepth - depth));
+	float cellSize = rootSize / (float)(1 << maxDepth);
+
+	out_size = rootSize / (float)(1 << depth);
+	out_min = rootMin + Vector3(
+		(float)CompactBits(morton),
+		(float)CompactBits(morton >> 1),
+		(float)CompactBits(morton >> 2)) * cellSize;
+}
+
+void BroadphaseOctree::DebugDraw()
+{
+	const Vector4 colour(0.0f, 0.5f, 1.0f, 1.0f);
+
+	for (const OctreeNode& node : nodes)
+	{
+		if (node.end == node.start)
+			continue;
+
+		Vector3 lo;
+		float size;
+		GetOctantBounds(node.code, node.depth, lo, size);
+
+		//All 12 edges of the octant, drawn as 3 from each of 4 corners
+		Vector3 corners[4] = {
+			lo,
+			lo + Vector3(size, size, 0.0f),
+			lo + Vector3(size, 0.0f, size),
+			lo + Vector3(0.0f, size, size)
+		};
+		for (int i = 0; i < 4; ++i)
+		{
+			const Vector3& c = corners[i];
+			float sx = (c.x > lo.x) ? -size : size;
+			float sy = (c.y > lo.y) ? -size : size;
+			float sz = (c.z > lo.z) ? -size : size;
+			NCLDebug::DrawHairLineNDT(c, c + Vector3(sx, 0.0f, 0.0f), colour);
+			NCLDebug::DrawHairLineNDT(c, c + Vector3(0.0f, sy, 0.0f), colour);
+			NCLDebug::DrawHairLineNDT(c, c + Vector3(0.0f, 0.0f, sz), colour);
+		}
+	}
+}
@@ -0,0 +1,125 @@
+/******************************************************************************
+Class: BroadphaseOctree
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Linear octree broadphase. Replaces the old heap allocated Octree structs,
+	which were created and deleted as nodes moved around and copied the list of
+	parent objects at every level of the pair generation.
+
+	Every octant is identified by its Morton (z-order) location code, which is
+	the octant index at each level interleaved into one integer with a leading 1
+	bit marking the depth. The tree is rebuilt from scratch each step:
+		1: The root bounds are fitted to the extents of the scene
+		2: Each node gets the code of the deepest octant that fully contains it,
+		   which is just the common prefix of the codes of its min/max corners
+		3: The nodes are sorted by code, so every octant's nodes (and all of the
+		   nodes of its children) end up in one contiguous range
+		4: Starting at the root, any octant holding more than maxObjects is
+		   split, with its 8 children allocated next to each other in the node
+		   pool so child i is just firstChild + i
+
+	Pair generation walks down the tree keeping a stack of the nodes in all of
+	the parent octants, which is passed down as a span rather than copied.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PhysicsNode.h"
+#include <vector>
+
+struct CollisionPair;
+
+#define OCTREE_NULL_NODE		-1
+
+//Deepest the tree can go, 3 bits per level + the depth marker has to fit in a uint
+#define OCTREE_MAX_DEPTH		10
+
+//Default number of nodes an octant can hold before it is split
+#define OCTREE_MAX_OBJECTS		5
+
+//Default width below which octants won't be split any further
+#define OCTREE_MIN_OCTANT_SIZE	2.0f
+
+struct OctreeNode
+{
+	uint	code;			//Morton location code, with a leading 1 bit above the top level
+	uint	depth;
+	uint	start;			//First sorted node in this octant (or any of its children)
+	uint	numOwn;			//Number of sorted nodes from start that belong to this octant itself
+	uint	end;			//One past the last sorted node in this octant or its children
+	int		firstChild;		//Index of the first of 8 consecutive children in the pool
+
+	inline bool IsLeaf() const { return firstChild == OCTREE_NULL_NODE; }
+};
+
+//Non-owning view of a contiguous run of physics nodes
+struct PnodeSpan
+{
+	PhysicsNode* const*	data;
+	size_t				size;
+};
+
+class BroadphaseOctree
+{
+public:
+	BroadphaseOctree();
+	~BroadphaseOctree();
+
+	void Clear();
+
+	// Refits the root to the scene and rebuilds the tree from scratch
+	void Update(const std::vector<PhysicsNode*>& pnodes);
+
+	// Appends all pairs of nodes whose AABBs overlap
+	void GenColPairs(std::vector<CollisionPair>& out_pairs);
+
+	// Draws the bounds of all the octants that contain anything
+	void DebugDraw();
+
+	inline uint GetMaxObjects() const				{ return maxObjects; }
+	inline void SetMaxObjects(uint num)				{ maxObjects = max(num, 1u); }
+
+	inline float GetMinOctantSize() const			{ return minOctantSize; }
+	inline void SetMinOctantSize(float size)		{ minOctantSize = size; }
+
+	inline const Vector3& GetRootMin() const		{ return rootMin; }
+	inline float GetRootSize() const				{ return rootSize; }
+
+	inline size_t GetNumOctants() const				{ return nodes.size(); }
+	inline uint GetDepth() const					{ return treeDepth; }
+
+protected:
+	// Splits the given octant if it holds too many nodes, then builds its children
+	void BuildNode(int idx);
+
+	void GenNodePairs(int idx, PnodeSpan parents, std::vector<CollisionPair>& out_pairs);
+
+	// World space bounds of the octant with the given location code
+	void GetOctantBounds(uint code, uint depth, Vector3& out_min, float& out_size) const;
+
+protected:
+	struct SortEntry
+	{
+		uint			key;		//Location code padded out to the maximum depth
+		uint			depth;
+		PhysicsNode*	pnode;
+	};
+
+	uint	maxObjects;
+	float	minOctantSize;
+
+	Vector3	rootMin;
+	float	rootSize;
+	uint	maxDepth;		//Depth the codes are computed at this step
+	uint	treeDepth;		//Deepest octant actually created
+
+	std::vector<SortEntry>		entries;
+	std::vector<PhysicsNode*>	sortedNodes;
+	std::vector<OctreeNode>		nodes;
+
+	std::vector<PhysicsNode*>	parentStack;
+};
@@ -0,0 +1,235 @@
+#include "BroadphaseSAP.h"
+#include "PhysicsEngine.h"
+#include <algorithm>
+
+//If a large number of proxies have been added since the last update, the lists
+// are no longer nearly sorted and insertion sort would degrade to O(n^2)
+#define SAP_RESORT_THRESHOLD 64
+
+//Vector3 doesn't expose an index operator so pull the component out directly
+static inline float GetAxis(const Vector3& v, uint axis)
+{
+	return (&v.x)[axis];
+}
+
+//Ties put min endpoints first, so a proxy is always opened before it is closed
+// (even with a bounding radius of zero) and touching proxies still overlap
+static bool CompareEndpoints(const SAPEndpoint& a, const SAPEndpoint& b)
+{
+	if (a.value != b.value)
+		return a.value < b.value;
+	return !(a.proxy & SAP_MAX_FLAG) && (b.proxy & SAP_MAX_FLAG);
+}
+
+BroadphaseSAP::BroadphaseSAP()
+	: numActiveProxies(0)
+	, numAddedSinceSort(0)
+	, sweepAxis(0)
+	, numSwaps(0)
+{
+}
+
+BroadphaseSAP::~BroadphaseSAP()
+{
+	Clear();
+}
+
+void BroadphaseSAP::AddNode(PhysicsNode* pnode)
+{
+	uint idx;
+	if (freeProxies.size() > 0)
+	{
+		idx = freeProxies.back();
+		freeProxies.pop_back();
+	}
+	else
+	{
+		idx = proxies.size();
+		proxies.push_back(SAPProxy());
+	}
+
+	SAPProxy& proxy = proxies[idx];
+	proxy.pnode = pnode;
+	proxy.aabbMin = pnode->GetPosition() - Vector3(1.0f, 1.0f, 1.0f) * pnode->GetBoundingRadius();
+	proxy.aabbMax = pnode->GetPosition() + Vector3(1.0f, 1.0f, 1.0f) * pnode->GetBoundingRadius();
+	proxy.activeIdx = SAP_NULL_PROXY;
+	pnode->SetSAPProxy((int)idx);
+
+	for (uint axis = 0; axis < 3; ++axis)
+	{
+		SAPEndpoint epMin, epMax;
+		epMin.value = GetAxis(proxy.aabbMin, axis);
+		epMin.proxy = idx;
+		epMax.value = GetAxis(proxy.aabbMax, axis);
+		epMax.proxy = idx | SAP_MAX_FLAG;
+
+		//Appended to the end, they will be moved into place by the next Update()
+		endpoints[axis].push_back(epMin);
+		endpoints[axis].push_back(epMax);
+	}
+
+	++numActiveProxies;
+	++numAddedSinceSort;
+}
+
+void BroadphaseSAP::RemoveNode(PhysicsNode* pnode)
+{
+	if (pnode->GetSAPProxy() < 0)
+		return;
+
+	uint idx = (uint)pnode->GetSAPProxy();
+	pnode->SetSAPProxy(-1);
+
+	//Removing keeps the remaining endpoints in order, so no re-sort is needed
+	for (uint axis = 0; axis < 3; ++axis)
+	{
+		std::vector<SAPEndpoint>& list = endpoints[axis];
+		list.erase(std::remove_if(list.begin(), list.end(),
+			[idx](const SAPEndpoint& ep) { return (ep.proxy & ~SAP_MAX_FLAG) == idx; }),
+			list.end());
+	}
+
+	proxies[idx].pnode = NULL;
+	freeProxies.push_back(idx);
+	--numActiveProxies;
+}
+
+void BroadphaseSAP::Clear()
+{
+	for (SAPProxy& proxy : proxies)
+	{
+		if (proxy.pnode)
+			proxy.pnode->SetSAPProxy(-1);
+	}
+	proxies.clear();
+	freeProxies.clear();
+	activeList.clear();
+	for (uint axis = 0; axis < 3; ++axis)
+		endpoints[axis].clear();
+
+	numActiveProxies = 0;
+	numAddedSinceSort = 0;
+	numSwaps = 0;
+}
+
+void BroadphaseSAP::Update()
+{
+	numSwaps = 0;
+
+	//Refresh proxy bounds and keep track of the spread of the proxy centres
+	Vector3 sum = Vector3(0.0f, 0.0f, 0.0f);
+	Vector3 sumSq = Vector3(0.0f, 0.0f, 0.0f);
+	for (SAPProxy& proxy : proxies)
+	{
+		if (proxy.pnode == NULL)
+			continue;
+
+		const Vector3& pos = proxy.pnode->GetPosition();
+		float radius = proxy.pnode->GetBoundingRadius();
+		proxy.aabbMin = pos - Vector3(radius, radius, radius);
+		proxy.aabbMax = pos + Vector3(radius, radius, radius);
+
+		sum = sum + pos;
+		sumSq = sumSq + pos * pos;
+	}
+
+	for (uint axis = 0; axis < 3; ++axis)
+	{
+		std::vector<SAPEndpoint>& list = endpoints[axis];
+		for (SAPEndpoint& ep : list)
+		{
+			const SAPProxy& proxy = proxies[ep.proxy & ~SAP_MAX_FLAG];
+			ep.value = (ep.proxy & SAP_MAX_FLAG)
+				? GetAxis(proxy.aabbMax, axis)
+				: GetAxis(proxy.aabbMin, axis);
+		}
+
+		if (numAddedSinceSort > SAP_RESORT_THRESHOLD)
+			std::sort(list.begin(), list.end(), CompareEndpoints);
+		else
+			InsertionSort(list);
+	}
+	numAddedSinceSort = 0;
+
+	//Sweep along the axis with the largest variance, as this is the one
+	// which will separate the most proxies and so keep the active list short
+	if (numActiveProxies > 0)
+	{
+		float invN = 1.0f / (float)numActiveProxies;
+		Vector3 mean = sum * invN;
+		Vector3 variance = sumSq * invN - mean * mean;
+
+		sweepAxis = 0;
+		if (variance.y > GetAxis(variance, sweepAxis)) sweepAxis = 1;
+		if (variance.z > GetAxis(variance, sweepAxis)) sweepAxis = 2;
+	}
+}
+
+void BroadphaseSAP::InsertionSort(std::vector<SAPEndpoint>& list)
+{
+	for (size_t i = 1; i < list.size(); ++i)
+	{
+		SAPEndpoint ep = list[i];
+		size_t j = i;
+		while (j > 0 && CompareEndpoints(ep, list[j - 1]))
+		{
+			list[j] = list[j - 1];
+			--j;
+			++numSwaps;
+		}
+		list[j] = ep;
+	}
+}
+
+void BroadphaseSAP::GenColPairs(std::vector<CollisionPair>& out_pairs)
+{
+	const uint axis1 = (sweepAxis + 1) % 3;
+	const uint axis2 = (sweepAxis + 2) % 3;
+
+	activeList.clear();
+	for (const SAPEndpoint& ep : endpoints[sweepAxis])
+	{
+		uint idx = ep.proxy & ~SAP_MAX_FLAG;
+		SAPProxy& proxy = proxies[idx];
+
+		//Nodes without a collision shape can't collide, so never open them
+		if (proxy.pnode->GetCollisionShape() == NULL)
+			continue;
+
+		if (ep.proxy & SAP_MAX_FLAG)
+		{
+			//Never opened, nothing to close
+			if (proxy.activeIdx == SAP_NULL_PROXY)
+				continue;
+
+			//Swap-remove from the active list
+			uint last = activeList.back();
+			activeList[proxy.activeIdx] = last;
+			proxies[last].activeIdx = proxy.activeIdx;
+			activeList.pop_back();
+			proxy.activeIdx = SAP_NULL_PROXY;
+		}
+		else
+		{
+			//Overlaps every open proxy along the sweep axis, test the other two
+			for (uint other : activeList)
+			{
+				const SAPProxy& oproxy = proxies[other];
+
+				if (GetAxis(proxy.aabbMin, axis1) <= GetAxis(oproxy.aabbMax, axis1)
+					&& GetAxis(proxy.aabbMax, axis1) >= GetAxis(oproxy.aabbMin, axis1)
+					&& GetAxis(proxy.aabbMin, axis2) <= GetAxis(oproxy.aabbMax, axis2)
+					&& GetAxis(proxy.aabbMax, axis2) >= GetAxis(oproxy.aabbMin, axis2))
+				{
+					CollisionPair cp;
+					cp.pObjectA = oproxy.pnode;
+					cp.pObjectB = proxy.pnode;
+					out_pairs.push_back(cp);
+				}
+			}
+
+			proxy.activeIdx = activeList.size();
+			activeList.push_back(idx);
+		}
+	}
+}
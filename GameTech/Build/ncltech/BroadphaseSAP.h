@@ -0,0 +1,86 @@
+/******************************************************************************
+Class: BroadphaseSAP
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Sweep and prune broadphase. Every physics node added to the engine owns a
+	proxy, which is an axis aligned bounding box built from the node's position
+	and bounding radius. For each of the three world axes the min/max ends of
+	all proxies are kept in a sorted endpoint list.
+
+	The lists are kept between physics steps, as from one frame to the next objects
+	barely move, the lists are already almost sorted. This means a simple insertion
+	sort is close to O(n) each frame (frame coherence) instead of the O(n log n)
+	of sorting from scratch.
+
+	Collision pairs are then found by sweeping along whichever axis currently
+	has the largest spread of objects:
+		- Hitting a min endpoint means the proxy is now 'open' and overlaps every
+		  other open proxy along this axis, so just the other two axes need checking
+		- Hitting a max endpoint closes the proxy again
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PhysicsNode.h"
+#include <vector>
+
+struct CollisionPair;
+
+struct SAPEndpoint
+{
+	float	value;
+	uint	proxy;		//Proxy index, with the top bit set if this is a max endpoint
+};
+
+struct SAPProxy
+{
+	PhysicsNode*	pnode;
+	Vector3			aabbMin;
+	Vector3			aabbMax;
+	uint			activeIdx;	//Index in the active list whilst sweeping
+};
+
+#define SAP_MAX_FLAG	0x80000000u
+#define SAP_NULL_PROXY	0xFFFFFFFFu
+
+class BroadphaseSAP
+{
+public:
+	BroadphaseSAP();
+	~BroadphaseSAP();
+
+	void AddNode(PhysicsNode* pnode);
+	void RemoveNode(PhysicsNode* pnode);
+	void Clear();
+
+	// Refreshes all proxy bounds and incrementally re-sorts the endpoint lists
+	void Update();
+
+	// Sweeps along the best axis and appends all overlapping pairs
+	void GenColPairs(std::vector<CollisionPair>& out_pairs);
+
+	inline size_t GetNumProxies() const		{ return numActiveProxies; }
+	inline uint GetSweepAxis() const		{ return sweepAxis; }
+
+	// Number of endpoint swaps performed in the last update, useful to see how
+	// well frame coherence is holding up
+	inline uint GetNumSwaps() const			{ return numSwaps; }
+
+protected:
+	void InsertionSort(std::vector<SAPEndpoint>& endpoints);
+
+protected:
+	std::vector<SAPProxy>		proxies;
+	std::vector<uint>			freeProxies;
+	std::vector<SAPEndpoint>	endpoints[3];
+	std::vector<uint>			activeList;
+
+	size_t	numActiveProxies;
+	size_t	numAddedSinceSort;
+	uint	sweepAxis;
+	uint	numSwaps;
+};
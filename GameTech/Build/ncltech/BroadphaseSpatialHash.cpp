@@ -0,0 +1,222 @@
+#include "BroadphaseSpatialHash.h"
+#include "PhysicsEngine.h"
+#include <omp.h>
+#include <cstring>
+
+//Checks the AABBs built from the nodes' bounding radii overlap
+static inline bool BoundsOverlap(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
+{
+	Vector3 ab = pnodeB->GetPosition() - pnodeA->GetPosition();
+	float r = pnodeA->GetBoundingRadius() + pnodeB->GetBoundingRadius();
+	return fabs(ab.x) <= r && fabs(ab.y) <= r && fabs(ab.z) <= r;
+}
+
+BroadphaseSpatialHash::BroadphaseSpatialHash()
+	: numThreads(max(omp_get_max_threads(), 1))
+{
+	SetCellSize(SPATIALHASH_CELL_SIZE);
+
+	threadCounts.resize(numThreads * SPATIALHASH_TABLE_SIZE);
+	cellStart.resize(SPATIALHASH_TABLE_SIZE + 1);
+	threadPairs.resize(numThreads);
+}
+
+BroadphaseSpatialHash::~BroadphaseSpatialHash()
+{
+	Clear();
+}
+
+void BroadphaseSpatialHash::Clear()
+{
+	gridNodes.clear();
+	cellHashes.clear();
+	largeNodes.clear();
+	sortedNodes.clear();
+	for (std::vector<CollisionPair>& pairs : threadPairs)
+		pairs.clear();
+}
+
+void BroadphaseSpatialHash::GetCell(const Vector3& pos, int* cell) const
+{
+	//Floor rather than truncate, otherwise the cells either side of zero
+	// would be twice as wide as all the others
+	cell[0] = (int)floor(pos.x * invCellSize);
+	cell[1] = (int)floor(pos.y * invCellSize);
+	cell[2] = (int)floor(pos.z * invCellSize);
+}
+
+uint BroadphaseSpatialHash::GetCellHash(int x, int y, int z) const
+{
+	//Large primes to scatter neighbouring cells across the table, the world
+	// is unbounded so this replaces the bitwise modulus of the CUDA version
+	uint h = ((uint)x * 73856093u) ^ ((uint)y * 19349663u) ^ ((uint)z * 83492791u);
+	return h & (SPATIALHASH_TABLE_SIZE - 1);
+}
+
+void BroadphaseSpatialHash::Update(const std::vector<PhysicsNode*>& pnodes)
+{
+	gridNodes.clear();
+	largeNodes.clear();
+
+	//Split off anything too large to fit in a single cell
+	for (PhysicsNode* pnode : pnodes)
+	{
+		if (pnode->GetCollisionShape() == NULL)
+			continue;
+
+		if (pnode->GetBoundingRadius() * 2.0f > cellSize)
+			largeNodes.push_back(pnode);
+		else
+			gridNodes.push_back(pnode);
+	}
+
+	const int numNodes = (int)gridNodes.size();
+	cellHashes.resize(numNodes);
+	sortedNodes.resize(numNodes);
+
+	//1. Compute the cell hash of each node and count them, each thread
+	//   working on its own contiguous chunk of the node list
+#pragma omp parallel for schedule(static)
+	for (int t = 0; t < numThreads; ++t)
+	{
+		uint* counts = &threadCounts[t * SPATIALHASH_TABLE_SIZE];
+		memset(counts, 0, SPATIALHASH_TABLE_SIZE * sizeof(uint));
+
+		int start = numNodes * t / numThreads;
+		int end = numNodes * (t + 1) / numThreads;
+		for (int i = start; i < end; ++i)
+		{
+			int cell[3];
+			GetCell(gridNodes[i]->GetPosition(), cell);
+			uint hash = GetCellHash(cell[0], cell[1], cell[2]);
+			cellHashes[i] = hash;
+			++counts[hash];
+		}
+	}
+
+	//2. Prefix sum the counts in (cell, thread) order, turning them into the
+	//   index each thread starts writing that cell's nodes to
+	uint sum = 0;
+	for (uint h = 0; h < SPATIALHASH_TABLE_SIZE; ++h)
+	{
+		cellStart[h] = sum;
+		for (int t = 0; t < numThreads; ++t)
+		{
+			uint& count = threadCounts[t * SPATIALHASH_TABLE_SIZE + h];
+			uint tmp = count;
+			count = sum;
+			sum += tmp;
+		}
+	}
+	cellStart[SPATIALHASH_TABLE_SIZE] = sum;
+
+	//3. Scatter the nodes into their sorted positions
+#pragma omp parallel for schedule(static)
+	for (int t = 0; t < numThreads; ++t)
+	{
+		uint* offsets = &threadCounts[t * SPATIALHASH_TABLE_SIZE];
+
+		int start = numNodes * t / numThreads;
+		int end = numNodes * (t + 1) / numThreads;
+		for (int i = start; i < end; ++i)
+		{
+			uint dst = offsets[cellHashes[i]]++;
+			sortedNodes[dst] = gridNodes[i];
+		}
+	}
+}
+
+void BroadphaseSpatialHash::GenGridPairs(uint start, uint end, std::vector<CollisionPair>& out_pairs)
+{
+	for (uint i = start; i < end; ++i)
+	{
+		PhysicsNode* pnodeA = sortedNodes[i];
+
+		int cell[3];
+		GetCell(pnodeA->GetPosition(), cell);
+
+		//Neighbouring cells can hash to the same bucket, so keep track of
+		// the buckets already checked to stop pairs being generated twice
+		uint checked[27];
+		uint numChecked = 0;
+
+		for (int z = -1; z <= 1; ++z)
+		{
+			for (int x = -1; x <= 1; ++x)
+			{
+				for (int y = -1; y <= 1; ++y)
+				{
+					uint hash = GetCellHash(cell[0] + x, cell[1] + y, cell[2] + z);
+
+					bool duplicate = false;
+					for (uint k = 0; k < numChecked && !duplicate; ++k)
+						duplicate = (checked[k] == hash);
+					if (duplicate)
+						continue;
+					checked[numChecked++] = hash;
+
+					//Only pair with nodes after this one in the sorted list, the
+					// earlier nodes have already found their pair with this one
+					uint j = max(cellStart[hash], i + 1);
+					uint cellEnd = cellStart[hash + 1];
+					for (; j < cellEnd; ++j)
+					{
+						PhysicsNode* pnodeB = sortedNodes[j];
+
+						//Also filters out nodes from distant cells that share the bucket
+						if (BoundsOverlap(pnodeA, pnodeB))
+						{
+							CollisionPair cp;
+							cp.pObjectA = pnodeA;
+							cp.pObjectB = pnodeB;
+							out_pairs.push_back(cp);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void BroadphaseSpatialHash::GenColPairs(std::vector<CollisionPair>& out_pairs)
+{
+	//4. Each thread generates the pairs for its own chunk of the sorted nodes
+	const int numNodes = (int)sortedNodes.size();
+#pragma omp parallel for schedule(static)
+	for (int t = 0; t < numThreads; ++t)
+	{
+		threadPairs[t].clear();
+		GenGridPairs(numNodes * t / numThreads, numNodes * (t + 1) / numThreads, threadPairs[t]);
+	}
+
+	for (std::vector<CollisionPair>& pairs : threadPairs)
+		out_pairs.insert(out_pairs.end(), pairs.begin(), pairs.end());
+
+	//Large nodes aren't in the grid, so test them against everything
+	for (size_t i = 0; i < largeNodes.size(); ++i)
+	{
+		PhysicsNode* pnodeA = largeNodes[i];
+
+		for (size_t j = i + 1; j < largeNodes.size(); ++j)
+		{
+			if (BoundsOverlap(pnodeA, largeNodes[j]))
+			{
+				CollisionPair cp;
+				cp.pObjectA = pnodeA;
+				cp.pObjectB = largeNodes[j];
+				out_pairs.push_back(cp);
+			}
+		}
+
+		for (PhysicsNode* pnodeB : sortedNodes)
+		{
+			if (BoundsOverlap(pnodeA, pnodeB))
+			{
+				CollisionPair cp;
+				cp.pObjectA = pnodeA;
+				cp.pObjectB = pnodeB;
+				out_pairs.push_back(cp);
+			}
+		}
+	}
+}
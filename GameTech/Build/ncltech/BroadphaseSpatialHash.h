@@ -0,0 +1,86 @@
+/******************************************************************************
+Class: BroadphaseSpatialHash
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	CPU version of the bucket sort broadphase used by the CUDA particle example
+	(Examples_Cuda/CudaCollidingParticles.cu). Rather than a fixed 3D grid the
+	world is split into an infinite grid of cells, which are hashed down into a
+	fixed size table, so there are no world bounds to fall out of.
+
+	Each update:
+		1: For each node, compute the hash of the cell its centre is in
+		2: Counting sort the nodes by cell hash. Each thread counts its own
+		   share of the nodes, the counts are prefix summed into the start
+		   index of every (cell, thread) and then each thread scatters its nodes
+		3: The prefix sums are the per-cell ranges, so cellStart[h] to
+		   cellStart[h+1] are all the nodes that hashed to cell h
+		4: Every node checks the 27 cells around (and including) its own cell,
+		   only keeping pairs with nodes later in the sorted list so each pair
+		   is only found once
+
+	As with the CUDA version, this only works if no node is bigger than a cell.
+	Anything too large for the grid (walls, floors etc) goes into a separate list
+	and is tested against everything with a plain AABB check.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "PhysicsNode.h"
+#include <vector>
+
+struct CollisionPair;
+
+//Number of buckets in the hash table (must be a power of two)
+#define SPATIALHASH_TABLE_SIZE	4096
+
+//Default cell width, just large enough for the biggest balls in the ball pool
+#define SPATIALHASH_CELL_SIZE	1.5f
+
+class BroadphaseSpatialHash
+{
+public:
+	BroadphaseSpatialHash();
+	~BroadphaseSpatialHash();
+
+	void Clear();
+
+	// Sorts the given nodes into the grid, rebuilt from scratch each step
+	void Update(const std::vector<PhysicsNode*>& pnodes);
+
+	// Appends all pairs of nodes in neighbouring cells whose AABBs overlap
+	void GenColPairs(std::vector<CollisionPair>& out_pairs);
+
+	// Any node with a bounding diameter larger than this goes into the large node list
+	inline float GetCellSize() const		{ return cellSize; }
+	inline void SetCellSize(float size)		{ cellSize = size; invCellSize = 1.0f / size; }
+
+	inline size_t GetNumGridNodes() const	{ return sortedNodes.size(); }
+	inline size_t GetNumLargeNodes() const	{ return largeNodes.size(); }
+
+protected:
+	void GetCell(const Vector3& pos, int* cell) const;
+	uint GetCellHash(int x, int y, int z) const;
+
+	// Finds all pairs for the sorted nodes in [start, end) and appends them to out_pairs
+	void GenGridPairs(uint start, uint end, std::vector<CollisionPair>& out_pairs);
+
+protected:
+	float	cellSize;
+	float	invCellSize;
+	int		numThreads;
+
+	std::vector<PhysicsNode*>	gridNodes;		//Nodes small enough for the grid, in engine order
+	std::vector<uint>			cellHashes;		//Cell hash of each grid node
+	std::vector<PhysicsNode*>	largeNodes;
+
+	std::vector<uint>			threadCounts;	//numThreads * SPATIALHASH_TABLE_SIZE counting sort histogram
+	std::vector<uint>			cellStart;		//SPATIALHASH_TABLE_SIZE + 1 entries
+
+	std::vector<PhysicsNode*>	sortedNodes;
+
+	std::vector<std::vector<CollisionPair>> threadPairs;
+};
@@ -0,0 +1,441 @@
+#include "CollisionDetectionGJK.h"
+#include <algorithm>
+#include <cfloat>
+
+//Iteration limits, GJK normally finishes in well under 10 and EPA in
+// under 20 for boxes (curved shapes take longer as every point is a vertex)
+#define GJK_MAX_ITERATIONS	32
+#define EPA_MAX_ITERATIONS	48
+
+//EPA stops once the polytope can't grow by more than this towards the closest face
+#define EPA_TOLERANCE		1e-4f
+
+CollisionDetectionGJK::CollisionDetectionGJK()
+	: pnodeA(NULL)
+	, pnodeB(NULL)
+	, cshapeA(NULL)
+	, cshapeB(NULL)
+	, pairCache(NULL)
+	, simplexSize(0)
+	, numIterations(0)
+	, numVertices(0)
+	, numFaces(0)
+	, numEdges(0)
+{
+}
+
+void CollisionDetectionGJK::BeginNewPair(
+	const PhysicsNode* objA,
+	const PhysicsNode* objB,
+	NarrowphaseCache* cache)
+{
+	pnodeA = objA;
+	pnodeB = objB;
+	cshapeA = objA->GetCollisionShape();
+	cshapeB = objB->GetCollisionShape();
+	pairCache = cache;
+	simplexSize = 0;
+	numIterations = 0;
+}
+
+CollisionDetectionGJK::SupportPoint CollisionDetectionGJK::GetSupport(const Vector3& dir) const
+{
+	SupportPoint s;
+	s.a = cshapeA->GetSupportPoint(dir);
+	s.b = cshapeB->GetSupportPoint(-dir);
+	s.p = s.a - s.b;
+	return s;
+}
+
+bool CollisionDetectionGJK::AreColliding(CollisionData* out_coldata)
+{
+	if (!cshapeA || !cshapeB)
+		return false;
+
+	//Start from last step's axis if there is one, otherwise from A towards B
+	Vector3 dir;
+	if (pairCache && pairCache->gjkValid)
+		dir = (pairCache->nodeA == pnodeA) ? pairCache->gjkDirection : -pairCache->gjkDirection;
+	else
+		dir = pnodeB->GetPosition() - pnodeA->GetPosition();
+
+	if (Vector3::Dot(dir, dir) < 1e-12f)
+		dir = Vector3(1.0f, 0.0f, 0.0f);
+
+	bool intersecting = false;
+	numIterations = 0;
+	simplexSize = 0;
+
+	while (numIterations < GJK_MAX_ITERATIONS)
+	{
+		++numIterations;
+
+		// If the furthest point along the search direction doesn't reach the origin,
+		// then the direction is a separating axis and the objects can't be colliding
+		SupportPoint s = GetSupport(dir);
+		if (Vector3::Dot(s.p, dir) < 0.0f)
+			break;
+
+		// Finding a point the simplex already has means it can't get any closer,
+		// and it reached the origin above, so the origin is (within rounding) on it
+		bool repeated = false;
+		for (int i = 0; i < simplexSize; ++i)
+		{
+			Vector3 diff = s.p - simplex[i].p;
+			repeated = repeated || (Vector3::Dot(diff, diff) < 1e-10f);
+		}
+		if (repeated)
+		{
+			intersecting = true;
+			break;
+		}
+
+		for (int i = simplexSize; i > 0; --i)
+			simplex[i] = simplex[i - 1];
+		simplex[0] = s;
+		++simplexSize;
+
+		if (simplexSize == 1)
+			dir = -s.p;
+		else if (DoSimplex(dir))
+		{
+			intersecting = true;
+			break;
+		}
+
+		// The origin is on the simplex itself (e.g. two spheres, where every point
+		// found lies on the line between their centres)
+		if (Vector3::Dot(dir, dir) < 1e-12f)
+		{
+			intersecting = true;
+			break;
+		}
+	}
+
+	CollisionData colData;
+	if (intersecting)
+		RunEPA(colData);
+
+	if (pairCache)
+	{
+		pairCache->nodeA = pnodeA;
+		pairCache->gjkDirection = intersecting ? colData._normal : dir.Normalise();
+		pairCache->gjkValid = (Vector3::Dot(pairCache->gjkDirection, pairCache->gjkDirection) > 0.5f);
+	}
+
+	if (!intersecting)
+		return false;
+
+	if (out_coldata) *out_coldata = colData;
+	return true;
+}
+
+bool CollisionDetectionGJK::DoSimplex(Vector3& dir)
+{
+	switch (simplexSize)
+	{
+	case 2:		return DoLine(dir);
+	case 3:		return DoTriangle(dir);
+	default:	return DoTetrahedron(dir);
+	}
+}
+
+bool CollisionDetectionGJK::DoLine(Vector3& dir)
+{
+	const Vector3& a = simplex[0].p;
+	Vector3 ab = simplex[1].p - a;
+	Vector3 ao = -a;
+
+	if (Vector3::Dot(ab, ao) > 0.0f)
+	{
+		dir = Vector3::Cross(Vector3::Cross(ab, ao), ab);
+	}
+	else
+	{
+		simplexSize = 1;
+		dir = ao;
+	}
+	return false;
+}
+
+bool CollisionDetectionGJK::DoTriangle(Vector3& dir)
+{
+	const Vector3 a = simplex[0].p;
+	Vector3 ab = simplex[1].p - a;
+	Vector3 ac = simplex[2].p - a;
+	Vector3 ao = -a;
+	Vector3 abc = Vector3::Cross(ab, ac);
+
+	if (Vector3::Dot(Vector3::Cross(abc, ac), ao) > 0.0f)
+	{
+		if (Vector3::Dot(ac, ao) > 0.0f)
+		{
+			//Closest to edge AC
+			simplex[1] = simplex[2];
+			simplexSize = 2;
+			dir = Vector3::Cross(Vector3::Cross(ac, ao), ac);
+			return false;
+		}
+
+		simplexSize = 2;
+		return DoLine(dir);
+	}
+
+	if (Vector3::Dot(Vector3::Cross(ab, abc), ao) > 0.0f)
+	{
+		simplexSize = 2;
+		return DoLine(dir);
+	}
+
+	//Above or below the triangle, wound so the origin is on the side of its normal
+	if (Vector3::Dot(abc, ao) > 0.0f)
+	{
+		dir = abc;
+	}
+	else
+	{
+		std::swap(simplex[1], simplex[2]);
+		dir = -abc;
+	}
+	return false;
+}
+
+//True if the origin is further than rounding error outside of a face, with
+// normal n, that has a vertex at -ao
+static inline bool OutsideFace(const Vector3& n, const Vector3& ao)
+{
+	return Vector3::Dot(n, ao) > 1e-6f * n.Length();
+}
+
+bool CollisionDetectionGJK::DoTetrahedron(Vector3& dir)
+{
+	const Vector3 a = simplex[0].p;
+	Vector3 ab = simplex[1].p - a;
+	Vector3 ac = simplex[2].p - a;
+	Vector3 ad = simplex[3].p - a;
+	Vector3 ao = -a;
+
+	//The origin can only be outside of the three faces that include the new point.
+	// One lying on a face counts as inside, otherwise it can flip between the two
+	// sides of it forever.
+	if (OutsideFace(Vector3::Cross(ab, ac), ao))
+	{
+		simplexSize = 3;
+		return DoTriangle(dir);
+	}
+
+	if (OutsideFace(Vector3::Cross(ac, ad), ao))
+	{
+		simplex[1] = simplex[2];
+		simplex[2] = simplex[3];
+		simplexSize = 3;
+		return DoTriangle(dir);
+	}
+
+	if (OutsideFace(Vector3::Cross(ad, ab), ao))
+	{
+		simplex[2] = simplex[1];
+		simplex[1] = simplex[3];
+		simplexSize = 3;
+		return DoTriangle(dir);
+	}
+
+	return true;
+}
+
+bool CollisionDetectionGJK::ExpandSimplex()
+{
+	static const Vector3 axes[3] = { Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f) };
+
+	while (simplexSize < 4)
+	{
+		//Search away from the simplex in a direction it doesn't cover yet
+		Vector3 dir;
+		if (simplexSize == 1)
+		{
+			dir = axes[0];
+		}
+		else if (simplexSize == 2)
+		{
+			Vector3 ab = simplex[1].p - simplex[0].p;
+			int smallest = (fabs(ab.x) < fabs(ab.y)) ? (fabs(ab.x) < fabs(ab.z) ? 0 : 2) : (fabs(ab.y) < fabs(ab.z) ? 1 : 2);
+			dir = Vector3::Cross(ab, axes[smallest]);
+		}
+		else
+		{
+			dir = Vector3::Cross(simplex[1].p - simplex[0].p, simplex[2].p - simplex[0].p);
+		}
+
+		//Either way will do, as long as it finds a point off the simplex
+		SupportPoint s = GetSupport(dir);
+		if (Vector3::Dot(s.p - simplex[0].p, dir) < 1e-6f * Vector3::Dot(dir, dir))
+			s = GetSupport(-dir);
+		if (fabs(Vector3::Dot(s.p - simplex[0].p, dir)) < 1e-6f * Vector3::Dot(dir, dir))
+			return false;
+
+		simplex[simplexSize++] = s;
+	}
+	return true;
+}
+
+bool CollisionDetectionGJK::AddFace(int v0, int v1, int v2)
+{
+	if (numFaces >= EPA_MAX_FACES)
+		return false;
+
+	const Vector3& a = epaVertices[v0].p;
+	Vector3 normal = Vector3::Cross(epaVertices[v1].p - a, epaVertices[v2].p - a);
+	float length = normal.Length();
+
+	//Zero area faces are kept to hold the polytope together, but never expanded
+	float distance = FLT_MAX;
+	if (length > 1e-12f)
+	{
+		normal = normal / length;
+		distance = Vector3::Dot(normal, a);
+	}
+
+	EPAFace& face = epaFaces[numFaces++];
+	face.v[0] = v0;
+	face.v[1] = v1;
+	face.v[2] = v2;
+	face.normal = normal;
+	face.distance = distance;
+	return true;
+}
+
+void CollisionDetectionGJK::AddHorizonEdge(int v0, int v1)
+{
+	//An edge shared with another removed face is inside the hole, not on its edge
+	for (int i = 0; i < numEdges; ++i)
+	{
+		if (epaEdges[i][0] == v1 && epaEdges[i][1] == v0)
+		{
+			--numEdges;
+			epaEdges[i][0] = epaEdges[numEdges][0];
+			epaEdges[i][1] = epaEdges[numEdges][1];
+			return;
+		}
+	}
+
+	if (numEdges < EPA_MAX_EDGES)
+	{
+		epaEdges[numEdges][0] = v0;
+		epaEdges[numEdges][1] = v1;
+		++numEdges;
+	}
+}
+
+void CollisionDetectionGJK::RunEPA(CollisionData& out_coldata)
+{
+	numFaces = 0;
+	if (simplexSize < 4 && !ExpandSimplex())
+	{
+		//Flat Minkowski difference, so the shapes can only be touching
+		out_coldata._normal = (pnodeB->GetPosition() - pnodeA->GetPosition()).Normalise();
+		out_coldata._penetration = 0.0f;
+		out_coldata._pointOnPlane = simplex[0].b;
+		return;
+	}
+
+	for (int i = 0; i < 4; ++i)
+		epaVertices[i] = simplex[i];
+	numVertices = 4;
+
+	//Wind the faces anticlockwise from outside. The origin can be on one of
+	// the faces, so it's the fourth vertex that decides which side is in.
+	Vector3 normal012 = Vector3::Cross(epaVertices[1].p - epaVertices[0].p, epaVertices[2].p - epaVertices[0].p);
+	if (Vector3::Dot(normal012, epaVertices[3].p - epaVertices[0].p) > 0.0f)
+		std::swap(epaVertices[1], epaVertices[2]);
+
+	// New faces are always wound the same way as the faces they replace
+	AddFace(0, 1, 2);
+	AddFace(0, 3, 1);
+	AddFace(0, 2, 3);
+	AddFace(1, 3, 2);
+
+	for (int iteration = 0; iteration < EPA_MAX_ITERATIONS; ++iteration)
+	{
+		int closest = 0;
+		for (int i = 1; i < numFaces; ++i)
+		{
+			if (epaFaces[i].distance < epaFaces[closest].distance)
+				closest = i;
+		}
+
+		// Stop once the closest face is on the surface of the Minkowski difference
+		const Vector3 normal = epaFaces[closest].normal;
+		SupportPoint s = GetSupport(normal);
+		if (Vector3::Dot(s.p, normal) - epaFaces[closest].distance < EPA_TOLERANCE
+			|| numVertices >= EPA_MAX_VERTICES)
+			break;
+
+		int newVertex = numVertices++;
+		epaVertices[newVertex] = s;
+
+		// Remove every face that can see the new point, and fill the hole with
+		// new faces from its edges to the point
+		numEdges = 0;
+		for (int i = numFaces - 1; i >= 0; --i)
+		{
+			EPAFace& face = epaFaces[i];
+			if (Vector3::Dot(face.normal, s.p - epaVertices[face.v[0]].p) > 0.0f)
+			{
+				AddHorizonEdge(face.v[0], face.v[1]);
+				AddHorizonEdge(face.v[1], face.v[2]);
+				AddHorizonEdge(face.v[2], face.v[0]);
+				face = epaFaces[--numFaces];
+			}
+		}
+
+		for (int i = 0; i < numEdges; ++i)
+			AddFace(epaEdges[i][0], epaEdges[i][1], newVertex);
+
+		if (numFaces == 0)
+			break;
+	}
+
+	if (numFaces == 0)
+	{
+		//Degenerate polytope, fall back on the last simplex's closest point
+		out_coldata._normal = (pnodeB->GetPosition() - pnodeA->GetPosition()).Normalise();
+		out_coldata._penetration = 0.0f;
+		out_coldata._pointOnPlane = simplex[0].b;
+		return;
+	}
+
+	int closest = 0;
+	for (int i = 1; i < numFaces; ++i)
+	{
+		if (epaFaces[i].distance < epaFaces[closest].distance)
+			closest = i;
+	}
+	const EPAFace& face = epaFaces[closest];
+
+	// Barycentric coordinates of the origin projected onto the closest face,
+	// giving the matching point on each shape
+	const SupportPoint& s0 = epaVertices[face.v[0]];
+	const SupportPoint& s1 = epaVertices[face.v[1]];
+	const SupportPoint& s2 = epaVertices[face.v[2]];
+
+	Vector3 point = face.normal * face.distance;
+	Vector3 v0 = s1.p - s0.p, v1 = s2.p - s0.p, v2 = point - s0.p;
+	float d00 = Vector3::Dot(v0, v0);
+	float d01 = Vector3::Dot(v0, v1);
+	float d11 = Vector3::Dot(v1, v1);
+	float d20 = Vector3::Dot(v2, v0);
+	float d21 = Vector3::Dot(v2, v1);
+	float denom = d00 * d11 - d01 * d01;
+
+	float u = 1.0f, v = 0.0f, w = 0.0f;
+	if (fabs(denom) > 1e-12f)
+	{
+		v = (d11 * d20 - d01 * d21) / denom;
+		w = (d00 * d21 - d01 * d20) / denom;
+		u = 1.0f - v - w;
+	}
+
+	out_coldata._normal = face.normal;
+	out_coldata._penetration = -face.distance;
+	out_coldata._pointOnPlane = s0.b * u + s1.b * v + s2.b * w;
+}
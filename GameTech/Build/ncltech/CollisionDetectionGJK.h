@@ -0,0 +1,110 @@
+/******************************************************************************
+Class: CollisionDetectionGJK
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Gilbert-Johnson-Keerthi intersection test between two convex collision shapes,
+	with the Expanding Polytope Algorithm to find the penetration depth of those
+	that do intersect.
+
+	Both only need the furthest point of each shape along a direction
+	(CollisionShape::GetSupportPoint), so unlike SAT the cost doesn't grow with
+	the number of faces and edges of the shapes.
+
+	GJK searches the Minkowski difference of the two shapes (A - B) for the
+	origin, which is inside it only if the shapes overlap. Every direction the
+	search looks in is a candidate separating axis, and the last one tried is
+	kept in the pair's NarrowphaseCache. Two objects that were apart last step are
+	usually still apart along the same axis, so they are ruled out again by the
+	first support point.
+
+	If they do overlap, EPA grows GJK's final simplex outwards until it reaches
+	the face of the Minkowski difference closest to the origin, which gives the
+	collision normal and depth. The polytope is held in fixed size arrays, so
+	neither stage touches the heap.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionDetectionSAT.h"
+
+//Size limits of the EPA polytope, if it reaches these the closest face found so far is used
+#define EPA_MAX_VERTICES	64
+#define EPA_MAX_FACES		128
+#define EPA_MAX_EDGES		64
+
+class CollisionDetectionGJK
+{
+public:
+	CollisionDetectionGJK();
+
+	//Start processing new (possible) collision pair
+	// - cache can be NULL, in which case the search starts from scratch
+	void BeginNewPair(
+		const PhysicsNode* objA,
+		const PhysicsNode* objB,
+		NarrowphaseCache* cache);
+
+	// GJK, followed by EPA if they are intersecting
+	// - Returns true if the objects are colliding or false otherwise
+	bool AreColliding(CollisionData* out_coldata = NULL);
+
+	// Number of GJK iterations taken by the last AreColliding
+	inline int NumIterations() const { return numIterations; }
+
+protected:
+	struct SupportPoint
+	{
+		Vector3 p;		//Point on the Minkowski difference (a - b)
+		Vector3 a;		//Points on each shape it came from
+		Vector3 b;
+	};
+
+	struct EPAFace
+	{
+		int		v[3];
+		Vector3	normal;
+		float	distance;	//Of the face's plane from the origin
+	};
+
+	SupportPoint GetSupport(const Vector3& dir) const;
+
+	//Updates the simplex to the feature closest to the origin, and the search
+	// direction to point towards the origin from it. Returns true if the simplex
+	// contains the origin.
+	bool DoSimplex(Vector3& dir);
+	bool DoLine(Vector3& dir);
+	bool DoTriangle(Vector3& dir);
+	bool DoTetrahedron(Vector3& dir);
+
+	//Grows a simplex that already touches the origin into a tetrahedron for EPA
+	bool ExpandSimplex();
+
+	//Adds a face to the EPA polytope, facing out if wound anticlockwise
+	bool AddFace(int v0, int v1, int v2);
+	void AddHorizonEdge(int v0, int v1);
+
+	//Expands GJK's final simplex to find the collision normal and depth
+	void RunEPA(CollisionData& out_coldata);
+
+private:
+	const PhysicsNode*		pnodeA;
+	const PhysicsNode*		pnodeB;
+	const CollisionShape*	cshapeA;
+	const CollisionShape*	cshapeB;
+	NarrowphaseCache*		pairCache;
+
+	//Simplex, newest point first
+	SupportPoint			simplex[4];
+	int						simplexSize;
+	int						numIterations;
+
+	//EPA polytope
+	SupportPoint			epaVertices[EPA_MAX_VERTICES];
+	EPAFace					epaFaces[EPA_MAX_FACES];
+	int						epaEdges[EPA_MAX_EDGES][2];
+	int						numVertices, numFaces, numEdges;
+};
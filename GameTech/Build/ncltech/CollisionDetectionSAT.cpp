@@ -1,10 +1,14 @@
 #include "CollisionDetectionSAT.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 #include "GeometryUtils.h"
+#include <cfloat>
 
 using namespace GeometryUtils;
 
 CollisionDetectionSAT::CollisionDetectionSAT()
+	: pairCache(NULL)
+	, numCachedAxisTests(0)
+	, numCachedAxisHits(0)
 {
 }
 
@@ -20,6 +24,7 @@ void CollisionDetectionSAT::BeginNewPair(
 	pnodeB = obj2;
 	cshapeA = obj1->GetCollisionShape();
 	cshapeB = obj2->GetCollisionShape();
+	pairCache = NULL;
 
 	areColliding = false;
 }
@@ -32,11 +37,29 @@ bool CollisionDetectionSAT::AreColliding(CollisionData* out_coldata)
 	areColliding = false;
 	possibleColAxes.clear();
 
+	CollisionData cur_colData;
+
+	//<------ CACHED AXIS --------->
+
+	// Objects that were apart last step are normally still apart along the
+	// same axis, in which case none of the others need to be built
+	if (pairCache && pairCache->satValid)
+	{
+		++numCachedAxisTests;
+		Vector3 axis = (pairCache->nodeA == pnodeA) ? pairCache->satAxis : -pairCache->satAxis;
+		if (!CheckCollisionAxis(axis, cur_colData))
+		{
+			++numCachedAxisHits;
+			return false;
+		}
+	}
+
 	//<------ DEFALT AXES --------->
 
 	// GetCollisionAxes takes in the /other/ object as a parameter here
 
-	std::vector<Vector3> axes1, axes2;
+	axes1.clear();
+	axes2.clear();
 
 	cshapeA->GetCollisionAxes(pnodeB, axes1);
  	for (const Vector3& axis : axes1)
@@ -58,12 +81,17 @@ bool CollisionDetectionSAT::AreColliding(CollisionData* out_coldata)
 	// is the same as testing the normals as each normal /will/ match
 	// a given edge elsewhere on the object.
 	
-	// For more complicated geometry, this will have to be changed to
-	// actual edge vectors instead of normals.
+	// More complicated geometry (e.g. ConvexHullCollisionShape) gives
+	// its actual edge vectors instead.
+
+	edges1.clear();
+	edges2.clear();
+	const std::vector<Vector3>& dirs1 = cshapeA->GetEdgeDirections(edges1) ? edges1 : axes1;
+	const std::vector<Vector3>& dirs2 = cshapeB->GetEdgeDirections(edges2) ? edges2 : axes2;
 
-	for (const Vector3& norm1 : axes1)
+	for (const Vector3& norm1 : dirs1)
 	{
-		for (const Vector3& norm2 : axes2)
+		for (const Vector3& norm2 : dirs2)
 		{
 			AddPossibleCollisionAxis(Vector3::Cross(norm1, norm2).Normalise());
 		}
@@ -75,8 +103,6 @@ bool CollisionDetectionSAT::AreColliding(CollisionData* out_coldata)
 	// either return false, or return the best axis (one with the
 	// least penetration) found.
 
-	CollisionData cur_colData;
-
 	bestColData._penetration = -FLT_MAX;
 	for (const Vector3& axis : possibleColAxes)
 	{
@@ -85,18 +111,40 @@ bool CollisionDetectionSAT::AreColliding(CollisionData* out_coldata)
 		// the two objects do not intersect
 
 		if (!CheckCollisionAxis(axis, cur_colData))
+		{
+			CacheAxis(axis);
 			return false;
+		}
 
 		if (cur_colData._penetration >= bestColData._penetration)
 			bestColData = cur_colData;
 	}
 
+	// The axis of least penetration is the one they are most likely to come apart along
+	CacheAxis(bestColData._normal);
+
 	if (out_coldata) *out_coldata = bestColData;
 
 	areColliding = true;
 	return true;
 }
 
+void CollisionDetectionSAT::CacheAxis(const Vector3& axis)
+{
+	if (!pairCache)
+		return;
+
+	pairCache->nodeA = pnodeA;
+	pairCache->satAxis = axis;
+	pairCache->satValid = true;
+}
+
+void CollisionDetectionSAT::SetCollisionData(const CollisionData& coldata)
+{
+	bestColData = coldata;
+	areColliding = true;
+}
+
 bool CollisionDetectionSAT::CheckCollisionAxis(const Vector3& axis, CollisionData& out_coldata)
 {
 	//Overlap Test
@@ -123,8 +171,13 @@ bool CollisionDetectionSAT::CheckCollisionAxis(const Vector3& axis, CollisionDat
 	float C = Vector3::Dot(axis, min2);
 	float D = Vector3::Dot(axis, max2);
 
+	if (B < C || D < A)
+		return false;
+
 	// Overlap Test (Order: Object 1 -> Object 2)
-	if (A <= C && B >= C)
+	// - If one is inside the other along the axis (e.g. anything resting on a
+	//   flat triangle) neither order fits, so they're pushed the shortest way out
+	if (B - C <= D - A)
 	{
 		out_coldata._normal = axis;
 		out_coldata._penetration = C - B;
@@ -136,20 +189,15 @@ bool CollisionDetectionSAT::CheckCollisionAxis(const Vector3& axis, CollisionDat
 	}
 
 	// Overlap Test (Order: Object 2 -> Object 1)
-	if (C <= A && D >= A)
-	{
-		out_coldata._normal = -axis;
-		// Invert axis here so we can do all our resolution phase as
-		// Object 1 -> Object 2
-		out_coldata._penetration = A - D;
-		// Smallest overlap distance is between D->A
-		// Compute closest point on edge of the object
-		out_coldata._pointOnPlane = min1 + out_coldata._normal * out_coldata._penetration;
-
-		return true;
-	}
+	out_coldata._normal = -axis;
+	// Invert axis here so we can do all our resolution phase as
+	// Object 1 -> Object 2
+	out_coldata._penetration = A - D;
+	// Smallest overlap distance is between D->A
+	// Compute closest point on edge of the object
+	out_coldata._pointOnPlane = min1 + out_coldata._normal * out_coldata._penetration;
 
-	return false;
+	return true;
 }
 
 void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
@@ -163,33 +211,41 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 
 	// Get the required face information for the two shapes around the collision normal
 
-	std::list<Vector3> polygon1, polygon2;
+	// - Everything here lives in fixed size buffers on the stack, so building
+	//   the manifold never touches the heap
+
+	Vector3 polyBuffer1[MAX_POLYGON_VERTICES], polyBuffer2[MAX_POLYGON_VERTICES];
+	Plane planeBuffer1[MAX_CLIP_PLANES], planeBuffer2[MAX_CLIP_PLANES];
+	OutputSpan<Vector3> polygon1(polyBuffer1, MAX_POLYGON_VERTICES), polygon2(polyBuffer2, MAX_POLYGON_VERTICES);
+	OutputSpan<Plane> adjPlanes1(planeBuffer1, MAX_CLIP_PLANES), adjPlanes2(planeBuffer2, MAX_CLIP_PLANES);
 	Vector3 normal1, normal2;
-	std::vector<Plane> adjPlanes1, adjPlanes2;
 
 	cshapeA->GetIncidentReferencePolygon(bestColData._normal, polygon1, normal1, adjPlanes1);
 
 	cshapeB->GetIncidentReferencePolygon(-bestColData._normal, polygon2, normal2, adjPlanes2);
 
+	if (polygon1.overflowed || polygon2.overflowed || adjPlanes1.overflowed || adjPlanes2.overflowed)
+		NCLERROR("CollisionDetectionSAT: Face has more than %d vertices, contacts will be wrong", MAX_CLIP_PLANES);
+
 	// If either shape1 or shape2 returned a single point, then it must be on a curve and thus
 	// the only contact point to generate is already available
 
-	if (polygon1.size() == 0 || polygon2.size() == 0)
+	if (polygon1.empty() || polygon2.empty())
 		return;
-	else if (polygon1.size() == 1)
+	else if (polygon1.size == 1)
 	{
 		out_manifold->AddContact(
-			polygon1.front(), //Polygon1->Polygon2
-			polygon1.front() + bestColData._normal *
+			polygon1.data[0], //Polygon1->Polygon2
+			polygon1.data[0] + bestColData._normal *
 			bestColData._penetration, bestColData._normal,
 			bestColData._penetration);
 	}
-	else if (polygon2.size() == 1)
+	else if (polygon2.size == 1)
 	{
 		out_manifold->AddContact(
-			polygon2.front() - bestColData._normal *
+			polygon2.data[0] - bestColData._normal *
 			bestColData._penetration,
-			polygon2.front(), //Polygon2->Polygon1
+			polygon2.data[0], //Polygon2->Polygon1
 			bestColData._normal,
 			bestColData._penetration);
 	}
@@ -210,23 +266,25 @@ void CollisionDetectionSAT::GenContactPoints(Manifold* out_manifold)
 			std::swap(adjPlanes1, adjPlanes2);
 		}
 
-		// Clip the incident face to the adjacent edges of the reference face
+		// Clip the incident face to the adjacent edges of the reference face, in place
 
-		if (adjPlanes1.size() > 0)
-			SutherlandHodgmanClipping(polygon2, adjPlanes1.size(), &adjPlanes1[0], &polygon2, false);
+		Vector3 scratch[MAX_POLYGON_VERTICES];
+		int numPoints = SutherlandHodgmanClipping(polygon2.data, polygon2.size, adjPlanes1.size, adjPlanes1.data, scratch, false);
 
 		// Finally clip (And remove) any contact points that are above the reference face
 
-		Plane refPlane = Plane(-normal1, -Vector3::Dot(-normal1, polygon1.front()));
-		SutherlandHodgmanClipping(polygon2, 1, &refPlane, &polygon2, true);
+		Plane refPlane = Plane(-normal1, -Vector3::Dot(-normal1, polygon1.data[0]));
+		numPoints = SutherlandHodgmanClipping(polygon2.data, numPoints, 1, &refPlane, scratch, true);
 
 		// Now we are left witha selection of valid contact points to be used for the manifold
 
-		for (const Vector3& point : polygon2)
+		for (int i = 0; i < numPoints; ++i)
 		{
+			const Vector3& point = polygon2.data[i];
+
 			// Compute distance to reference plane
 
-			Vector3 pointDiff = point - GetClosestPointPolygon(point, polygon1);
+			Vector3 pointDiff = point - GetClosestPointPolygon(point, polygon1.data, polygon1.size);
 			float contact_penetration = Vector3::Dot(pointDiff, bestColData._normal);
 
 			// Set contact data
@@ -12,6 +12,11 @@ Description:
 	As part of Tutorial 4/5 we will be covering this in detail and building it 
 	up ourselves. 
 
+	If given the pair's NarrowphaseCache, the axis that separated them (or the
+	one they overlapped least on) last step is tested before anything else, and
+	most pairs that aren't touching are ruled out by it without building any of
+	the other axes.
+
 	The additional functionality provided here are geometric functions used in the 
 	aforementioned tutorials to perform collision detection. I will try and detail
 	them below:
@@ -51,6 +56,17 @@ struct CollisionData
 	Vector3		_pointOnPlane;
 };
 
+//Narrowphase state kept between steps for one pair of objects
+struct NarrowphaseCache
+{
+	const PhysicsNode*	nodeA;			//Node that was A when this was written, so it can be flipped if the pair swaps
+	Vector3				gjkDirection;	//Last separating axis (or collision normal) from GJK/EPA
+	bool				gjkValid;
+	Vector3				satAxis;		//Last separating axis (or axis of least penetration) from SAT
+	bool				satValid;
+	uint				lastUsedStep;
+};
+
 class CollisionDetectionSAT
 {
 public:
@@ -64,10 +80,24 @@ public:
 		CollisionShape* shapeA,
 		CollisionShape* shapeB);
 
+	// Axis kept from the last time this pair was tested, which is tried before
+	// any others and then replaced (NULL to always do the full search)
+	inline void SetPairCache(NarrowphaseCache* cache) { pairCache = cache; }
+
 	// Seperating-Axis-Theorem
 	// - Returns true if the objects are colliding or false otherwise
 	bool AreColliding(CollisionData* out_coldata = NULL);
 
+	// Number of pairs that had a cached axis to try, and how many of those it
+	// separated (skipping the full search), since the counters were last reset
+	inline uint NumCachedAxisTests() const	{ return numCachedAxisTests; }
+	inline uint NumCachedAxisHits() const	{ return numCachedAxisHits; }
+	inline void ResetCacheCounters()		{ numCachedAxisTests = 0; numCachedAxisHits = 0; }
+
+	// Skips the axis search, using a collision found by some other test
+	// - Lets GenContactPoints build the manifold for it
+	void SetCollisionData(const CollisionData& coldata);
+
 	// Clipping Method
 	// - Uses clipping to construct a manifold describing the surface area
 	//   of the collision region
@@ -82,6 +112,9 @@ protected:
 	// This will evaluate the given axis working out if the the two objects
 	// are indeed colliding in this direction.
 	bool CheckCollisionAxis(const Vector3& axis, CollisionData& coldata);
+
+	//Stores the axis in the pair's cache (if it has one) to be tried first next step
+	void CacheAxis(const Vector3& axis);
 	
 private:
 	//Physics Nodes
@@ -92,9 +125,19 @@ private:
 	const CollisionShape*	cshapeA;
 	const CollisionShape*	cshapeB;
 
+	//Axis kept from the last time this pair was tested
+	NarrowphaseCache*		pairCache;
+	uint					numCachedAxisTests;
+	uint					numCachedAxisHits;
+
 	//Collision Axes
 	std::vector<Vector3>	possibleColAxes;
 
+	//Scratch space kept between pairs so it doesn't need to be reallocated
+	// - Contact generation only uses fixed size buffers on the stack
+	std::vector<Vector3>	axes1, axes2;
+	std::vector<Vector3>	edges1, edges2;
+
 	//Collision Data
 	bool					areColliding;
 	CollisionData			bestColData;
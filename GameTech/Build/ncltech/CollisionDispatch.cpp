@@ -0,0 +1,489 @@
+#include "CollisionDispatch.h"
+#include "SphereCollisionShape.h"
+#include "CuboidCollisionShape.h"
+#include <cstring>
+#include <cfloat>
+
+//Edge-edge axes have to be this much better than a face axis to be used, as
+// faces give much more stable manifolds when the two are close
+#define CUBOID_EDGE_AXIS_BIAS	1.05f
+
+CollisionDispatch::CollisionDispatch()
+	: mode(NARROWPHASE_DISPATCH)
+	, pnodeA(NULL)
+	, pnodeB(NULL)
+	, handler(NULL)
+	, areColliding(false)
+	, pairCache(NULL)
+	, compound(false)
+	, triangleMesh(false)
+	, childDispatch(NULL)
+	, meshShape(NULL)
+	, meshProxy(NULL)
+	, numChildPairs(0)
+	, lastChildPairLoaded(false)
+{
+	memset(handlers, 0, sizeof(handlers));
+	memset(&convexHandler, 0, sizeof(convexHandler));
+
+	RegisterTest(COLLISIONSHAPE_SPHERE, COLLISIONSHAPE_SPHERE, NarrowphaseTests::SphereSphere, true);
+	RegisterTest(COLLISIONSHAPE_SPHERE, COLLISIONSHAPE_CUBOID, NarrowphaseTests::SphereCuboid, true);
+	RegisterTest(COLLISIONSHAPE_CUBOID, COLLISIONSHAPE_CUBOID, NarrowphaseTests::CuboidCuboid, false);
+
+	//Generic convex shapes can have far more axes than SAT wants to test,
+	// so are only ever found through their support points
+	for (int i = 0; i < COLLISIONSHAPE_MAX; ++i)
+	{
+		handlers[COLLISIONSHAPE_CONVEX][i].useGJK = true;
+		handlers[i][COLLISIONSHAPE_CONVEX].useGJK = true;
+	}
+}
+
+CollisionDispatch::~CollisionDispatch()
+{
+	SAFE_DELETE(childDispatch);
+	SAFE_DELETE(meshProxy);
+}
+
+void CollisionDispatch::RegisterTest(CollisionShapeType typeA, CollisionShapeType typeB, NarrowphaseTest test, bool singleContact)
+{
+	PairHandler& forward = handlers[typeA][typeB];
+	forward.test = test;
+	forward.singleContact = singleContact;
+	forward.swapped = false;
+	forward.useGJK = false;
+
+	if (typeA != typeB)
+	{
+		PairHandler& reverse = handlers[typeB][typeA];
+		reverse = forward;
+		reverse.swapped = true;
+	}
+}
+
+void CollisionDispatch::BeginNewPair(PhysicsNode* objA, PhysicsNode* objB)
+{
+	pnodeA = objA;
+	pnodeB = objB;
+	areColliding = false;
+	pairCache = NULL;
+	compound = false;
+	triangleMesh = false;
+
+	CollisionShape* shapeA = objA->GetCollisionShape();
+	CollisionShape* shapeB = objB->GetCollisionShape();
+	if (!shapeA || !shapeB)
+		handler = NULL;
+	else if (shapeA->GetType() == COLLISIONSHAPE_COMPOUND || shapeB->GetType() == COLLISIONSHAPE_COMPOUND)
+	{
+		//Children are set up as they're tested, whatever the mode
+		handler = NULL;
+		compound = true;
+		return;
+	}
+	else if (IsTriangleShape(shapeA->GetType()) || IsTriangleShape(shapeB->GetType()))
+	{
+		handler = NULL;
+		triangleMesh = true;
+		return;
+	}
+	else if (mode == NARROWPHASE_DISPATCH)
+		handler = &handlers[shapeA->GetType()][shapeB->GetType()];
+	else
+		handler = &convexHandler;
+
+	//SAT only needs setting up if it's going to be used
+	if (handler && (!handler->test || !handler->singleContact))
+		sat.BeginNewPair(objA, objB, shapeA, shapeB);
+}
+
+void CollisionDispatch::SetPairCache(NarrowphaseCache* cache)
+{
+	pairCache = cache;
+	if (mode != NARROWPHASE_GJK)
+		sat.SetPairCache(cache);
+}
+
+bool CollisionDispatch::AreColliding(CollisionData* out_coldata)
+{
+	if (compound || triangleMesh)
+	{
+		areColliding = compound ? CompoundAreColliding() : TriangleMeshAreColliding();
+		if (areColliding && out_coldata) *out_coldata = colData;
+		return areColliding;
+	}
+
+	if (!handler)
+		return false;
+
+	if (!handler->test && (mode == NARROWPHASE_GJK || handler->useGJK))
+	{
+		gjk.BeginNewPair(pnodeA, pnodeB, pairCache);
+		areColliding = gjk.AreColliding(&colData);
+	}
+	else if (!handler->test)
+	{
+		areColliding = sat.AreColliding(&colData);
+	}
+	else if (!handler->swapped)
+	{
+		areColliding = handler->test(pnodeA, pnodeB, colData);
+	}
+	else
+	{
+		areColliding = handler->test(pnodeB, pnodeA, colData);
+
+		//Turn it from B->A back into A->B, moving the point on to B's surface
+		colData._pointOnPlane = colData._pointOnPlane - colData._normal * colData._penetration;
+		colData._normal = -colData._normal;
+	}
+
+	if (areColliding && out_coldata) *out_coldata = colData;
+	return areColliding;
+}
+
+void CollisionDispatch::GenContactPoints(Manifold* out_manifold)
+{
+	if (!out_manifold || !areColliding)
+		return;
+
+	if (compound || triangleMesh)
+	{
+		//The last colliding child pair is normally still loaded, so goes first before
+		// the rest are tested again
+		int numToReplay = numChildPairs;
+		if (lastChildPairLoaded)
+		{
+			childDispatch->GenContactPoints(out_manifold);
+			--numToReplay;
+		}
+
+		for (int i = 0; i < numToReplay; ++i)
+		{
+			if (childPairs[i].triangle >= 0)
+				LoadMeshTriangle(childPairs[i].triangle);
+
+			childDispatch->BeginNewPair(childPairs[i].nodeA, childPairs[i].nodeB);
+			childDispatch->AreColliding();
+			childDispatch->GenContactPoints(out_manifold);
+		}
+		return;
+	}
+
+	if (!handler->test && mode != NARROWPHASE_GJK && !handler->useGJK)
+	{
+		sat.GenContactPoints(out_manifold);
+		return;
+	}
+
+	if (colData._penetration >= 0.0f)
+		return;
+
+	if (handler->singleContact)
+	{
+		out_manifold->AddContact(
+			colData._pointOnPlane - colData._normal * colData._penetration,
+			colData._pointOnPlane,
+			colData._normal,
+			colData._penetration);
+	}
+	else
+	{
+		sat.SetCollisionData(colData);
+		sat.GenContactPoints(out_manifold);
+	}
+}
+
+
+bool CollisionDispatch::CompoundAreColliding()
+{
+	numChildPairs = 0;
+	lastChildPairLoaded = false;
+
+	//If both are compounds, A's children are tested here and B's by the child dispatcher
+	bool compoundIsA = pnodeA->GetCollisionShape()->GetType() == COLLISIONSHAPE_COMPOUND;
+	PhysicsNode* compoundNode = compoundIsA ? pnodeA : pnodeB;
+	PhysicsNode* otherNode = compoundIsA ? pnodeB : pnodeA;
+	const CompoundCollisionShape* shape = static_cast<const CompoundCollisionShape*>(compoundNode->GetCollisionShape());
+
+	int children[COMPOUND_MAX_CHILDREN];
+	int numChildren = shape->FindOverlappingChildren(otherNode->GetCollisionShape(), children, COMPOUND_MAX_CHILDREN);
+	if (numChildren == 0)
+		return false;
+
+	if ((int)childPairs.size() < numChildren)
+		childPairs.resize(numChildren);
+
+	if (!childDispatch)
+		childDispatch = new CollisionDispatch();
+	childDispatch->SetMode(mode);
+
+	for (int i = 0; i < numChildren; ++i)
+	{
+		PhysicsNode* childNode = shape->GetChildNode(children[i]);
+		TestChildPair(compoundIsA ? childNode : otherNode, compoundIsA ? otherNode : childNode, -1);
+	}
+
+	return numChildPairs > 0;
+}
+
+bool CollisionDispatch::TriangleMeshAreColliding()
+{
+	numChildPairs = 0;
+	lastChildPairLoaded = false;
+
+	bool meshIsA = IsTriangleShape(pnodeA->GetCollisionShape()->GetType());
+	PhysicsNode* otherNode = meshIsA ? pnodeB : pnodeA;
+	meshShape = (meshIsA ? pnodeA : pnodeB)->GetCollisionShape();
+
+	//The query returns how many triangles overlap even if they didn't all fit, in which
+	// case the buffer is grown to hold them and it is run again. The buffer is kept, so
+	// this only happens when the other shape covers more triangles than ever before
+	if (queryTriangles.empty())
+		queryTriangles.resize(TRIANGLEMESH_MAX_QUERY_TRIANGLES);
+
+	int numTriangles = FindMeshTriangles(otherNode->GetCollisionShape());
+	if (numTriangles > (int)queryTriangles.size())
+	{
+		queryTriangles.resize(numTriangles);
+		numTriangles = FindMeshTriangles(otherNode->GetCollisionShape());
+	}
+	if (numTriangles == 0)
+		return false;
+
+	if ((int)childPairs.size() < numTriangles)
+		childPairs.resize(numTriangles);
+
+	if (!childDispatch)
+		childDispatch = new CollisionDispatch();
+	childDispatch->SetMode(mode);
+
+	if (!meshProxy)
+		meshProxy = new TriangleMeshProxyNode();
+
+	for (int i = 0; i < numTriangles; ++i)
+	{
+		LoadMeshTriangle(queryTriangles[i]);
+		TestChildPair(meshIsA ? meshProxy : otherNode, meshIsA ? otherNode : meshProxy, queryTriangles[i]);
+	}
+
+	return numChildPairs > 0;
+}
+
+int CollisionDispatch::FindMeshTriangles(const CollisionShape* other)
+{
+	if (meshShape->GetType() == COLLISIONSHAPE_HEIGHTFIELD)
+		return static_cast<const HeightfieldCollisionShape*>(meshShape)->FindOverlappingTriangles(other, queryTriangles.data(), (int)queryTriangles.size());
+	else
+		return static_cast<const TriangleMeshCollisionShape*>(meshShape)->FindOverlappingTriangles(other, queryTriangles.data(), (int)queryTriangles.size());
+}
+
+void CollisionDispatch::LoadMeshTriangle(int triangle)
+{
+	Vector3 a, b, c;
+	if (meshShape->GetType() == COLLISIONSHAPE_HEIGHTFIELD)
+		static_cast<const HeightfieldCollisionShape*>(meshShape)->GetWorldTriangle(triangle, a, b, c);
+	else
+		static_cast<const TriangleMeshCollisionShape*>(meshShape)->GetWorldTriangle(triangle, a, b, c);
+
+	meshProxy->SetTriangle(a, b, c);
+}
+
+void CollisionDispatch::TestChildPair(PhysicsNode* nodeA, PhysicsNode* nodeB, int triangle)
+{
+	CollisionData childColData;
+	childDispatch->BeginNewPair(nodeA, nodeB);
+	lastChildPairLoaded = childDispatch->AreColliding(&childColData);
+	if (!lastChildPairLoaded)
+		return;
+
+	//Deepest child pair gives the collision data for the whole pair
+	if (numChildPairs == 0 || childColData._penetration < colData._penetration)
+		colData = childColData;
+
+	childPairs[numChildPairs].nodeA = nodeA;
+	childPairs[numChildPairs].nodeB = nodeB;
+	childPairs[numChildPairs].triangle = triangle;
+	++numChildPairs;
+}
+
+
+//All tests output the collision normal from A to B, a negative penetration depth
+// and the deepest point of A inside B, on B's surface (matching CollisionDetectionSAT)
+namespace NarrowphaseTests
+{
+	bool SphereSphere(const PhysicsNode* nodeA, const PhysicsNode* nodeB, CollisionData& out_coldata)
+	{
+		float radiusA = static_cast<const SphereCollisionShape*>(nodeA->GetCollisionShape())->GetRadius();
+		float radiusB = static_cast<const SphereCollisionShape*>(nodeB->GetCollisionShape())->GetRadius();
+
+		Vector3 ab = nodeB->GetPosition() - nodeA->GetPosition();
+		float sumRadii = radiusA + radiusB;
+		float distSq = Vector3::Dot(ab, ab);
+		if (distSq > sumRadii * sumRadii)
+			return false;
+
+		//Spheres on top of each other can be pushed apart in any direction
+		float dist = sqrt(distSq);
+		out_coldata._normal = dist > 1e-6f ? ab / dist : Vector3(0.0f, 1.0f, 0.0f);
+		out_coldata._penetration = dist - sumRadii;
+		out_coldata._pointOnPlane = nodeB->GetPosition() - out_coldata._normal * radiusB;
+		return true;
+	}
+
+	bool SphereCuboid(const PhysicsNode* nodeA, const PhysicsNode* nodeB, CollisionData& out_coldata)
+	{
+		float radius = static_cast<const SphereCollisionShape*>(nodeA->GetCollisionShape())->GetRadius();
+		const CuboidCollisionShape* cuboid = static_cast<const CuboidCollisionShape*>(nodeB->GetCollisionShape());
+		const Vector3& halfDims = cuboid->GetHalfDims();
+
+		const Vector3 axes[3] = { cuboid->GetWorldAxis(0), cuboid->GetWorldAxis(1), cuboid->GetWorldAxis(2) };
+		float extents[3] = { halfDims.x, halfDims.y, halfDims.z };
+
+		//Sphere centre in the cuboid's local space, and the closest point on the cuboid to it
+		Vector3 centre = nodeA->GetPosition();
+		Vector3 offset = centre - nodeB->GetPosition();
+		float local[3], closest[3];
+		bool inside = true;
+		for (int i = 0; i < 3; ++i)
+		{
+			local[i] = Vector3::Dot(offset, axes[i]);
+			closest[i] = min(max(local[i], -extents[i]), extents[i]);
+			inside = inside && (closest[i] == local[i]);
+		}
+
+		if (!inside)
+		{
+			Vector3 delta = axes[0] * (local[0] - closest[0])
+				+ axes[1] * (local[1] - closest[1])
+				+ axes[2] * (local[2] - closest[2]);
+
+			float distSq = Vector3::Dot(delta, delta);
+			if (distSq > radius * radius)
+				return false;
+
+			float dist = sqrt(distSq);
+			out_coldata._normal = -delta / dist;
+			out_coldata._penetration = dist - radius;
+			out_coldata._pointOnPlane = centre - delta;
+			return true;
+		}
+
+		//Centre inside the cuboid, so push it out through the nearest face
+		int face = 0;
+		float faceDist = extents[0] - fabs(local[0]);
+		for (int i = 1; i < 3; ++i)
+		{
+			float d = extents[i] - fabs(local[i]);
+			if (d < faceDist)
+			{
+				faceDist = d;
+				face = i;
+			}
+		}
+
+		Vector3 faceNormal = local[face] >= 0.0f ? axes[face] : -axes[face];
+		out_coldata._normal = -faceNormal;
+		out_coldata._penetration = -(faceDist + radius);
+		out_coldata._pointOnPlane = centre + faceNormal * faceDist;
+		return true;
+	}
+
+	//Checks the overlap of the two boxes' projections on one axis, keeping it if it's
+	// the smallest so far. dist is the projected distance between the centres,
+	// and scale the length of the (unnormalised) axis.
+	static inline bool CheckBoxAxis(float dist, float rA, float rB, const Vector3& axis, float scale, float bias,
+		float& bestOverlap, Vector3& bestAxis)
+	{
+		float overlap = (rA + rB - fabs(dist)) / scale;
+		if (overlap < 0.0f)
+			return false;
+
+		if (overlap * bias < bestOverlap)
+		{
+			bestOverlap = overlap;
+			bestAxis = (dist < 0.0f) ? axis / -scale : axis / scale;
+		}
+		return true;
+	}
+
+	bool CuboidCuboid(const PhysicsNode* nodeA, const PhysicsNode* nodeB, CollisionData& out_coldata)
+	{
+		const CuboidCollisionShape* cuboidA = static_cast<const CuboidCollisionShape*>(nodeA->GetCollisionShape());
+		const CuboidCollisionShape* cuboidB = static_cast<const CuboidCollisionShape*>(nodeB->GetCollisionShape());
+		const Vector3& dimsA = cuboidA->GetHalfDims();
+		const Vector3& dimsB = cuboidB->GetHalfDims();
+		float eA[3] = { dimsA.x, dimsA.y, dimsA.z };
+		float eB[3] = { dimsB.x, dimsB.y, dimsB.z };
+
+		const Vector3 axesA[3] = { cuboidA->GetWorldAxis(0), cuboidA->GetWorldAxis(1), cuboidA->GetWorldAxis(2) };
+		const Vector3 axesB[3] = { cuboidB->GetWorldAxis(0), cuboidB->GetWorldAxis(1), cuboidB->GetWorldAxis(2) };
+
+		//B's axes in A's space, with a small epsilon on the absolute values so
+		// near parallel edges don't give a false separating axis
+		const float epsilon = 1e-6f;
+		Vector3 ab = nodeB->GetPosition() - nodeA->GetPosition();
+		float R[3][3], absR[3][3], t[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			t[i] = Vector3::Dot(ab, axesA[i]);
+			for (int j = 0; j < 3; ++j)
+			{
+				R[i][j] = Vector3::Dot(axesA[i], axesB[j]);
+				absR[i][j] = fabs(R[i][j]) + epsilon;
+			}
+		}
+
+		float bestOverlap = FLT_MAX;
+		Vector3 bestAxis;
+
+		//A's face normals
+		for (int i = 0; i < 3; ++i)
+		{
+			float rB = eB[0] * absR[i][0] + eB[1] * absR[i][1] + eB[2] * absR[i][2];
+			if (!CheckBoxAxis(t[i], eA[i], rB, axesA[i], 1.0f, 1.0f, bestOverlap, bestAxis))
+				return false;
+		}
+
+		//B's face normals
+		for (int j = 0; j < 3; ++j)
+		{
+			float rA = eA[0] * absR[0][j] + eA[1] * absR[1][j] + eA[2] * absR[2][j];
+			float dist = t[0] * R[0][j] + t[1] * R[1][j] + t[2] * R[2][j];
+			if (!CheckBoxAxis(dist, rA, eB[j], axesB[j], 1.0f, 1.0f, bestOverlap, bestAxis))
+				return false;
+		}
+
+		//Cross products of each pair of edges
+		for (int i = 0; i < 3; ++i)
+		{
+			int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+			for (int j = 0; j < 3; ++j)
+			{
+				int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+
+				//Parallel edges have no axis between them, and are covered by the face normals
+				Vector3 axis = Vector3::Cross(axesA[i], axesB[j]);
+				float length = axis.Length();
+				if (length < 1e-3f)
+					continue;
+
+				float rA = eA[i1] * absR[i2][j] + eA[i2] * absR[i1][j];
+				float rB = eB[j1] * absR[i][j2] + eB[j2] * absR[i][j1];
+				float dist = t[i2] * R[i1][j] - t[i1] * R[i2][j];
+				if (!CheckBoxAxis(dist, rA, rB, axis, length, CUBOID_EDGE_AXIS_BIAS, bestOverlap, bestAxis))
+					return false;
+			}
+		}
+
+		//Deepest corner of A along the normal
+		Vector3 support = nodeA->GetPosition();
+		for (int i = 0; i < 3; ++i)
+			support += axesA[i] * (Vector3::Dot(bestAxis, axesA[i]) >= 0.0f ? eA[i] : -eA[i]);
+
+		out_coldata._normal = bestAxis;
+		out_coldata._penetration = -bestOverlap;
+		out_coldata._pointOnPlane = support + bestAxis * out_coldata._penetration;
+		return true;
+	}
+}
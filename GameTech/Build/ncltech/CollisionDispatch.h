@@ -0,0 +1,159 @@
+/******************************************************************************
+Class: CollisionDispatch
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Narrowphase front end, used by the PhysicsEngine in place of calling
+	CollisionDetectionSAT directly.
+
+	Each pair of collision shape types can have its own closed form test, which
+	is looked up in a table indexed by the two shapes' CollisionShapeType. These
+	work straight from the node's position/orientation, without any of the
+	virtual calls or axis lists that SAT needs:
+		Sphere - Sphere : Distance between the centres
+		Sphere - Cuboid : Closest point on the cuboid, in the cuboid's local space
+		Cuboid - Cuboid : The 15 axis oriented box test, using the projected
+		                  extents of both boxes on each axis
+
+	Tests that only ever touch at one point (anything with a sphere) build their
+	single contact straight from the collision data. Anything else hands its
+	collision axis to CollisionDetectionSAT, to be clipped into a manifold the
+	same way as before. Pairs without a test of their own go through SAT for
+	both stages, apart from those with a generic convex shape (e.g. a
+	ConvexHullCollisionShape), which are detected with GJK/EPA instead.
+
+	Tests are only written for one order of shapes; the reverse order is handled
+	by swapping the two nodes and flipping the result.
+
+	Pairs with a CompoundCollisionShape are split up before any of this. The
+	compound's children that overlap the other shape are each run through a
+	second CollisionDispatch, as a pair of their own, and all of their contacts
+	go in to the one manifold. Pairs with a TriangleMeshCollisionShape or a
+	HeightfieldCollisionShape are split the same way, with each triangle
+	overlapping the other shape's bounds loaded on to a proxy node in turn and
+	tested as a convex shape of its own.
+
+	The table can be bypassed (see NarrowphaseMode) to run every pair through
+	either SAT or GJK/EPA, e.g. to compare them in Benchmark_Physics. GJK pairs
+	still have their manifolds clipped by CollisionDetectionSAT.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionDetectionSAT.h"
+#include "CollisionDetectionGJK.h"
+#include "CompoundCollisionShape.h"
+#include "TriangleMeshCollisionShape.h"
+#include "HeightfieldCollisionShape.h"
+#include <vector>
+
+//Test used to detect collisions between each pair of shapes
+enum NarrowphaseMode
+{
+	NARROWPHASE_DISPATCH = 0,	//Closed form tests where there is one, SAT or GJK for everything else
+	NARROWPHASE_SAT,			//SAT for every pair
+	NARROWPHASE_GJK,			//GJK/EPA for every pair
+	NARROWPHASE_MAX
+};
+
+// Tests if the two nodes are colliding, filling out_coldata from A to B if they are
+typedef bool(*NarrowphaseTest)(const PhysicsNode* nodeA, const PhysicsNode* nodeB, CollisionData& out_coldata);
+
+class CollisionDispatch
+{
+public:
+	CollisionDispatch();
+	~CollisionDispatch();
+
+	// Sets the test used for shape types (A, B) and (B, A)
+	// - singleContact tests have their contact made from the collision data,
+	//   otherwise it is clipped with SAT along the collision normal
+	void RegisterTest(CollisionShapeType typeA, CollisionShapeType typeB, NarrowphaseTest test, bool singleContact);
+
+	inline NarrowphaseMode GetMode() const		{ return mode; }
+	inline void SetMode(NarrowphaseMode m)		{ mode = m; }
+
+	//Start processing new (possible) collision pair
+	void BeginNewPair(PhysicsNode* objA, PhysicsNode* objB);
+
+	// True if the current pair's test keeps state between steps (GJK and SAT),
+	// which should be passed in with SetPairCache before calling AreColliding
+	inline bool UsesPairCache() const			{ return handler && !handler->test; }
+	void SetPairCache(NarrowphaseCache* cache);
+
+	// SAT, for its cached axis hit counters
+	inline CollisionDetectionSAT& GetSAT()		{ return sat; }
+
+	// Returns true if the objects are colliding or false otherwise
+	bool AreColliding(CollisionData* out_coldata = NULL);
+
+	// Adds the contact points for the current pair to the manifold
+	void GenContactPoints(Manifold* out_manifold);
+
+protected:
+	struct PairHandler
+	{
+		NarrowphaseTest	test;			//NULL falls back on SAT
+		bool			singleContact;
+		bool			swapped;		//Test is written for (B, A)
+		bool			useGJK;			//Without a test, use GJK/EPA rather than SAT
+	};
+
+	struct ChildPair
+	{
+		PhysicsNode*	nodeA;
+		PhysicsNode*	nodeB;
+		int				triangle;		//Mesh triangle to load on to the proxy node first, or -1
+	};
+
+	//Tests each child of the compound against the other shape, keeping the colliding ones
+	bool CompoundAreColliding();
+
+	//Tests each triangle of the mesh (or heightfield) near the other shape against it, keeping the colliding ones
+	bool TriangleMeshAreColliding();
+	//Fills queryTriangles, returning how many overlap the shape (which may be more than fit)
+	int  FindMeshTriangles(const CollisionShape* other);
+	void LoadMeshTriangle(int triangle);
+
+	static inline bool IsTriangleShape(CollisionShapeType type)	{ return type == COLLISIONSHAPE_TRIANGLEMESH || type == COLLISIONSHAPE_HEIGHTFIELD; }
+
+	//Runs the pair through childDispatch, recording it if they collide
+	void TestChildPair(PhysicsNode* nodeA, PhysicsNode* nodeB, int triangle);
+
+	PairHandler				handlers[COLLISIONSHAPE_MAX][COLLISIONSHAPE_MAX];
+	PairHandler				convexHandler;		//Used for all pairs when the table is bypassed
+	NarrowphaseMode			mode;
+
+	PhysicsNode*			pnodeA;
+	PhysicsNode*			pnodeB;
+	const PairHandler*		handler;
+
+	bool					areColliding;
+	CollisionData			colData;
+
+	NarrowphaseCache*		pairCache;
+
+	CollisionDetectionSAT	sat;				//Fallback, and clipping for multi-contact pairs
+	CollisionDetectionGJK	gjk;
+
+	//Compound, triangle mesh and heightfield pairs
+	bool					compound;
+	bool					triangleMesh;		//Either a triangle mesh or a heightfield
+	CollisionDispatch*		childDispatch;		//Created the first time any are tested
+	const CollisionShape*	meshShape;
+	TriangleMeshProxyNode*	meshProxy;			//Created the first time a triangle mesh or heightfield is tested
+	std::vector<int>		queryTriangles;		//Triangles overlapping the other shape, grown to the most found
+	std::vector<ChildPair>	childPairs;			//Room for every child or triangle found, grown the same way
+	int						numChildPairs;
+	bool					lastChildPairLoaded;	//childDispatch still holds the last colliding pair's results
+};
+
+namespace NarrowphaseTests
+{
+	bool SphereSphere(const PhysicsNode* nodeA, const PhysicsNode* nodeB, CollisionData& out_coldata);
+	bool SphereCuboid(const PhysicsNode* nodeA, const PhysicsNode* nodeB, CollisionData& out_coldata);
+	bool CuboidCuboid(const PhysicsNode* nodeA, const PhysicsNode* nodeB, CollisionData& out_coldata);
+}
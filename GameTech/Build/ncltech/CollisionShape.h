@@ -20,16 +20,28 @@ Description:
 
 #include "Hull.h"
 #include "GeometryUtils.h"
-#include <nclgl\Vector3.h>
-#include <nclgl\Plane.h>
-#include <nclgl\Matrix3.h>
+#include <nclgl/Vector3.h>
+#include <nclgl/Plane.h>
+#include <nclgl/Matrix3.h>
 #include <vector>
-#include <list>
 
 using namespace GeometryUtils;
 
 class PhysicsNode;
 
+//Used by the narrowphase to pick a specialised test for each pair of shapes,
+// anything without one falls back on the generic SAT test
+enum CollisionShapeType
+{
+	COLLISIONSHAPE_SPHERE = 0,
+	COLLISIONSHAPE_CUBOID,
+	COLLISIONSHAPE_CONVEX,			//Any other convex shape, only handled by SAT or GJK
+	COLLISIONSHAPE_COMPOUND,		//Group of child shapes, each tested on its own
+	COLLISIONSHAPE_TRIANGLEMESH,	//Static list of triangles, each tested on its own
+	COLLISIONSHAPE_HEIGHTFIELD,		//Static grid of heights, each cell tested as two triangles
+	COLLISIONSHAPE_MAX
+};
+
 struct CollisionEdge
 {
 	CollisionEdge(const Vector3& a, const Vector3& b) 
@@ -42,9 +54,11 @@ struct CollisionEdge
 class CollisionShape
 {
 public:
-	CollisionShape() : m_Parent(NULL) {}
+	CollisionShape(CollisionShapeType type = COLLISIONSHAPE_CONVEX) : m_Parent(NULL), m_Type(type) {}
 	virtual ~CollisionShape()	{}
 
+	inline CollisionShapeType GetType() const { return m_Type; }
+
 	// Constructs an inverse inertia matrix of the given collision volume. This is the equivilant of the inverse mass of an object for rotation,
 	//   a good source for non-inverse inertia matricies can be found here: https://en.wikipedia.org/wiki/List_of_moments_of_inertia
 	virtual Matrix3 BuildInverseInertia(float invMass) const = 0;
@@ -52,10 +66,14 @@ public:
 	// Draws this collision shape to the debug renderer
 	virtual void DebugDraw() const {};
 
-	inline void SetParent(PhysicsNode* node) { m_Parent = node; }
+	inline void SetParent(PhysicsNode* node) { m_Parent = node; UpdateWorldSpaceCache(); }
 	inline		 PhysicsNode* Parent()		 { return m_Parent; }
 	inline const PhysicsNode* Parent() const { return m_Parent; }
 
+	// Called by the parent node whenever its world transform changes, so shapes
+	// can keep a world space copy of their geometry for collision detection
+	virtual void UpdateWorldSpaceCache() {}
+
 
 //<----- USED BY COLLISION DETECTION ----->
 	// Get all collision axes between the current shape and the given
@@ -65,6 +83,11 @@ public:
 		const PhysicsNode* otherObject,
 		std::vector<Vector3>& out_axes) const = 0;
 
+	// Get the directions of the shape's edges, which are crossed with the other
+	// shape's to give the edge-edge axes. Shapes whose edges all lie along their
+	// collision axes (e.g. cuboids) can return false to have those used instead.
+	virtual bool GetEdgeDirections(std::vector<Vector3>& out_edges) const { return false; }
+
 	//Returns closest point on the collision shape to the given point
 	virtual Vector3 GetClosestPoint(const Vector3& point) const = 0;
 
@@ -74,17 +97,24 @@ public:
 		Vector3& out_min,
 		Vector3& out_max) const = 0;
 
+	// Get the furthest point on the shape along the given axis (world space)
+	//  - Used by CollisionDetectionGJK, the axis doesn't need to be normalised
+	virtual Vector3 GetSupportPoint(const Vector3& axis) const = 0;
+
 
 	// Get all data needed to build manifold
 	//	- Computes the face that is closest to parallel to that of the given axis,
-	//    returning the face (as a list of vertices), face normal and the planes
+	//    returning the face (as a line loop of vertices), face normal and the planes
 	//    of all adjacent faces in order to clip against.
+	//  - Both are written to the caller's buffers, which hold MAX_POLYGON_VERTICES
+	//    vertices and MAX_CLIP_PLANES planes
 	virtual void GetIncidentReferencePolygon(
 		const Vector3& axis,
-		std::list<Vector3>& out_face,
+		OutputSpan<Vector3>& out_face,
 		Vector3& out_normal,
-		std::vector<Plane>& out_adjacent_planes) const = 0;
+		OutputSpan<Plane>& out_adjacent_planes) const = 0;
 
 protected:
-	PhysicsNode* m_Parent;
+	PhysicsNode*		m_Parent;
+	CollisionShapeType	m_Type;
 };
\ No newline at end of file
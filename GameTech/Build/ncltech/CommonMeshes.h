@@ -12,8 +12,8 @@ Description:
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include <nclgl\Mesh.h>
-#include <GL\glew.h>
+#include <nclgl/Mesh.h>
+#include <GL/glew.h>
 
 class Scene;
 
@@ -3,7 +3,7 @@
 #include "CuboidCollisionShape.h"
 #include "CommonMeshes.h"
 #include "ScreenPicker.h"
-#include <nclgl\RenderNode.h>
+#include <nclgl/RenderNode.h>
 #include <functional>
 
 //Horrible!!!
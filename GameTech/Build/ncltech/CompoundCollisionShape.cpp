@@ -0,0 +1,302 @@
+#include "CompoundCollisionShape.h"
+#include <nclgl/Matrix3.h>
+#include <algorithm>
+#include <cfloat>
+
+//Deepest the BVH traversal can go, far more than any sensible number of children needs
+#define COMPOUND_BVH_STACK_SIZE		64
+
+CompoundCollisionShape::CompoundCollisionShape()
+	: CollisionShape(COLLISIONSHAPE_COMPOUND)
+{
+	wsCentre = Vector3(0.0f, 0.0f, 0.0f);
+	wsAxes[0] = Vector3(1.0f, 0.0f, 0.0f);
+	wsAxes[1] = Vector3(0.0f, 1.0f, 0.0f);
+	wsAxes[2] = Vector3(0.0f, 0.0f, 1.0f);
+}
+
+CompoundCollisionShape::~CompoundCollisionShape()
+{
+	for (CompoundChild& child : children)
+		delete child.node;
+	children.clear();
+}
+
+void CompoundCollisionShape::AddChild(CollisionShape* shape, const Vector3& localPosition, const Quaternion& localOrientation, float massWeight)
+{
+	CompoundChild child;
+	child.node = new CompoundChildNode();
+	child.node->SetCollisionShape(shape);
+	child.localPosition = localPosition;
+	child.localOrientation = localOrientation;
+	child.massWeight = massWeight;
+
+	//Bounds in the body's local space, from the child's furthest points along each axis
+	child.node->SetTransform(localPosition, localOrientation);
+	const Vector3 axes[3] = { Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f) };
+	float mins[3], maxs[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		mins[i] = Vector3::Dot(shape->GetSupportPoint(-axes[i]), axes[i]);
+		maxs[i] = Vector3::Dot(shape->GetSupportPoint(axes[i]), axes[i]);
+	}
+	child.localMin = Vector3(mins[0], mins[1], mins[2]);
+	child.localMax = Vector3(maxs[0], maxs[1], maxs[2]);
+
+	children.push_back(child);
+	BuildBVH();
+	UpdateWorldSpaceCache();
+}
+
+void CompoundCollisionShape::BuildBVH()
+{
+	bvhNodes.clear();
+	if (children.empty())
+		return;
+
+	std::vector<int> ids(children.size());
+	for (size_t i = 0; i < children.size(); ++i)
+		ids[i] = (int)i;
+
+	bvhNodes.reserve(children.size() * 2);
+	BuildBVHNode(&ids[0], (int)ids.size());
+}
+
+int CompoundCollisionShape::BuildBVHNode(int* child_ids, int count)
+{
+	int nodeIdx = (int)bvhNodes.size();
+	bvhNodes.push_back(CompoundBVHNode());
+
+	CompoundBVHNode node;
+	node._min = children[child_ids[0]].localMin;
+	node._max = children[child_ids[0]].localMax;
+	for (int i = 1; i < count; ++i)
+	{
+		const CompoundChild& c = children[child_ids[i]];
+		node._min = Vector3(min(node._min.x, c.localMin.x), min(node._min.y, c.localMin.y), min(node._min.z, c.localMin.z));
+		node._max = Vector3(max(node._max.x, c.localMax.x), max(node._max.y, c.localMax.y), max(node._max.z, c.localMax.z));
+	}
+
+	if (count == 1)
+	{
+		node.left = node.right = -1;
+		node.child = child_ids[0];
+	}
+	else
+	{
+		//Split at the median of the children's centres, along the longest side
+		Vector3 size = node._max - node._min;
+		int axis = (size.x > size.y && size.x > size.z) ? 0 : (size.y > size.z ? 1 : 2);
+
+		const std::vector<CompoundChild>& c = children;
+		std::nth_element(child_ids, child_ids + count / 2, child_ids + count,
+			[&c, axis](int a, int b)
+		{
+			Vector3 centreA = c[a].localMin + c[a].localMax;
+			Vector3 centreB = c[b].localMin + c[b].localMax;
+			return (axis == 0) ? centreA.x < centreB.x : (axis == 1) ? centreA.y < centreB.y : centreA.z < centreB.z;
+		});
+
+		node.child = -1;
+		node.left = BuildBVHNode(child_ids, count / 2);
+		node.right = BuildBVHNode(child_ids + count / 2, count - count / 2);
+	}
+
+	bvhNodes[nodeIdx] = node;
+	return nodeIdx;
+}
+
+int CompoundCollisionShape::FindOverlappingChildren(const CollisionShape* other, int* out_children, int max_children) const
+{
+	if (bvhNodes.empty())
+		return 0;
+
+	//Bounds of the other shape along each of our local axes
+	float qMin[3], qMax[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		float centre = Vector3::Dot(wsAxes[i], wsCentre);
+		qMin[i] = Vector3::Dot(other->GetSupportPoint(-wsAxes[i]), wsAxes[i]) - centre;
+		qMax[i] = Vector3::Dot(other->GetSupportPoint(wsAxes[i]), wsAxes[i]) - centre;
+	}
+
+	int numFound = 0;
+	int stack[COMPOUND_BVH_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0 && numFound < max_children)
+	{
+		const CompoundBVHNode& node = bvhNodes[stack[--stackSize]];
+		if (node._min.x > qMax[0] || node._max.x < qMin[0]
+			|| node._min.y > qMax[1] || node._max.y < qMin[1]
+			|| node._min.z > qMax[2] || node._max.z < qMin[2])
+			continue;
+
+		if (node.child >= 0)
+		{
+			out_children[numFound++] = node.child;
+		}
+		else if (stackSize + 2 <= COMPOUND_BVH_STACK_SIZE)
+		{
+			stack[stackSize++] = node.left;
+			stack[stackSize++] = node.right;
+		}
+	}
+
+	return numFound;
+}
+
+void CompoundCollisionShape::UpdateWorldSpaceCache()
+{
+	Matrix3 rot;
+	Quaternion orientation(0.0f, 0.0f, 0.0f, 1.0f);
+	wsCentre = Vector3(0.0f, 0.0f, 0.0f);
+	if (Parent())
+	{
+		orientation = Parent()->GetOrientation();
+		rot = orientation.ToMatrix3();
+		wsCentre = Parent()->GetPosition();
+	}
+
+	for (int i = 0; i < 3; ++i)
+		wsAxes[i] = rot.GetCol(i);
+
+	for (CompoundChild& child : children)
+		child.node->SetTransform(wsCentre + rot * child.localPosition, orientation * child.localOrientation);
+}
+
+Matrix3 CompoundCollisionShape::BuildInverseInertia(float invMass) const
+{
+	if (invMass == 0.0f || children.empty())
+		return Matrix3::ZeroMatrix;
+
+	float totalWeight = 0.0f;
+	for (const CompoundChild& child : children)
+		totalWeight += child.massWeight;
+
+	const float mass = 1.0f / invMass;
+
+	Matrix3 inertia = Matrix3::ZeroMatrix;
+	for (const CompoundChild& child : children)
+	{
+		float childMass = mass * child.massWeight / totalWeight;
+		if (childMass <= 0.0f)
+			continue;
+
+		//Child's inertia about its own centre, rotated in to the body's space..
+		Matrix3 rot = child.localOrientation.ToMatrix3();
+		Matrix3 childInertia = Matrix3::Inverse(child.node->GetCollisionShape()->BuildInverseInertia(1.0f / childMass));
+		inertia += rot * childInertia * Matrix3::Transpose(rot);
+
+		//..and moved to the body's centre of mass (parallel axis theorem)
+		const Vector3& d = child.localPosition;
+		inertia += (Matrix3::Identity * Vector3::Dot(d, d) - Matrix3::OuterProduct(d, d)) * childMass;
+	}
+
+	return Matrix3::Inverse(inertia);
+}
+
+void CompoundCollisionShape::GetCollisionAxes(
+	const PhysicsNode* otherObject,
+	std::vector<Vector3>& out_axes) const
+{
+	for (const CompoundChild& child : children)
+		child.node->GetCollisionShape()->GetCollisionAxes(otherObject, out_axes);
+}
+
+Vector3 CompoundCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	float out_distSq = FLT_MAX;
+	Vector3 out_point = wsCentre;
+	for (const CompoundChild& child : children)
+	{
+		Vector3 p = child.node->GetCollisionShape()->GetClosestPoint(point);
+
+		float distSq = Vector3::Dot(p - point, p - point);
+		if (distSq < out_distSq)
+		{
+			out_distSq = distSq;
+			out_point = p;
+		}
+	}
+
+	return out_point;
+}
+
+void CompoundCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	float minCorrelation = FLT_MAX, maxCorrelation = -FLT_MAX;
+	out_min = out_max = wsCentre;
+	for (const CompoundChild& child : children)
+	{
+		Vector3 cMin, cMax;
+		child.node->GetCollisionShape()->GetMinMaxVertexOnAxis(axis, cMin, cMax);
+
+		float minDist = Vector3::Dot(axis, cMin);
+		if (minDist < minCorrelation)
+		{
+			minCorrelation = minDist;
+			out_min = cMin;
+		}
+
+		float maxDist = Vector3::Dot(axis, cMax);
+		if (maxDist > maxCorrelation)
+		{
+			maxCorrelation = maxDist;
+			out_max = cMax;
+		}
+	}
+}
+
+Vector3 CompoundCollisionShape::GetSupportPoint(const Vector3& axis) const
+{
+	float maxCorrelation = -FLT_MAX;
+	Vector3 out_point = wsCentre;
+	for (const CompoundChild& child : children)
+	{
+		Vector3 p = child.node->GetCollisionShape()->GetSupportPoint(axis);
+
+		float dist = Vector3::Dot(axis, p);
+		if (dist > maxCorrelation)
+		{
+			maxCorrelation = dist;
+			out_point = p;
+		}
+	}
+
+	return out_point;
+}
+
+void CompoundCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	OutputSpan<Vector3>& out_face,
+	Vector3& out_normal,
+	OutputSpan<Plane>& out_adjacent_planes) const
+{
+	//Face of whichever child reaches furthest along the axis
+	const CollisionShape* furthest = NULL;
+	float maxCorrelation = -FLT_MAX;
+	for (const CompoundChild& child : children)
+	{
+		const CollisionShape* shape = child.node->GetCollisionShape();
+
+		float dist = Vector3::Dot(axis, shape->GetSupportPoint(axis));
+		if (dist > maxCorrelation)
+		{
+			maxCorrelation = dist;
+			furthest = shape;
+		}
+	}
+
+	if (furthest)
+		furthest->GetIncidentReferencePolygon(axis, out_face, out_normal, out_adjacent_planes);
+}
+
+void CompoundCollisionShape::DebugDraw() const
+{
+	for (const CompoundChild& child : children)
+		child.node->GetCollisionShape()->DebugDraw();
+}
@@ -0,0 +1,140 @@
+/******************************************************************************
+Class: CompoundCollisionShape
+Implements: CollisionShape
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Extends CollisionShape to build one rigid body out of several other shapes,
+	each with its own position and orientation relative to the body. Concave or
+	multi-part objects can then be a single PhysicsNode, rather than a group of
+	nodes held together with constraints, which all need their own broadphase
+	entries and solver rows.
+
+	Each child shape is attached to a hidden PhysicsNode (CompoundChildNode), kept
+	at the child's world transform whenever the body moves. The children can then
+	be any existing shape, and be passed to CollisionDispatch as if they were a
+	body of their own.
+
+	The children's bounding boxes (in the body's local space) are put into a small
+	static bounding volume hierarchy, built as they are added. CollisionDispatch
+	uses FindOverlappingChildren to descend it with the bounds of the other shape,
+	and only the children that overlap those are tested against it. Their contacts
+	all go in to the one manifold between the two bodies.
+
+	The body's PhysicsNode position is taken as its centre of mass, so the children
+	should be placed around it. Their share of the mass is set by a weight given
+	when they are added, and BuildInverseInertia combines their inertias about it.
+
+	Note: Anything that bypasses CollisionDispatch (e.g. calling
+	CollisionDetectionSAT directly) will see the compound as the convex hull of
+	its children.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionShape.h"
+#include "PhysicsNode.h"
+#include <nclgl/Quaternion.h>
+
+//Most children the overlap queries can return
+#define COMPOUND_MAX_CHILDREN		64
+
+//Hidden node holding a child shape, at that child's world transform
+class CompoundChildNode : public PhysicsNode
+{
+public:
+	// Moves the node without waking it, updating its shape's world space cache once
+	inline void SetTransform(const Vector3& pos, const Quaternion& rot)
+	{
+		*pPosition = pos;
+		*pOrientation = rot;
+		UpdateWorldTransform();
+	}
+};
+
+struct CompoundChild
+{
+	CompoundChildNode*	node;				//Owns the child's shape
+	Vector3				localPosition;
+	Quaternion			localOrientation;
+	float				massWeight;
+	Vector3				localMin, localMax;	//Bounds in the body's local space
+};
+
+struct CompoundBVHNode
+{
+	Vector3		_min, _max;
+	int			left, right;	//Child nodes, or -1 for a leaf
+	int			child;			//Leaf's index in to the compound's children
+};
+
+class CompoundCollisionShape : public CollisionShape
+{
+public:
+	CompoundCollisionShape();
+	virtual ~CompoundCollisionShape();
+
+	// Adds a child shape, which the compound then owns
+	// - massWeight is its share of the body's mass, relative to the other children
+	void AddChild(CollisionShape* shape, const Vector3& localPosition,
+		const Quaternion& localOrientation = Quaternion(0.0f, 0.0f, 0.0f, 1.0f),
+		float massWeight = 1.0f);
+
+	inline size_t GetNumChildren() const								{ return children.size(); }
+	inline const CompoundChild& GetChild(size_t idx) const				{ return children[idx]; }
+
+	// The hidden node the child is attached to, to be passed to the narrowphase
+	inline PhysicsNode* GetChildNode(size_t idx) const					{ return children[idx].node; }
+
+	// Finds the children whose bounds overlap the bounds of the other shape (at
+	// its current world transform), writing up to max_children of them
+	// - Returns the number written
+	int FindOverlappingChildren(const CollisionShape* other, int* out_children, int max_children) const;
+
+	// Moves the children to follow the parent node
+	virtual void UpdateWorldSpaceCache() override;
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+
+	// Combines the children's inertia about the body's centre of mass
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	//  - These all treat the compound as the convex hull of its children (see above)
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual Vector3 GetSupportPoint(const Vector3& axis) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		OutputSpan<Vector3>& out_face,
+		Vector3& out_normal,
+		OutputSpan<Plane>& out_adjacent_planes) const override;
+
+protected:
+	//Rebuilds the hierarchy over all of the children's bounds
+	void BuildBVH();
+	int BuildBVHNode(int* child_ids, int count);
+
+protected:
+	std::vector<CompoundChild>		children;
+	std::vector<CompoundBVHNode>	bvhNodes;		//Root is the first node
+
+	//World space axes and centre of the parent node, as of its last move
+	Vector3							wsCentre;
+	Vector3							wsAxes[3];
+};
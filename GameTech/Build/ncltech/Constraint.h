@@ -28,7 +28,7 @@ Description:
 
 #pragma once
 #include "PhysicsNode.h"
-#include <nclgl\Vector3.h>
+#include <nclgl/Vector3.h>
 
 class Constraint
 {
@@ -50,4 +50,10 @@ public:
 
 	// Visually Debug Constraint 
 	virtual void DebugDraw() const {}
+
+
+	// Physics objects the constraint acts on (NULL if it only acts on one, or a fixed point)
+	//  - Used to join the objects into the same simulation island, so they sleep and wake together
+	virtual PhysicsNode* GetNodeA() const { return NULL; }
+	virtual PhysicsNode* GetNodeB() const { return NULL; }
 };
\ No newline at end of file
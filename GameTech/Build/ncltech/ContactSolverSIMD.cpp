@@ -0,0 +1,363 @@
+#include "ContactSolverSIMD.h"
+#include <nclgl/Matrix3.h>
+#include <cstring>
+
+#if CONTACT_SIMD_WIDTH == 8
+#include <immintrin.h>
+
+typedef __m256 simd_float;
+static inline simd_float Load(const float* p)				{ return _mm256_loadu_ps(p); }
+static inline void Store(float* p, simd_float a)			{ _mm256_storeu_ps(p, a); }
+static inline simd_float Set1(float a)						{ return _mm256_set1_ps(a); }
+static inline simd_float Add(simd_float a, simd_float b)	{ return _mm256_add_ps(a, b); }
+static inline simd_float Sub(simd_float a, simd_float b)	{ return _mm256_sub_ps(a, b); }
+static inline simd_float Mul(simd_float a, simd_float b)	{ return _mm256_mul_ps(a, b); }
+static inline simd_float Div(simd_float a, simd_float b)	{ return _mm256_div_ps(a, b); }
+static inline simd_float Max(simd_float a, simd_float b)	{ return _mm256_max_ps(a, b); }
+static inline simd_float Sqrt(simd_float a)					{ return _mm256_sqrt_ps(a); }
+//Lanes where a > b come from x, the rest from y
+static inline simd_float SelectGreater(simd_float a, simd_float b, simd_float x, simd_float y)
+{
+	return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_GT_OQ));
+}
+#else
+#include <xmmintrin.h>
+
+typedef __m128 simd_float;
+static inline simd_float Load(const float* p)				{ return _mm_loadu_ps(p); }
+static inline void Store(float* p, simd_float a)			{ _mm_storeu_ps(p, a); }
+static inline simd_float Set1(float a)						{ return _mm_set1_ps(a); }
+static inline simd_float Add(simd_float a, simd_float b)	{ return _mm_add_ps(a, b); }
+static inline simd_float Sub(simd_float a, simd_float b)	{ return _mm_sub_ps(a, b); }
+static inline simd_float Mul(simd_float a, simd_float b)	{ return _mm_mul_ps(a, b); }
+static inline simd_float Div(simd_float a, simd_float b)	{ return _mm_div_ps(a, b); }
+static inline simd_float Max(simd_float a, simd_float b)	{ return _mm_max_ps(a, b); }
+static inline simd_float Sqrt(simd_float a)					{ return _mm_sqrt_ps(a); }
+static inline simd_float SelectGreater(simd_float a, simd_float b, simd_float x, simd_float y)
+{
+	simd_float mask = _mm_cmpgt_ps(a, b);
+	return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y));
+}
+#endif
+
+//a.x * b.x + a.y * b.y + a.z * b.z for 3 rows of lanes
+static inline simd_float Dot3(const simd_float* a, const simd_float* b)
+{
+	return Add(Add(Mul(a[0], b[0]), Mul(a[1], b[1])), Mul(a[2], b[2]));
+}
+
+static inline void Load3(const float src[3][CONTACT_SIMD_WIDTH], simd_float* out)
+{
+	out[0] = Load(src[0]);
+	out[1] = Load(src[1]);
+	out[2] = Load(src[2]);
+}
+
+static inline void Store3(float dst[3][CONTACT_SIMD_WIDTH], int lane, const Vector3& v)
+{
+	dst[0][lane] = v.x;
+	dst[1][lane] = v.y;
+	dst[2][lane] = v.z;
+}
+
+//Inverse of the effective mass of a row along the given direction (0 if it can't move)
+static inline float RowMass(float invMassSum, const Vector3& dir,
+	const Matrix3& invInertiaA, const Vector3& rA, const Matrix3& invInertiaB, const Vector3& rB)
+{
+	float mass = invMassSum + Vector3::Dot(dir,
+		Vector3::Cross(invInertiaA * Vector3::Cross(rA, dir), rA) +
+		Vector3::Cross(invInertiaB * Vector3::Cross(rB, dir), rB));
+	return mass > 0.0f ? 1.0f / mass : 0.0f;
+}
+
+ContactSolverSIMD::ContactSolverSIMD()
+	: numRows(0)
+{
+}
+
+ContactSolverSIMD::~ContactSolverSIMD()
+{
+}
+
+int ContactSolverSIMD::GetBodySlot(PhysicsNode* pnode)
+{
+	int& slot = nodeSlots[pnode->GetIslandIndex()];
+	if (slot < 0)
+	{
+		slot = (int)bodyNodes.size();
+
+		Vector3 lin = pnode->GetLinearVelocity();
+		Vector3 ang = pnode->GetAngularVelocity();
+		linVelX.push_back(lin.x); linVelY.push_back(lin.y); linVelZ.push_back(lin.z);
+		angVelX.push_back(ang.x); angVelY.push_back(ang.y); angVelZ.push_back(ang.z);
+		bodyNodes.push_back(pnode);
+	}
+	return slot;
+}
+
+void ContactSolverSIMD::AddRow(ContactPoint& c, PhysicsNode* pnodeA, PhysicsNode* pnodeB, int slotA, int slotB)
+{
+	//Static objects are never changed by the solver, so they never conflict
+	const int dynA = pnodeA->IsStatic() ? -1 : slotA;
+	const int dynB = pnodeB->IsStatic() ? -1 : slotB;
+
+	size_t b = bundles.size() > CONTACT_SIMD_BUNDLE_WINDOW ? bundles.size() - CONTACT_SIMD_BUNDLE_WINDOW : 0;
+	for (; b < bundles.size(); ++b)
+	{
+		if (bundleSize[b] == CONTACT_SIMD_WIDTH)
+			continue;
+
+		const ContactBundle& bundle = bundles[b];
+		bool conflict = false;
+		for (uint l = 0; l < bundleSize[b] && !conflict; ++l)
+		{
+			conflict = bundle.bodyA[l] == dynA || bundle.bodyB[l] == dynA
+				|| bundle.bodyA[l] == dynB || bundle.bodyB[l] == dynB;
+		}
+		if (!conflict)
+			break;
+	}
+
+	if (b == bundles.size())
+	{
+		//Unused lanes point at the empty body in slot 0 and have no mass, so do nothing
+		ContactBundle bundle;
+		memset(&bundle, 0, sizeof(ContactBundle));
+		bundles.push_back(bundle);
+		bundleSize.push_back(0);
+	}
+
+	ContactBundle& bundle = bundles[b];
+	const int l = (int)bundleSize[b]++;
+
+	bundle.bodyA[l] = slotA;
+	bundle.bodyB[l] = slotB;
+	bundle.contact[l] = &c;
+
+	const Vector3& n = c.colNormal;
+	const Vector3& rA = c.relPosA;
+	const Vector3& rB = c.relPosB;
+
+	//Any two directions perpendicular to the normal will do for friction
+	Vector3 t1 = (fabs(n.x) > 0.57735f) ? Vector3(n.y, -n.x, 0.0f) : Vector3(0.0f, n.z, -n.y);
+	t1.Normalise();
+	Vector3 t2 = Vector3::Cross(n, t1);
+
+	const float invMassA = pnodeA->IsStatic() ? 0.0f : pnodeA->GetInverseMass();
+	const float invMassB = pnodeB->IsStatic() ? 0.0f : pnodeB->GetInverseMass();
+	const Matrix3 invInertiaA = pnodeA->IsStatic() ? Matrix3::ZeroMatrix : pnodeA->GetInverseInertia();
+	const Matrix3 invInertiaB = pnodeB->IsStatic() ? Matrix3::ZeroMatrix : pnodeB->GetInverseInertia();
+
+	Store3(bundle.normal, l, n);
+	Store3(bundle.tangent1, l, t1);
+	Store3(bundle.tangent2, l, t2);
+
+	Store3(bundle.rAxN, l, Vector3::Cross(rA, n));
+	Store3(bundle.rBxN, l, Vector3::Cross(rB, n));
+	Store3(bundle.rAxT1, l, Vector3::Cross(rA, t1));
+	Store3(bundle.rBxT1, l, Vector3::Cross(rB, t1));
+	Store3(bundle.rAxT2, l, Vector3::Cross(rA, t2));
+	Store3(bundle.rBxT2, l, Vector3::Cross(rB, t2));
+
+	Store3(bundle.iArAxN, l, invInertiaA * Vector3::Cross(rA, n));
+	Store3(bundle.iBrBxN, l, invInertiaB * Vector3::Cross(rB, n));
+	Store3(bundle.iArAxT1, l, invInertiaA * Vector3::Cross(rA, t1));
+	Store3(bundle.iBrBxT1, l, invInertiaB * Vector3::Cross(rB, t1));
+	Store3(bundle.iArAxT2, l, invInertiaA * Vector3::Cross(rA, t2));
+	Store3(bundle.iBrBxT2, l, invInertiaB * Vector3::Cross(rB, t2));
+
+	bundle.invMassA[l] = invMassA;
+	bundle.invMassB[l] = invMassB;
+	bundle.normalMass[l] = RowMass(invMassA + invMassB, n, invInertiaA, rA, invInertiaB, rB);
+	bundle.tangentMass1[l] = RowMass(invMassA + invMassB, t1, invInertiaA, rA, invInertiaB, rB);
+	bundle.tangentMass2[l] = RowMass(invMassA + invMassB, t2, invInertiaA, rA, invInertiaB, rB);
+	bundle.bias[l] = c.b_term;
+	bundle.friction[l] = pnodeA->GetFriction() * pnodeB->GetFriction();
+
+	//Carry on from whatever the contact was warm started with
+	bundle.normalImpulse[l] = c.sumImpulseContact;
+	bundle.tangentImpulse1[l] = Vector3::Dot(c.sumImpulseFriction, t1);
+	bundle.tangentImpulse2[l] = Vector3::Dot(c.sumImpulseFriction, t2);
+
+	++numRows;
+}
+
+void ContactSolverSIMD::Solve(Manifold* const* manifolds, size_t numManifolds, int iterations, size_t numNodes)
+{
+	//1. Gather
+	// - Every node could need a slot (plus the zero slot), so they never grow mid step
+	if (bodyNodes.capacity() < numNodes + 1)
+	{
+		linVelX.reserve(numNodes + 1); linVelY.reserve(numNodes + 1); linVelZ.reserve(numNodes + 1);
+		angVelX.reserve(numNodes + 1); angVelY.reserve(numNodes + 1); angVelZ.reserve(numNodes + 1);
+		bodyNodes.reserve(numNodes + 1);
+	}
+	linVelX.assign(1, 0.0f); linVelY.assign(1, 0.0f); linVelZ.assign(1, 0.0f);
+	angVelX.assign(1, 0.0f); angVelY.assign(1, 0.0f); angVelZ.assign(1, 0.0f);
+	bodyNodes.assign(1, NULL);
+
+	//Only the used slots are cleared afterwards, as there may be lots of small islands
+	if (nodeSlots.size() < numNodes)
+		nodeSlots.resize(numNodes, -1);
+
+	//2. Pack the rows into bundles
+	bundles.clear();
+	bundleSize.clear();
+	numRows = 0;
+	for (size_t i = 0; i < numManifolds; ++i)
+	{
+		Manifold* m = manifolds[i];
+		if (m->contactPoints.empty())
+			continue;
+
+		int slotA = GetBodySlot(m->NodeA());
+		int slotB = GetBodySlot(m->NodeB());
+		for (ContactPoint& c : m->contactPoints)
+			AddRow(c, m->NodeA(), m->NodeB(), slotA, slotB);
+	}
+
+	//3. Solve
+	for (int i = 0; i < iterations; ++i)
+	{
+		for (ContactBundle& bundle : bundles)
+			SolveBundle(bundle);
+	}
+
+	//4. Scatter the results back
+	for (size_t b = 0; b < bundles.size(); ++b)
+	{
+		const ContactBundle& bundle = bundles[b];
+		for (uint l = 0; l < bundleSize[b]; ++l)
+		{
+			ContactPoint& c = *bundle.contact[l];
+			c.sumImpulseContact = bundle.normalImpulse[l];
+			c.sumImpulseFriction =
+				Vector3(bundle.tangent1[0][l], bundle.tangent1[1][l], bundle.tangent1[2][l]) * bundle.tangentImpulse1[l] +
+				Vector3(bundle.tangent2[0][l], bundle.tangent2[1][l], bundle.tangent2[2][l]) * bundle.tangentImpulse2[l];
+		}
+	}
+
+	for (size_t s = 1; s < bodyNodes.size(); ++s)
+	{
+		PhysicsNode* pnode = bodyNodes[s];
+		if (!pnode->IsStatic())
+		{
+			pnode->SetLinearVelocity(Vector3(linVelX[s], linVelY[s], linVelZ[s]));
+			pnode->SetAngularVelocity(Vector3(angVelX[s], angVelY[s], angVelZ[s]));
+		}
+		nodeSlots[pnode->GetIslandIndex()] = -1;
+	}
+}
+
+void ContactSolverSIMD::SolveBundle(ContactBundle& bundle)
+{
+	const int W = CONTACT_SIMD_WIDTH;
+
+	//Gather the velocities of both objects in each lane
+	float gathered[12][CONTACT_SIMD_WIDTH];
+	for (int l = 0; l < W; ++l)
+	{
+		const int a = bundle.bodyA[l];
+		const int b = bundle.bodyB[l];
+		gathered[0][l] = linVelX[a]; gathered[1][l] = linVelY[a]; gathered[2][l] = linVelZ[a];
+		gathered[3][l] = angVelX[a]; gathered[4][l] = angVelY[a]; gathered[5][l] = angVelZ[a];
+		gathered[6][l] = linVelX[b]; gathered[7][l] = linVelY[b]; gathered[8][l] = linVelZ[b];
+		gathered[9][l] = angVelX[b]; gathered[10][l] = angVelY[b]; gathered[11][l] = angVelZ[b];
+	}
+
+	simd_float vA[3], wA[3], vB[3], wB[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		vA[k] = Load(gathered[k]);
+		wA[k] = Load(gathered[3 + k]);
+		vB[k] = Load(gathered[6 + k]);
+		wB[k] = Load(gathered[9 + k]);
+	}
+
+	simd_float n[3], t1[3], t2[3];
+	Load3(bundle.normal, n);
+	Load3(bundle.tangent1, t1);
+	Load3(bundle.tangent2, t2);
+
+	simd_float rAxN[3], rBxN[3], rAxT1[3], rBxT1[3], rAxT2[3], rBxT2[3];
+	Load3(bundle.rAxN, rAxN);
+	Load3(bundle.rBxN, rBxN);
+	Load3(bundle.rAxT1, rAxT1);
+	Load3(bundle.rBxT1, rBxT1);
+	Load3(bundle.rAxT2, rAxT2);
+	Load3(bundle.rBxT2, rBxT2);
+
+	const simd_float zero = Set1(0.0f);
+	const simd_float invMassA = Load(bundle.invMassA);
+	const simd_float invMassB = Load(bundle.invMassB);
+
+	//Relative velocity along each row, all taken before any impulses are applied
+	// (as with the scalar solver): dv.d = (vB - vA).d + wB.(rB x d) - wA.(rA x d)
+	simd_float dv[3] = { Sub(vB[0], vA[0]), Sub(vB[1], vA[1]), Sub(vB[2], vA[2]) };
+	simd_float dvn = Sub(Add(Dot3(dv, n), Dot3(wB, rBxN)), Dot3(wA, rAxN));
+	simd_float dvt1 = Sub(Add(Dot3(dv, t1), Dot3(wB, rBxT1)), Dot3(wA, rAxT1));
+	simd_float dvt2 = Sub(Add(Dot3(dv, t2), Dot3(wB, rBxT2)), Dot3(wA, rAxT2));
+
+	//Normal impulse, with only the total clamped so it is never pulling the objects
+	// together (this step's can be negative, taking back some of the warm start)
+	simd_float jn = Mul(Add(Sub(zero, dvn), Load(bundle.bias)), Load(bundle.normalMass));
+	simd_float oldNormal = Load(bundle.normalImpulse);
+	simd_float newNormal = Max(Add(oldNormal, jn), zero);
+	Store(bundle.normalImpulse, newNormal);
+	jn = Sub(newNormal, oldNormal);
+
+	//Friction impulse, with the total clamped to a circle with the normal impulse as its radius
+	simd_float friction = Load(bundle.friction);
+	simd_float oldT1 = Load(bundle.tangentImpulse1);
+	simd_float oldT2 = Load(bundle.tangentImpulse2);
+	simd_float newT1 = Sub(oldT1, Mul(Mul(dvt1, friction), Load(bundle.tangentMass1)));
+	simd_float newT2 = Sub(oldT2, Mul(Mul(dvt2, friction), Load(bundle.tangentMass2)));
+
+	simd_float len = Sqrt(Add(Mul(newT1, newT1), Mul(newT2, newT2)));
+	simd_float scale = SelectGreater(len, newNormal, Div(newNormal, Max(len, Set1(1e-12f))), Set1(1.0f));
+	newT1 = Mul(newT1, scale);
+	newT2 = Mul(newT2, scale);
+	Store(bundle.tangentImpulse1, newT1);
+	Store(bundle.tangentImpulse2, newT2);
+	simd_float jt1 = Sub(newT1, oldT1);
+	simd_float jt2 = Sub(newT2, oldT2);
+
+	//Apply the combined impulse to both objects
+	simd_float iArAxN[3], iBrBxN[3], iArAxT1[3], iBrBxT1[3], iArAxT2[3], iBrBxT2[3];
+	Load3(bundle.iArAxN, iArAxN);
+	Load3(bundle.iBrBxN, iBrBxN);
+	Load3(bundle.iArAxT1, iArAxT1);
+	Load3(bundle.iBrBxT1, iBrBxT1);
+	Load3(bundle.iArAxT2, iArAxT2);
+	Load3(bundle.iBrBxT2, iBrBxT2);
+
+	for (int k = 0; k < 3; ++k)
+	{
+		simd_float impulse = Add(Add(Mul(n[k], jn), Mul(t1[k], jt1)), Mul(t2[k], jt2));
+		vA[k] = Sub(vA[k], Mul(impulse, invMassA));
+		vB[k] = Add(vB[k], Mul(impulse, invMassB));
+
+		wA[k] = Sub(wA[k], Add(Add(Mul(iArAxN[k], jn), Mul(iArAxT1[k], jt1)), Mul(iArAxT2[k], jt2)));
+		wB[k] = Add(wB[k], Add(Add(Mul(iBrBxN[k], jn), Mul(iBrBxT1[k], jt1)), Mul(iBrBxT2[k], jt2)));
+	}
+
+	//Scatter back, no two lanes share a dynamic object and static/unused lanes
+	// are written back with the values they were read with
+	for (int k = 0; k < 3; ++k)
+	{
+		Store(gathered[k], vA[k]);
+		Store(gathered[3 + k], wA[k]);
+		Store(gathered[6 + k], vB[k]);
+		Store(gathered[9 + k], wB[k]);
+	}
+
+	for (int l = 0; l < W; ++l)
+	{
+		const int a = bundle.bodyA[l];
+		const int b = bundle.bodyB[l];
+		linVelX[a] = gathered[0][l]; linVelY[a] = gathered[1][l]; linVelZ[a] = gathered[2][l];
+		angVelX[a] = gathered[3][l]; angVelY[a] = gathered[4][l]; angVelZ[a] = gathered[5][l];
+		linVelX[b] = gathered[6][l]; linVelY[b] = gathered[7][l]; linVelZ[b] = gathered[8][l];
+		angVelX[b] = gathered[9][l]; angVelY[b] = gathered[10][l]; angVelZ[b] = gathered[11][l];
+	}
+}
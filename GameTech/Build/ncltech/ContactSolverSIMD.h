@@ -0,0 +1,106 @@
+/******************************************************************************
+Class: ContactSolverSIMD
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Vectorised version of the contact solver in Manifold::SolveContactPoint. The
+	scalar solver goes through the PhysicsNode getters/setters for every contact
+	and recomputes all of the inverse inertia and cross products on every single
+	iteration. Instead this:
+		1: Gathers the velocities of every object into flat arrays, and each
+		   contact into a row with all of its jacobians and effective masses
+		   worked out up front
+		2: Packs the rows into bundles of CONTACT_SIMD_WIDTH (4 with SSE, 8 with
+		   AVX), where no two rows in a bundle act on the same dynamic object
+		3: Solves a whole bundle at once for each iteration
+		4: Scatters the velocities and accumulated impulses back at the end
+
+	Friction is solved along two fixed tangents (rather than the tangent of the
+	current relative velocity), with the combined impulse clamped to the same
+	circle as the scalar solver.
+
+	Only contacts are handled, so anything with other constraints in it still
+	needs to go through the scalar solver.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "Manifold.h"
+#include <vector>
+
+//Rows solved at once, AVX is only used if the project is built with /arch:AVX
+#if defined(__AVX__)
+#define CONTACT_SIMD_WIDTH		8
+#else
+#define CONTACT_SIMD_WIDTH		4
+#endif
+
+//Number of the most recently created bundles a row will try to fit into
+// before a new one is started
+#define CONTACT_SIMD_BUNDLE_WINDOW	8
+
+class ContactSolverSIMD
+{
+public:
+	ContactSolverSIMD();
+	~ContactSolverSIMD();
+
+	// Runs all of the solver iterations over the contacts of the given manifolds.
+	// numNodes is the number of physics nodes, which the island indices refer to
+	void Solve(Manifold* const* manifolds, size_t numManifolds, int iterations, size_t numNodes);
+
+	inline size_t NumRows() const		{ return numRows; }
+	inline size_t NumBundles() const	{ return bundles.size(); }
+
+protected:
+	//Structure of arrays for CONTACT_SIMD_WIDTH contacts
+	struct ContactBundle
+	{
+		int		bodyA[CONTACT_SIMD_WIDTH];
+		int		bodyB[CONTACT_SIMD_WIDTH];
+		ContactPoint* contact[CONTACT_SIMD_WIDTH];	//NULL for unused lanes
+
+		float	normal[3][CONTACT_SIMD_WIDTH];
+		float	tangent1[3][CONTACT_SIMD_WIDTH];
+		float	tangent2[3][CONTACT_SIMD_WIDTH];
+
+		//Angular jacobians (rA x n etc) and the same with inverse inertia applied
+		float	rAxN[3][CONTACT_SIMD_WIDTH], rBxN[3][CONTACT_SIMD_WIDTH];
+		float	rAxT1[3][CONTACT_SIMD_WIDTH], rBxT1[3][CONTACT_SIMD_WIDTH];
+		float	rAxT2[3][CONTACT_SIMD_WIDTH], rBxT2[3][CONTACT_SIMD_WIDTH];
+		float	iArAxN[3][CONTACT_SIMD_WIDTH], iBrBxN[3][CONTACT_SIMD_WIDTH];
+		float	iArAxT1[3][CONTACT_SIMD_WIDTH], iBrBxT1[3][CONTACT_SIMD_WIDTH];
+		float	iArAxT2[3][CONTACT_SIMD_WIDTH], iBrBxT2[3][CONTACT_SIMD_WIDTH];
+
+		float	invMassA[CONTACT_SIMD_WIDTH], invMassB[CONTACT_SIMD_WIDTH];
+		float	normalMass[CONTACT_SIMD_WIDTH];		//Inverse of the effective mass (0 if the row does nothing)
+		float	tangentMass1[CONTACT_SIMD_WIDTH];
+		float	tangentMass2[CONTACT_SIMD_WIDTH];
+		float	bias[CONTACT_SIMD_WIDTH];
+		float	friction[CONTACT_SIMD_WIDTH];
+
+		float	normalImpulse[CONTACT_SIMD_WIDTH];
+		float	tangentImpulse1[CONTACT_SIMD_WIDTH];
+		float	tangentImpulse2[CONTACT_SIMD_WIDTH];
+	};
+
+	// Slot in the body arrays for the node, adding it if it isn't there yet
+	int  GetBodySlot(PhysicsNode* pnode);
+	// Puts the contact into the first recent bundle it doesn't conflict with
+	void AddRow(ContactPoint& c, PhysicsNode* pnodeA, PhysicsNode* pnodeB, int slotA, int slotB);
+	void SolveBundle(ContactBundle& bundle);
+
+protected:
+	//Body velocities, slot 0 is an empty body used by the unused lanes
+	std::vector<float>	linVelX, linVelY, linVelZ;
+	std::vector<float>	angVelX, angVelY, angVelZ;
+	std::vector<PhysicsNode*> bodyNodes;			//Node in each slot, static ones are never written back
+	std::vector<int>	nodeSlots;					//Slot of each node by island index (-1 if not used)
+
+	std::vector<ContactBundle>	bundles;
+	std::vector<uint>			bundleSize;
+	size_t						numRows;
+};
@@ -0,0 +1,733 @@
+#include "ConvexHullCollisionShape.h"
+#include "PhysicsNode.h"
+#ifndef NCLTECH_HEADLESS
+#include <nclgl/Mesh.h>
+#endif
+#include <nclgl/NCLDebug.h>
+#include <nclgl/Matrix3.h>
+#include <cfloat>
+#include <algorithm>
+
+//Neighbouring triangles with normals this close are merged into one face
+#define CONVEXHULL_COPLANAR_DOT		0.999f
+
+//Directions this close to an existing axis (or its opposite) are skipped
+#define CONVEXHULL_PARALLEL_DOT		0.9999f
+
+namespace
+{
+	struct QuickhullFace
+	{
+		int					v[3];			//Anticlockwise, seen from outside
+		Vector3				normal;
+		float				distance;		//Of the face's plane from the origin
+		std::vector<int>	outside;		//Points in front of this face (and none before it)
+		int					furthest;
+		float				furthestDist;
+		bool				alive;
+	};
+
+	//Adds a triangle, wound so that it faces away from the centre
+	void AddQuickhullFace(const std::vector<Vector3>& points, const Vector3& centre,
+		std::vector<QuickhullFace>& faces, int v0, int v1, int v2)
+	{
+		QuickhullFace face;
+		face.normal = Vector3::Cross(points[v1] - points[v0], points[v2] - points[v0]);
+		face.normal.Normalise();
+		if (Vector3::Dot(face.normal, centre - points[v0]) > 0.0f)
+		{
+			std::swap(v1, v2);
+			face.normal = -face.normal;
+		}
+
+		face.v[0] = v0;
+		face.v[1] = v1;
+		face.v[2] = v2;
+		face.distance = Vector3::Dot(face.normal, points[v0]);
+		face.furthest = -1;
+		face.furthestDist = 0.0f;
+		face.alive = true;
+		faces.push_back(face);
+	}
+
+	//Gives the point to the first face (from first_face onwards) it is in front of,
+	// points that aren't in front of any are inside the hull and can be dropped
+	void AssignQuickhullPoint(const std::vector<Vector3>& points, std::vector<QuickhullFace>& faces,
+		size_t first_face, int point, float epsilon)
+	{
+		for (size_t i = first_face; i < faces.size(); ++i)
+		{
+			QuickhullFace& face = faces[i];
+			if (!face.alive)
+				continue;
+
+			float dist = Vector3::Dot(face.normal, points[point]) - face.distance;
+			if (dist > epsilon)
+			{
+				face.outside.push_back(point);
+				if (dist > face.furthestDist)
+				{
+					face.furthestDist = dist;
+					face.furthest = point;
+				}
+				return;
+			}
+		}
+	}
+
+	//Builds the hull of the given points out of triangles, adding the furthest point outside
+	// it each iteration until there are none left or it has max_vertices points on it
+	// - Returns false if the points are all (nearly) in a plane
+	// - out_epsilon is how far a point has to be outside a face to count, which depends
+	//   on the size of the point cloud
+	bool Quickhull(const std::vector<Vector3>& points, int max_vertices, std::vector<int>& out_triangles, float& out_epsilon)
+	{
+		const int numPoints = (int)points.size();
+		if (numPoints < 4)
+			return false;
+
+		//Extreme points along each axis, which also give the size of the point cloud
+		int extremes[6] = { 0, 0, 0, 0, 0, 0 };
+		for (int i = 1; i < numPoints; ++i)
+		{
+			const Vector3& p = points[i];
+			if (p.x < points[extremes[0]].x) extremes[0] = i;
+			if (p.x > points[extremes[1]].x) extremes[1] = i;
+			if (p.y < points[extremes[2]].y) extremes[2] = i;
+			if (p.y > points[extremes[3]].y) extremes[3] = i;
+			if (p.z < points[extremes[4]].z) extremes[4] = i;
+			if (p.z > points[extremes[5]].z) extremes[5] = i;
+		}
+
+		float size = max(points[extremes[1]].x - points[extremes[0]].x,
+			max(points[extremes[3]].y - points[extremes[2]].y, points[extremes[5]].z - points[extremes[4]].z));
+		if (size < 1e-6f)
+			return false;
+
+		const float epsilon = size * 1e-4f;
+		out_epsilon = epsilon;
+
+		//Starting tetrahedron: The two extremes furthest apart..
+		int a = extremes[0], b = extremes[1];
+		float bestDistSq = -1.0f;
+		for (int i = 0; i < 6; ++i)
+		{
+			for (int j = i + 1; j < 6; ++j)
+			{
+				Vector3 diff = points[extremes[j]] - points[extremes[i]];
+				float distSq = Vector3::Dot(diff, diff);
+				if (distSq > bestDistSq)
+				{
+					bestDistSq = distSq;
+					a = extremes[i];
+					b = extremes[j];
+				}
+			}
+		}
+
+		//..the point furthest from the line through them..
+		Vector3 lineDir = points[b] - points[a];
+		lineDir.Normalise();
+
+		int c = -1;
+		float bestDist = epsilon;
+		for (int i = 0; i < numPoints; ++i)
+		{
+			Vector3 ap = points[i] - points[a];
+			float dist = (ap - lineDir * Vector3::Dot(ap, lineDir)).Length();
+			if (dist > bestDist)
+			{
+				bestDist = dist;
+				c = i;
+			}
+		}
+		if (c < 0)
+			return false;
+
+		//..and the point furthest from the plane through all three
+		Vector3 planeNormal = Vector3::Cross(points[b] - points[a], points[c] - points[a]);
+		planeNormal.Normalise();
+
+		int d = -1;
+		bestDist = epsilon;
+		for (int i = 0; i < numPoints; ++i)
+		{
+			float dist = fabs(Vector3::Dot(planeNormal, points[i] - points[a]));
+			if (dist > bestDist)
+			{
+				bestDist = dist;
+				d = i;
+			}
+		}
+		if (d < 0)
+			return false;
+
+		//The hull only ever grows, so this stays inside it
+		const Vector3 centre = (points[a] + points[b] + points[c] + points[d]) * 0.25f;
+
+		std::vector<QuickhullFace> faces;
+		AddQuickhullFace(points, centre, faces, a, b, c);
+		AddQuickhullFace(points, centre, faces, a, b, d);
+		AddQuickhullFace(points, centre, faces, a, c, d);
+		AddQuickhullFace(points, centre, faces, b, c, d);
+
+		for (int i = 0; i < numPoints; ++i)
+		{
+			if (i != a && i != b && i != c && i != d)
+				AssignQuickhullPoint(points, faces, 0, i, epsilon);
+		}
+
+		std::vector<int> visible, horizon, orphans;
+		std::vector<int> usedStamp(numPoints, -1);
+		int numHullVertices = 4;
+		for (int iteration = 0; numHullVertices < max_vertices; ++iteration)
+		{
+			//Furthest point outside the hull
+			int eyeFace = -1;
+			float eyeDist = 0.0f;
+			for (size_t i = 0; i < faces.size(); ++i)
+			{
+				if (faces[i].alive && faces[i].furthest >= 0 && faces[i].furthestDist > eyeDist)
+				{
+					eyeDist = faces[i].furthestDist;
+					eyeFace = (int)i;
+				}
+			}
+			if (eyeFace < 0)
+				break;
+
+			const int eye = faces[eyeFace].furthest;
+
+			//Faces it can see, which are all replaced by a cone out to it
+			visible.clear();
+			for (size_t i = 0; i < faces.size(); ++i)
+			{
+				if (faces[i].alive && Vector3::Dot(faces[i].normal, points[eye]) - faces[i].distance > 0.0f)
+					visible.push_back((int)i);
+			}
+
+			//Horizon - Edges of the visible faces that aren't shared with another visible face
+			horizon.clear();
+			for (int f : visible)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					int e0 = faces[f].v[k], e1 = faces[f].v[(k + 1) % 3];
+
+					bool shared = false;
+					for (size_t g = 0; !shared && g < visible.size(); ++g)
+					{
+						const QuickhullFace& other = faces[visible[g]];
+						for (int l = 0; !shared && l < 3; ++l)
+							shared = (other.v[l] == e1 && other.v[(l + 1) % 3] == e0);
+					}
+
+					if (!shared)
+					{
+						horizon.push_back(e0);
+						horizon.push_back(e1);
+					}
+				}
+			}
+
+			orphans.clear();
+			for (int f : visible)
+			{
+				faces[f].alive = false;
+				for (int p : faces[f].outside)
+				{
+					if (p != eye) orphans.push_back(p);
+				}
+				std::vector<int>().swap(faces[f].outside);
+			}
+
+			size_t firstNewFace = faces.size();
+			for (size_t i = 0; i < horizon.size(); i += 2)
+				AddQuickhullFace(points, centre, faces, horizon[i], horizon[i + 1], eye);
+
+			for (int p : orphans)
+				AssignQuickhullPoint(points, faces, firstNewFace, p, epsilon);
+
+			//Adding the point can bury some of the earlier ones, so count what's left
+			numHullVertices = 0;
+			for (const QuickhullFace& face : faces)
+			{
+				if (!face.alive) continue;
+				for (int k = 0; k < 3; ++k)
+				{
+					if (usedStamp[face.v[k]] != iteration)
+					{
+						usedStamp[face.v[k]] = iteration;
+						++numHullVertices;
+					}
+				}
+			}
+		}
+
+		out_triangles.clear();
+		for (const QuickhullFace& face : faces)
+		{
+			if (face.alive)
+				out_triangles.insert(out_triangles.end(), face.v, face.v + 3);
+		}
+		return true;
+	}
+
+	//Merges neighbouring triangles that lie in the same plane (to within epsilon) into single
+	// faces, each written out as its normal, number of vertices and outline (anticlockwise)
+	void MergeCoplanarTriangles(const std::vector<Vector3>& positions, const std::vector<int>& triangles, float epsilon,
+		std::vector<Vector3>& out_normals, std::vector<int>& out_sizes, std::vector<int>& out_vertices)
+	{
+		const int numTris = (int)triangles.size() / 3;
+
+		std::vector<Vector3> normals(numTris);
+		for (int t = 0; t < numTris; ++t)
+		{
+			const int* v = &triangles[t * 3];
+			normals[t] = Vector3::Cross(positions[v[1]] - positions[v[0]], positions[v[2]] - positions[v[0]]);
+			normals[t].Normalise();
+		}
+
+		//Triangle on the other side of each edge, edge k going from vertex k to k+1
+		std::vector<int> neighbours(numTris * 3, -1);
+		for (int t = 0; t < numTris; ++t)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				int e0 = triangles[t * 3 + k], e1 = triangles[t * 3 + (k + 1) % 3];
+				for (int u = 0; neighbours[t * 3 + k] < 0 && u < numTris; ++u)
+				{
+					for (int l = 0; l < 3; ++l)
+					{
+						if (triangles[u * 3 + l] == e1 && triangles[u * 3 + (l + 1) % 3] == e0)
+							neighbours[t * 3 + k] = u;
+					}
+				}
+			}
+		}
+
+		//Flood fill out from each triangle not yet in a face, through any neighbours in the same plane
+		std::vector<int> faceOf(numTris, -1);
+		std::vector<int> members, stack, boundary, loop;
+		for (int seed = 0; seed < numTris; ++seed)
+		{
+			if (faceOf[seed] >= 0)
+				continue;
+
+			const float seedDist = Vector3::Dot(normals[seed], positions[triangles[seed * 3]]);
+
+			members.clear();
+			stack.assign(1, seed);
+			faceOf[seed] = seed;
+			while (!stack.empty())
+			{
+				int t = stack.back();
+				stack.pop_back();
+				members.push_back(t);
+
+				for (int k = 0; k < 3; ++k)
+				{
+					int n = neighbours[t * 3 + k];
+					if (n < 0 || faceOf[n] >= 0 || Vector3::Dot(normals[seed], normals[n]) < CONVEXHULL_COPLANAR_DOT)
+						continue;
+
+					bool inPlane = true;
+					for (int l = 0; inPlane && l < 3; ++l)
+						inPlane = fabs(Vector3::Dot(normals[seed], positions[triangles[n * 3 + l]]) - seedDist) < epsilon;
+
+					if (inPlane)
+					{
+						faceOf[n] = seed;
+						stack.push_back(n);
+					}
+				}
+			}
+
+			//Outline of the face is every edge that doesn't lead to another of its triangles
+			boundary.clear();
+			for (int t : members)
+			{
+				for (int k = 0; k < 3; ++k)
+				{
+					int n = neighbours[t * 3 + k];
+					if (n < 0 || faceOf[n] != seed)
+					{
+						boundary.push_back(triangles[t * 3 + k]);
+						boundary.push_back(triangles[t * 3 + (k + 1) % 3]);
+					}
+				}
+			}
+
+			//Chain the edges into a single loop, keeping the triangles' winding
+			loop.clear();
+			int current = boundary[0];
+			for (size_t step = 0; step < boundary.size() / 2; ++step)
+			{
+				loop.push_back(current);
+
+				int next = -1;
+				for (size_t i = 0; next < 0 && i < boundary.size(); i += 2)
+				{
+					if (boundary[i] == current) next = boundary[i + 1];
+				}
+				if (next < 0 || next == boundary[0])
+					break;
+				current = next;
+			}
+
+			if (loop.size() * 2 == boundary.size())
+			{
+				out_normals.push_back(normals[seed]);
+				out_sizes.push_back((int)loop.size());
+				out_vertices.insert(out_vertices.end(), loop.begin(), loop.end());
+			}
+			else
+			{
+				//Outline isn't a simple loop, so just keep the triangles
+				for (int t : members)
+				{
+					out_normals.push_back(normals[t]);
+					out_sizes.push_back(3);
+					out_vertices.insert(out_vertices.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+				}
+			}
+		}
+	}
+
+	void AddUniqueDirection(std::vector<Vector3>& directions, const Vector3& dir)
+	{
+		for (const Vector3& existing : directions)
+		{
+			if (fabs(Vector3::Dot(existing, dir)) > CONVEXHULL_PARALLEL_DOT)
+				return;
+		}
+		directions.push_back(dir);
+	}
+}
+
+
+#ifndef NCLTECH_HEADLESS
+ConvexHullCollisionShape::ConvexHullCollisionShape(const Mesh* mesh, int maxVertices, const Vector3& scale)
+	: CollisionShape(COLLISIONSHAPE_CONVEX)
+{
+	std::vector<Vector3> points;
+	if (mesh && mesh->vertices)
+	{
+		points.resize(mesh->numVertices);
+		for (GLuint i = 0; i < mesh->numVertices; ++i)
+			points[i] = mesh->vertices[i] * scale;
+	}
+
+	BuildHull(points, maxVertices);
+}
+#endif
+
+ConvexHullCollisionShape::ConvexHullCollisionShape(const Vector3* points, int numPoints, int maxVertices)
+	: CollisionShape(COLLISIONSHAPE_CONVEX)
+{
+	BuildHull(std::vector<Vector3>(points, points + numPoints), maxVertices);
+}
+
+ConvexHullCollisionShape::~ConvexHullCollisionShape()
+{
+
+}
+
+void ConvexHullCollisionShape::BuildHull(const std::vector<Vector3>& points, int maxVertices)
+{
+	std::vector<int> triangles;
+	float epsilon;
+	if (!Quickhull(points, max(maxVertices, 4), triangles, epsilon))
+	{
+		//Flat (or empty) point cloud, so use a thin box around it instead
+		NCLLOG("ConvexHullCollisionShape: %d points have no volume, using their bounding box", (int)points.size());
+
+		Vector3 minP(-0.01f, -0.01f, -0.01f), maxP(0.01f, 0.01f, 0.01f);
+		if (!points.empty())
+		{
+			minP = maxP = points[0];
+			for (const Vector3& p : points)
+			{
+				minP = Vector3(min(minP.x, p.x), min(minP.y, p.y), min(minP.z, p.z));
+				maxP = Vector3(max(maxP.x, p.x), max(maxP.y, p.y), max(maxP.z, p.z));
+			}
+			minP = minP - Vector3(0.01f, 0.01f, 0.01f);
+			maxP = maxP + Vector3(0.01f, 0.01f, 0.01f);
+		}
+
+		std::vector<Vector3> box(8);
+		for (int i = 0; i < 8; ++i)
+			box[i] = Vector3((i & 1) ? maxP.x : minP.x, (i & 2) ? maxP.y : minP.y, (i & 4) ? maxP.z : minP.z);
+
+		BuildHull(box, 8);
+		return;
+	}
+
+	std::vector<Vector3> faceNormals;
+	std::vector<int> faceSizes, faceVertices;
+	MergeCoplanarTriangles(points, triangles, epsilon, faceNormals, faceSizes, faceVertices);
+
+	//Contact generation clips with one plane per edge of a face, so while any face has more
+	// than MAX_CLIP_PLANES vertices the hull is simplified further (in proportion)
+	int largestFace = 0;
+	for (int size : faceSizes)
+		largestFace = max(largestFace, size);
+
+	if (largestFace > MAX_CLIP_PLANES)
+	{
+		std::vector<int> used(triangles);
+		std::sort(used.begin(), used.end());
+		int numHullVertices = (int)(std::unique(used.begin(), used.end()) - used.begin());
+		int fewerVertices = max(numHullVertices * MAX_CLIP_PLANES / largestFace, 4);
+
+		NCLLOG("ConvexHullCollisionShape: Face of %d vertices is over %d, simplifying hull to %d vertices",
+			largestFace, MAX_CLIP_PLANES, fewerVertices);
+		BuildHull(points, fewerVertices);
+		return;
+	}
+
+	//Only keep the points that ended up on the hull's faces
+	std::vector<int> remap(points.size(), -1);
+	hull.Clear();
+	for (int& idx : faceVertices)
+	{
+		if (remap[idx] < 0)
+			remap[idx] = hull.AddVertex(points[idx]);
+		idx = remap[idx];
+	}
+
+	for (size_t i = 0, offset = 0; i < faceSizes.size(); offset += faceSizes[i++])
+		hull.AddFace(faceNormals[i], faceSizes[i], &faceVertices[offset]);
+
+	BuildQueryData();
+
+	lastSupportVertex = lastMinVertex = lastMaxVertex = 0;
+	wsVertices.resize(hull.GetNumVertices());
+	wsFaceNormals.resize(hull.GetNumFaces());
+	wsAxes.resize(localAxes.size());
+	wsEdgeDirs.resize(localEdgeDirs.size());
+	UpdateWorldSpaceCache();
+}
+
+void ConvexHullCollisionShape::BuildQueryData()
+{
+	const int numVertices = (int)hull.GetNumVertices();
+
+	adjacencyStart.resize(numVertices + 1);
+	adjacency.clear();
+	localExtents = Vector3(0.0f, 0.0f, 0.0f);
+	for (int i = 0; i < numVertices; ++i)
+	{
+		const HullVertex& vert = hull.GetVertex(i);
+
+		//Every vertex sharing a face, not just those along an edge, as the merged faces
+		// are only flat to within epsilon and a long thin one can otherwise leave a
+		// vertex looking like the furthest when the one diagonally across is further
+		adjacencyStart[i] = (int)adjacency.size();
+		for (int faceIdx : vert._enclosing_faces)
+		{
+			for (int other : hull.GetFace(faceIdx)._vert_ids)
+			{
+				if (other != i && std::find(adjacency.begin() + adjacencyStart[i], adjacency.end(), other) == adjacency.end())
+					adjacency.push_back(other);
+			}
+		}
+
+		localExtents.x = max(localExtents.x, fabs(vert._pos.x));
+		localExtents.y = max(localExtents.y, fabs(vert._pos.y));
+		localExtents.z = max(localExtents.z, fabs(vert._pos.z));
+	}
+	adjacencyStart[numVertices] = (int)adjacency.size();
+
+	localAxes.clear();
+	for (size_t i = 0; i < hull.GetNumFaces(); ++i)
+		AddUniqueDirection(localAxes, hull.GetFace(i)._normal);
+
+	localEdgeDirs.clear();
+	for (size_t i = 0; i < hull.GetNumEdges(); ++i)
+	{
+		const HullEdge& edge = hull.GetEdge(i);
+		Vector3 dir = hull.GetVertex(edge._vEnd)._pos - hull.GetVertex(edge._vStart)._pos;
+		dir.Normalise();
+		AddUniqueDirection(localEdgeDirs, dir);
+	}
+}
+
+Matrix3 ConvexHullCollisionShape::BuildInverseInertia(float invMass) const
+{
+	Matrix3 inertia;
+
+	Vector3 dimsSq = (localExtents + localExtents);
+	dimsSq = dimsSq * dimsSq;
+
+	inertia._11 = 12.f * invMass / (dimsSq.y + dimsSq.z);
+	inertia._22 = 12.f * invMass / (dimsSq.x + dimsSq.z);
+	inertia._33 = 12.f * invMass / (dimsSq.x + dimsSq.y);
+
+	return inertia;
+}
+
+void ConvexHullCollisionShape::UpdateWorldSpaceCache()
+{
+	Matrix3 rot;
+	Vector3 centre(0.0f, 0.0f, 0.0f);
+	if (Parent())
+	{
+		rot = Parent()->GetOrientation().ToMatrix3();
+		centre = Parent()->GetPosition();
+	}
+
+	const Vector3 axisX = rot.GetCol(0), axisY = rot.GetCol(1), axisZ = rot.GetCol(2);
+
+	for (size_t i = 0; i < wsVertices.size(); ++i)
+	{
+		const Vector3& local = hull.GetVertex(i)._pos;
+		wsVertices[i] = centre + axisX * local.x + axisY * local.y + axisZ * local.z;
+	}
+
+	for (size_t i = 0; i < wsFaceNormals.size(); ++i)
+	{
+		const Vector3& local = hull.GetFace(i)._normal;
+		wsFaceNormals[i] = axisX * local.x + axisY * local.y + axisZ * local.z;
+	}
+
+	for (size_t i = 0; i < wsAxes.size(); ++i)
+		wsAxes[i] = axisX * localAxes[i].x + axisY * localAxes[i].y + axisZ * localAxes[i].z;
+
+	for (size_t i = 0; i < wsEdgeDirs.size(); ++i)
+		wsEdgeDirs[i] = axisX * localEdgeDirs[i].x + axisY * localEdgeDirs[i].y + axisZ * localEdgeDirs[i].z;
+}
+
+int ConvexHullCollisionShape::FindFurthestVertex(const Vector3& axis, int start_vertex) const
+{
+	int current = start_vertex;
+	float currentDist = Vector3::Dot(axis, wsVertices[current]);
+
+	//Keep moving to the best neighbour, until none of them are any further along
+	for (;;)
+	{
+		int best = current;
+		for (int i = adjacencyStart[current]; i < adjacencyStart[current + 1]; ++i)
+		{
+			float dist = Vector3::Dot(axis, wsVertices[adjacency[i]]);
+			if (dist > currentDist)
+			{
+				currentDist = dist;
+				best = adjacency[i];
+			}
+		}
+
+		if (best == current)
+			return current;
+		current = best;
+	}
+}
+
+void ConvexHullCollisionShape::GetCollisionAxes(
+	const PhysicsNode* otherObject,
+	std::vector<Vector3>& out_axes) const
+{
+	out_axes.insert(out_axes.end(), wsAxes.begin(), wsAxes.end());
+}
+
+bool ConvexHullCollisionShape::GetEdgeDirections(std::vector<Vector3>& out_edges) const
+{
+	out_edges.insert(out_edges.end(), wsEdgeDirs.begin(), wsEdgeDirs.end());
+	return true;
+}
+
+Vector3 ConvexHullCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	//Iterate over each edge and get the closest point on any edge to point p.
+	float out_distSq = FLT_MAX;
+	Vector3 out_point;
+	for (size_t i = 0; i < hull.GetNumEdges(); ++i)
+	{
+		const HullEdge& e = hull.GetEdge(i);
+		Vector3 ep = GeometryUtils::GetClosestPoint(point, Edge(wsVertices[e._vStart], wsVertices[e._vEnd]));
+
+		float distSq = Vector3::Dot(ep - point, ep - point);
+		if (distSq < out_distSq)
+		{
+			out_distSq = distSq;
+			out_point = ep;
+		}
+	}
+
+	return out_point;
+}
+
+void ConvexHullCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	lastMinVertex = FindFurthestVertex(-axis, lastMinVertex);
+	lastMaxVertex = FindFurthestVertex(axis, lastMaxVertex);
+
+	out_min = wsVertices[lastMinVertex];
+	out_max = wsVertices[lastMaxVertex];
+}
+
+Vector3 ConvexHullCollisionShape::GetSupportPoint(const Vector3& axis) const
+{
+	lastSupportVertex = FindFurthestVertex(axis, lastSupportVertex);
+	return wsVertices[lastSupportVertex];
+}
+
+void ConvexHullCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	OutputSpan<Vector3>& out_face,
+	Vector3& out_normal,
+	OutputSpan<Plane>& out_adjacent_planes) const
+{
+	//Get the furthest vertex along axis - this will be part of the furthest face
+	lastSupportVertex = FindFurthestVertex(axis, lastSupportVertex);
+	const HullVertex& vert = hull.GetVertex(lastSupportVertex);
+
+
+	//The face (containing that vertex) whose normal is closest to parallel with the axis
+	const HullFace* best_face = 0;
+	float best_correlation = -FLT_MAX;
+	for (int faceIdx : vert._enclosing_faces)
+	{
+		float temp_correlation = Vector3::Dot(axis, wsFaceNormals[faceIdx]);
+		if (temp_correlation > best_correlation)
+		{
+			best_correlation = temp_correlation;
+			best_face = &hull.GetFace(faceIdx);
+		}
+	}
+
+
+	// Output face normal
+	out_normal = wsFaceNormals[best_face->_idx];
+
+	// Output face vertices
+	for (int vertIdx : best_face->_vert_ids)
+		out_face.push_back(wsVertices[vertIdx]);
+
+	// Clip planes are the (negated) planes of the faces on the other side
+	// of each edge, as in CuboidCollisionShape
+	for (int edgeIdx : best_face->_edge_ids)
+	{
+		const HullEdge& edge = hull.GetEdge(edgeIdx);
+		const Vector3& wsPointOnPlane = wsVertices[edge._vStart];
+
+		for (int adjFaceIdx : edge._enclosing_faces)
+		{
+			if (adjFaceIdx != best_face->_idx)
+			{
+				Vector3 planeNrml = -wsFaceNormals[adjFaceIdx];
+				float planeDist = -Vector3::Dot(planeNrml, wsPointOnPlane);
+
+				out_adjacent_planes.push_back(Plane(planeNrml, planeDist));
+			}
+		}
+	}
+}
+
+void ConvexHullCollisionShape::DebugDraw() const
+{
+	hull.DebugDraw(Parent()->GetWorldSpaceTransform());
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+Class: ConvexHullCollisionShape
+Implements: CollisionShape
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Extends CollisionShape to wrap an arbitrary render mesh (e.g. an OBJMesh) in a
+	convex hull, so it can collide as something tighter than a sphere or cuboid.
+
+	The hull is built once, with quickhull, from the mesh's vertex positions. Each
+	step of quickhull adds the point furthest outside the current hull, so stopping
+	once it holds maxVertices points gives the closest hull that budget allows
+	while throwing away all the small detail that costs the most to collide with.
+	Triangles left lying in the same plane are then merged back into single faces,
+	and the result stored as a Hull, as CuboidCollisionShape does for its cube.
+	No face may have more than MAX_CLIP_PLANES vertices, as contact generation
+	clips with one plane per edge of a face, so a hull with a bigger one (e.g. the
+	cap of a finely tessellated cylinder) is rebuilt with fewer vertices.
+
+	Support and min/max queries don't scan every vertex. Starting from the vertex
+	the last query ended on, they walk to whichever neighbour (any vertex sharing a
+	face) is further along the axis until none are. On a convex shape that walk can
+	only stop at the furthest vertex, and as objects barely move between steps it
+	is normally only a step or two away.
+
+	Like the cuboid, the hull's vertices, normals and edge directions are kept in
+	world space and only rebuilt when the node moves (UpdateWorldSpaceCache).
+
+	Note: Only the mesh's own vertices are used, not those of any child meshes.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionShape.h"
+#include "Hull.h"
+
+class Mesh;
+
+//Default number of vertices a hull is simplified down to
+#define CONVEXHULL_DEFAULT_MAX_VERTICES		24
+
+class ConvexHullCollisionShape : public CollisionShape
+{
+public:
+#ifndef NCLTECH_HEADLESS
+	// Builds the hull of the mesh's vertices, each multiplied by scale
+	ConvexHullCollisionShape(const Mesh* mesh, int maxVertices = CONVEXHULL_DEFAULT_MAX_VERTICES, const Vector3& scale = Vector3(1.0f, 1.0f, 1.0f));
+#endif
+	ConvexHullCollisionShape(const Vector3* points, int numPoints, int maxVertices = CONVEXHULL_DEFAULT_MAX_VERTICES);
+	virtual ~ConvexHullCollisionShape();
+
+	// The simplified hull, in the node's local space
+	inline const Hull& GetHull() const { return hull; }
+
+	// Rebuilds the world space hull from the parent node's transform
+	virtual void UpdateWorldSpaceCache() override;
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+
+	// Build Inertia Matrix for rotational mass
+	//  - Approximated by the box around the hull
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual bool GetEdgeDirections(std::vector<Vector3>& out_edges) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual Vector3 GetSupportPoint(const Vector3& axis) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		OutputSpan<Vector3>& out_face,
+		Vector3& out_normal,
+		OutputSpan<Plane>& out_adjacent_planes) const override;
+
+protected:
+	//Builds the hull from a point cloud, see description above
+	void BuildHull(const std::vector<Vector3>& points, int maxVertices);
+
+	//Precomputes the vertex neighbours, axes and extents used by the queries
+	void BuildQueryData();
+
+	//Walks from start_vertex to the vertex furthest along the axis
+	int FindFurthestVertex(const Vector3& axis, int start_vertex) const;
+
+protected:
+	Hull					hull;
+
+	//Vertices sharing a face with vertex i are adjacency[adjacencyStart[i]] to adjacency[adjacencyStart[i + 1] - 1]
+	std::vector<int>		adjacencyStart;
+	std::vector<int>		adjacency;
+
+	std::vector<Vector3>	localAxes;			//Face normals, without any parallel duplicates
+	std::vector<Vector3>	localEdgeDirs;		//Edge directions, without any parallel duplicates
+	Vector3					localExtents;		//Furthest the hull reaches from the origin on each axis
+
+	//World space copy of the above, see UpdateWorldSpaceCache
+	std::vector<Vector3>	wsVertices;			//In the same order as the hull's vertices
+	std::vector<Vector3>	wsFaceNormals;		//In the same order as the hull's faces
+	std::vector<Vector3>	wsAxes;
+	std::vector<Vector3>	wsEdgeDirs;
+
+	//Vertices the last queries ended on, and so where the next start
+	mutable int				lastSupportVertex;
+	mutable int				lastMinVertex;
+	mutable int				lastMaxVertex;
+};
@@ -2,10 +2,12 @@
 #include "PhysicsNode.h"
 #include "GeometryUtils.h"
 #include <nclgl/Matrix3.h>
+#include <cfloat>
 
 Hull CuboidCollisionShape::cubeHull = Hull();
 
 CuboidCollisionShape::CuboidCollisionShape()
+	: CollisionShape(COLLISIONSHAPE_CUBOID)
 {
 	halfDims = Vector3(0.5f, 0.5f, 0.5f);
 
@@ -13,9 +15,11 @@ CuboidCollisionShape::CuboidCollisionShape()
 	{
 		ConstructCubeHull();
 	}
+	UpdateWorldSpaceCache();
 }
 
 CuboidCollisionShape::CuboidCollisionShape(const Vector3& halfdims)
+	: CollisionShape(COLLISIONSHAPE_CUBOID)
 {
 	halfDims = halfdims;
 
@@ -23,6 +27,7 @@ CuboidCollisionShape::CuboidCollisionShape(const Vector3& halfdims)
 	{
 		ConstructCubeHull();
 	}
+	UpdateWorldSpaceCache();
 }
 
 CuboidCollisionShape::~CuboidCollisionShape()
@@ -44,38 +49,56 @@ Matrix3 CuboidCollisionShape::BuildInverseInertia(float invMass) const
 	return inertia;
 }
 
+void CuboidCollisionShape::UpdateWorldSpaceCache()
+{
+	Matrix3 rot;
+	wsCentre = Vector3(0.0f, 0.0f, 0.0f);
+	if (Parent())
+	{
+		rot = Parent()->GetOrientation().ToMatrix3();
+		wsCentre = Parent()->GetPosition();
+	}
+
+	for (int i = 0; i < 3; ++i)
+		wsAxes[i] = rot.GetCol(i);
+
+	//The hull is a [-1,1] cube, so each vertex/normal is just a signed sum of the axes
+	for (int i = 0; i < 8; ++i)
+	{
+		const Vector3& local = cubeHull.GetVertex(i)._pos;
+		wsVertices[i] = wsCentre
+			+ wsAxes[0] * (local.x * halfDims.x)
+			+ wsAxes[1] * (local.y * halfDims.y)
+			+ wsAxes[2] * (local.z * halfDims.z);
+	}
+
+	for (int i = 0; i < 6; ++i)
+	{
+		const Vector3& local = cubeHull.GetFace(i)._normal;
+		wsFaceNormals[i] = wsAxes[0] * local.x + wsAxes[1] * local.y + wsAxes[2] * local.z;
+	}
+}
+
 void CuboidCollisionShape::GetCollisionAxes(
 	const PhysicsNode* otherObject,
 	std::vector<Vector3>& out_axes) const
 {
-	Matrix3 objOrientation = Parent()->GetOrientation().ToMatrix3();
-	out_axes.push_back(objOrientation * Vector3(1.0f, 0.0f, 0.0f)); //X - Axis
-	out_axes.push_back(objOrientation * Vector3(0.0f, 1.0f, 0.0f)); //Y - Axis
-	out_axes.push_back(objOrientation * Vector3(0.0f, 0.0f, 1.0f)); //Z - Axis
+	out_axes.push_back(wsAxes[0]); //X - Axis
+	out_axes.push_back(wsAxes[1]); //Y - Axis
+	out_axes.push_back(wsAxes[2]); //Z - Axis
 }
 
 Vector3 CuboidCollisionShape::GetClosestPoint(const Vector3& point) const
 {
 	//Iterate over each edge and get the closest point on any edge to point p.
-
-	// Build World Transform
-	Matrix4 wsTransform = Parent()->GetWorldSpaceTransform() * Matrix4::Scale(halfDims);
-
-	// Convert world space axis into model space (Axis Aligned Cuboid)
-	Matrix4 invWsTransform = Matrix4::Inverse(wsTransform);
-	Vector3 local_point = invWsTransform * point;
-
 	float out_distSq = FLT_MAX;
 	Vector3 out_point;
 	for (size_t i = 0; i < cubeHull.GetNumEdges(); ++i)
 	{
 		const HullEdge& e = cubeHull.GetEdge(i);
-		Vector3 start = cubeHull.GetVertex(e._vStart)._pos;
-		Vector3 end = cubeHull.GetVertex(e._vEnd)._pos;
-
-		Vector3 ep = GeometryUtils::GetClosestPoint(local_point, Edge(start, end));
+		Vector3 ep = GeometryUtils::GetClosestPoint(point, Edge(wsVertices[e._vStart], wsVertices[e._vEnd]));
 
-		float distSq = Vector3::Dot(ep - local_point, ep - local_point);
+		float distSq = Vector3::Dot(ep - point, ep - point);
 		if (distSq < out_distSq)
 		{
 			out_distSq = distSq;
@@ -83,7 +106,7 @@ Vector3 CuboidCollisionShape::GetClosestPoint(const Vector3& point) const
 		}
 	}
 
-	return wsTransform * out_point;
+	return out_point;
 }
 
 void CuboidCollisionShape::GetMinMaxVertexOnAxis(
@@ -91,45 +114,46 @@ void CuboidCollisionShape::GetMinMaxVertexOnAxis(
 	Vector3& out_min,
 	Vector3& out_max) const
 {
-	// Build World Transform
-	Matrix4 wsTransform = Parent()->GetWorldSpaceTransform() * Matrix4::Scale(halfDims);
-
-	// Convert world space axis into model space (Axis Aligned Cuboid)
-	Matrix3 invNormalMatrix = Matrix3::Inverse(Matrix3(wsTransform));
-	Vector3 local_axis = invNormalMatrix * axis;
-	local_axis.Normalise();
+	//Furthest corner is the one with the same signs as the axis in the cuboid's space,
+	// and the closest is opposite it
+	Vector3 offset = wsAxes[0] * (Vector3::Dot(axis, wsAxes[0]) >= 0.0f ? halfDims.x : -halfDims.x)
+		+ wsAxes[1] * (Vector3::Dot(axis, wsAxes[1]) >= 0.0f ? halfDims.y : -halfDims.y)
+		+ wsAxes[2] * (Vector3::Dot(axis, wsAxes[2]) >= 0.0f ? halfDims.z : -halfDims.z);
+
+	out_min = wsCentre - offset;
+	out_max = wsCentre + offset;
+}
 
-	// Get closest and furthest vertex id's
-	int vMin, vMax;
-	cubeHull.GetMinMaxVerticesInAxis(local_axis, &vMin, &vMax);
 
-	// Return closest and furthest vertices in world-space
-	out_min = wsTransform * cubeHull.GetVertex(vMin)._pos;
-	out_max = wsTransform * cubeHull.GetVertex(vMax)._pos;
+Vector3 CuboidCollisionShape::GetSupportPoint(const Vector3& axis) const
+{
+	//Corner with the same signs as the axis in the cuboid's local space
+	Vector3 point = wsCentre;
+	point += wsAxes[0] * (Vector3::Dot(axis, wsAxes[0]) >= 0.0f ? halfDims.x : -halfDims.x);
+	point += wsAxes[1] * (Vector3::Dot(axis, wsAxes[1]) >= 0.0f ? halfDims.y : -halfDims.y);
+	point += wsAxes[2] * (Vector3::Dot(axis, wsAxes[2]) >= 0.0f ? halfDims.z : -halfDims.z);
+	return point;
 }
 
 
-
 void CuboidCollisionShape::GetIncidentReferencePolygon(
 	const Vector3& axis,
-	std::list<Vector3>& out_face,
+	OutputSpan<Vector3>& out_face,
 	Vector3& out_normal,
-	std::vector<Plane>& out_adjacent_planes) const
+	OutputSpan<Plane>& out_adjacent_planes) const
 {
-	//Get the world-space transform
-	Matrix4 wsTransform = Parent()->GetWorldSpaceTransform() * Matrix4::Scale(halfDims);
-
-	//Get normal and inverse-normal matrices to transfom the collision axis to and from modelspace
-	Matrix3 invNormalMatrix = Matrix3::Inverse(Matrix3(wsTransform));
-	Matrix3 normalMatrix = Matrix3::Inverse(invNormalMatrix);
-
-
-	Vector3 local_axis = invNormalMatrix * axis;
-
-
 	//Get the furthest vertex along axis - this will be part of the furthest face
-	int undefined, maxVertex;
-	cubeHull.GetMinMaxVerticesInAxis(local_axis, &undefined, &maxVertex);
+	int maxVertex = 0;
+	float maxCorrelation = -FLT_MAX;
+	for (int i = 0; i < 8; ++i)
+	{
+		float correlation = Vector3::Dot(axis, wsVertices[i]);
+		if (correlation > maxCorrelation)
+		{
+			maxCorrelation = correlation;
+			maxVertex = i;
+		}
+	}
 	const HullVertex& vert = cubeHull.GetVertex(maxVertex);
 
 
@@ -140,72 +164,51 @@ void CuboidCollisionShape::GetIncidentReferencePolygon(
 	float best_correlation = -FLT_MAX;
 	for (int faceIdx : vert._enclosing_faces)
 	{
-		const HullFace* face = &cubeHull.GetFace(faceIdx);
-		float temp_correlation = Vector3::Dot(local_axis, face->_normal);
+		float temp_correlation = Vector3::Dot(axis, wsFaceNormals[faceIdx]);
 		if (temp_correlation > best_correlation)
 		{
 			best_correlation = temp_correlation;
-			best_face = face;
+			best_face = &cubeHull.GetFace(faceIdx);
 		}
 	}
 
 
 	// Output face normal
-	out_normal = (normalMatrix * best_face->_normal).Normalise();
+	out_normal = wsFaceNormals[best_face->_idx];
 
-	// Output face vertices (transformed back into world-space)
+	// Output face vertices
 	for (int vertIdx : best_face->_vert_ids)
-	{
-		const HullVertex& vert = cubeHull.GetVertex(vertIdx);
-		out_face.push_back(wsTransform * vert._pos);
-	}
-
-	// Now, we need to define a set of planes that will clip any 3d geometry down to fit inside 
-	// the shape. This results in us forming list of clip planes from each of the
-	// adjacent faces along with the reference face itself.
+		out_face.push_back(wsVertices[vertIdx]);
 
-	Vector3 wsPointOnPlane = wsTransform * cubeHull.GetVertex(cubeHull.GetEdge(best_face->_edge_ids[0])._vStart)._pos;
-
-	// First, form a plane around the reference face
-	{
-		//We use the negated normal here for the plane, as we want to clip geometry left outside the shape not inside it.
-		Vector3 planeNrml = -(normalMatrix * best_face->_normal);
-		planeNrml.Normalise();
-
-		float planeDist = -Vector3::Dot(planeNrml, wsPointOnPlane);
-		//out_adjacent_planes.push_back(Plane(planeNrml, planeDist));
-	}
-
-	// Now we need to loop over all adjacent faces, and form a similar
-	// clip plane around those too.
+	// Now we need to loop over all adjacent faces, and form a clip plane
+	// around each of them, to clip any 3d geometry down to fit inside the shape.
 	// - The way that the HULL object is constructed means each edge can only
 	//   ever have two adjoining faces. This means we can iterate through all
 	//   edges of the face and then build a plane around the 'other' face that
 	//   also shares that edge.
+	// - We use the negated normal here for the plane, as we want to clip geometry
+	//   left outside the shape not inside it.
 	for (int edgeIdx : best_face->_edge_ids)
 	{
 		const HullEdge& edge = cubeHull.GetEdge(edgeIdx);
-
-		wsPointOnPlane = wsTransform * cubeHull.GetVertex(edge._vStart)._pos;
+		const Vector3& wsPointOnPlane = wsVertices[edge._vStart];
 
 		for (int adjFaceIdx : edge._enclosing_faces)
 		{
 			if (adjFaceIdx != best_face->_idx)
 			{
-				const HullFace& adjFace = cubeHull.GetFace(adjFaceIdx);
-
-				Vector3 planeNrml = -(normalMatrix * adjFace._normal);
-				planeNrml.Normalise();
+				Vector3 planeNrml = -wsFaceNormals[adjFaceIdx];
 				float planeDist = -Vector3::Dot(planeNrml, wsPointOnPlane);
 
 				out_adjacent_planes.push_back(Plane(planeNrml, planeDist));
 			}
 		}
 	}
-
 }
 
 
+
+
 void CuboidCollisionShape::DebugDraw() const
 {
 	// Just draw the cuboid hull-mesh at the position of our PhysicsNode
@@ -18,6 +18,10 @@ Description:
 	track of all the adjacency information as well. So vertices know which edges/faces they belong too and each 
 	face knows which faces it is adjoined too.
 
+	The hull's vertices, face normals and axes are kept in world space, and rebuilt only when the node
+	moves (UpdateWorldSpaceCache). Every pair the cuboid is tested in that step then shares them, so
+	the collision routines below are just dot products over these arrays, with no matrix inverses.
+
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
@@ -33,9 +37,9 @@ public:
 	virtual ~CuboidCollisionShape();
 
 	// Set Cuboid Dimensions
-	void SetHalfWidth(float half_width) { halfDims.x = fabs(half_width); }
-	void SetHalfHeight(float half_height) { halfDims.y = fabs(half_height); }
-	void SetHalfDepth(float half_depth) { halfDims.z = fabs(half_depth); }
+	void SetHalfWidth(float half_width) { halfDims.x = fabs(half_width); UpdateWorldSpaceCache(); }
+	void SetHalfHeight(float half_height) { halfDims.y = fabs(half_height); UpdateWorldSpaceCache(); }
+	void SetHalfDepth(float half_depth) { halfDims.z = fabs(half_depth); UpdateWorldSpaceCache(); }
 
 	// Get Cuboid Dimensions
 	const Vector3& GetHalfDims() const { return halfDims; }
@@ -43,6 +47,12 @@ public:
 	float GetHalfHeight()	const { return halfDims.y; }
 	float GetHalfDepth()	const { return halfDims.z; }
 
+	// World space direction of the cuboid's local x/y/z axis, as of the node's last move
+	inline const Vector3& GetWorldAxis(int i) const { return wsAxes[i]; }
+
+	// Rebuilds the world space hull from the parent node's transform
+	virtual void UpdateWorldSpaceCache() override;
+
 	// Debug Collision Shape
 	virtual void DebugDraw() const override;
 
@@ -64,11 +74,13 @@ public:
 		Vector3& out_min,
 		Vector3& out_max) const override;
 
+	virtual Vector3 GetSupportPoint(const Vector3& axis) const override;
+
 	virtual void GetIncidentReferencePolygon(
 		const Vector3& axis,
-		std::list<Vector3>& out_face,
+		OutputSpan<Vector3>& out_face,
 		Vector3& out_normal,
-		std::vector<Plane>& out_adjacent_planes) const override;
+		OutputSpan<Plane>& out_adjacent_planes) const override;
 
 protected:
 	//Constructs the static cube hull 
@@ -76,6 +88,13 @@ protected:
 
 protected:
 	Vector3				 halfDims;
+
+	//World space copy of the cube hull, see UpdateWorldSpaceCache
+	Vector3				 wsCentre;
+	Vector3				 wsAxes[3];			//Normals of the +x/+y/+z faces, and the directions of their edges
+	Vector3				 wsVertices[8];		//In the same order as cubeHull's vertices
+	Vector3				 wsFaceNormals[6];	//In the same order as cubeHull's faces
+
 	static Hull			 cubeHull;			//Static cube descriptor, as all cuboid instances will have the same underlying model format ([-1,-1,-1] - [1,1,1] axis aligned cuboid)
 }; 
 
@@ -80,16 +80,19 @@ void DistanceConstraint::ApplyImpulse()
 		
 		float jn = -(abnVel + b) / constraintMass;
 		
-		// Apply linear velocity impulse
+		// Apply linear and rotational velocity impulses, skipping static
+		// objects as they can be shared with islands solved on other threads
 
-		pnodeA->SetLinearVelocity(pnodeA->GetLinearVelocity() + abn * (pnodeA->GetInverseMass() * jn));
-		
-		pnodeB->SetLinearVelocity(pnodeB->GetLinearVelocity() - abn * (pnodeB->GetInverseMass() * jn));
-		
-		// Apply rotational velocity impulse
-
-		pnodeA->SetAngularVelocity(pnodeA->GetAngularVelocity() + pnodeA->GetInverseInertia() * Vector3::Cross(r1, abn * jn));
+		if (!pnodeA->IsStatic())
+		{
+			pnodeA->SetLinearVelocity(pnodeA->GetLinearVelocity() + abn * (pnodeA->GetInverseMass() * jn));
+			pnodeA->SetAngularVelocity(pnodeA->GetAngularVelocity() + pnodeA->GetInverseInertia() * Vector3::Cross(r1, abn * jn));
+		}
 
-		pnodeB->SetAngularVelocity(pnodeB->GetAngularVelocity() - pnodeB->GetInverseInertia() * Vector3::Cross(r2, abn * jn));
+		if (!pnodeB->IsStatic())
+		{
+			pnodeB->SetLinearVelocity(pnodeB->GetLinearVelocity() - abn * (pnodeB->GetInverseMass() * jn));
+			pnodeB->SetAngularVelocity(pnodeB->GetAngularVelocity() - pnodeB->GetInverseInertia() * Vector3::Cross(r2, abn * jn));
+		}
 	}
 }
\ No newline at end of file
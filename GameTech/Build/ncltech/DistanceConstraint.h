@@ -18,7 +18,7 @@ Description:
 
 #include "Constraint.h"
 #include "PhysicsEngine.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 
 class DistanceConstraint : public Constraint
 {
@@ -49,6 +49,9 @@ public:
 	// objects in order to satisfy the constraint.
 	virtual void ApplyImpulse() override;
 
+	virtual PhysicsNode* GetNodeA() const override { return pnodeA; }
+	virtual PhysicsNode* GetNodeB() const override { return pnodeB; }
+
 	//Draw the constraint visually to the screen for debugging
 	virtual void DebugDraw() const
 	{
@@ -14,8 +14,8 @@ position/orientation each frame.
 
 *//////////////////////////////////////////////////////////////////////////////
 #pragma once
-#include <nclgl\Matrix4.h>
-#include <nclgl\RenderNode.h>
+#include <nclgl/Matrix4.h>
+#include <nclgl/RenderNode.h>
 #include "GraphicsPipeline.h"
 #include "PhysicsEngine.h"
 #include "PhysicsNode.h"
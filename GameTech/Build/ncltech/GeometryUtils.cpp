@@ -1,5 +1,8 @@
 #include "GeometryUtils.h"
-#include <nclgl\common.h>
+#include <nclgl/common.h>
+#include <nclgl/NCLDebug.h>
+#include <algorithm>
+#include <cfloat>
 
 // Gets the closest point x on the line (edge) to point (pos)
 Vector3 GeometryUtils::GetClosestPoint(
@@ -36,14 +39,19 @@ Vector3 GeometryUtils::GetClosestPoint(
 // resides on any of the given edges of the polygon.
 Vector3 GeometryUtils::GetClosestPointPolygon(
 	const Vector3& pos,
-	const std::list<Vector3>& polygon)
+	const Vector3* polygon,
+	int num_verts)
 {
 	Vector3 final_closest_point = Vector3(0.0f, 0.0f, 0.0f);
 	float final_closest_distsq = FLT_MAX;
 
-	Vector3 last = polygon.back();
-	for (const Vector3& next : polygon)
+	if (num_verts == 0)
+		return final_closest_point;
+
+	Vector3 last = polygon[num_verts - 1];
+	for (int i = 0; i < num_verts; ++i)
 	{
+		const Vector3& next = polygon[i];
 
 		Vector3 edge_closest_point = GetClosestPoint(pos, GeometryUtils::Edge(last, next));
 
@@ -128,82 +136,93 @@ bool GeometryUtils::PlaneEdgeIntersection(
 
 //Performs sutherland hodgman clipping algorithm to clip the provided mesh
 //    or polygon in regards to each of the provided clipping planes.
-void GeometryUtils::SutherlandHodgmanClipping(
-	const std::list<Vector3>& input_polygon,
+int GeometryUtils::SutherlandHodgmanClipping(
+	Vector3* polygon,
+	int num_verts,
 	int num_clip_planes,
 	const Plane* clip_planes,
-	std::list<Vector3>* out_polygon,
+	Vector3* scratch,
 	bool removeNotClipToPlane)
 {
-	if (!out_polygon)
-		return;
-
-	if (num_clip_planes == 0)
-		*out_polygon = input_polygon;
-
-	//Create temporary list of vertices
-	// - We will keep ping-pong'ing between the two lists updating them as we go.
-	std::list<Vector3> ppPolygon1, ppPolygon2;
-	std::list<Vector3> *input = &ppPolygon1, *output = &ppPolygon2;
-
-	*input = input_polygon;
-
+	//We will keep ping-pong'ing between the two buffers updating them as we go,
+	// so nothing is allocated or copied until the very end
+	Vector3 *input = polygon, *output = scratch;
+	int num_input = num_verts;
 
 	//Iterate over each clip_plane provided
 	for (int i = 0; i < num_clip_planes; ++i)
 	{
 		//If every single point on our shape has already been removed previously, just exit
-		if (input->empty())
+		if (num_input == 0)
 			break;
 
 		const Plane& plane = clip_planes[i];
+		int num_output = 0;
 
 		//Loop through each edge of the polygon (see line_loop from gfx) and clip
 		// that edge against the current plane.
-		Vector3 tempPoint, startPoint = input->back();
-		for (const Vector3& endPoint : *input)
+		Vector3 tempPoint, startPoint = input[num_input - 1];
+		bool startInPlane = plane.PointInPlane(startPoint);
+		for (int j = 0; j < num_input; ++j)
 		{
-			bool startInPlane = plane.PointInPlane(startPoint);
+			const Vector3 endPoint = input[j];
 			bool endInPlane = plane.PointInPlane(endPoint);
 
+			//A face of MAX_CLIP_PLANES vertices clipped by as many planes always fits,
+			// so running out of room means a shape has handed out a bigger one
+			int num_added = removeNotClipToPlane ? (endInPlane ? 1 : 0)
+				: (startInPlane != endInPlane ? 1 : 0) + (endInPlane ? 1 : 0);
+			if (num_output + num_added > MAX_POLYGON_VERTICES)
+			{
+				NCLERROR("SutherlandHodgmanClipping: Clipped polygon has more than %d vertices, the rest are dropped", MAX_POLYGON_VERTICES);
+				break;
+			}
+
 			//If it's the final pass, just remove all points outside the reference plane
 			// - This won't return a true polygon if set, but is needed for the last step
 			//   we do in the manifold generation
 			if (removeNotClipToPlane)
 			{
 				if (endInPlane)
-					output->push_back(endPoint);
+					output[num_output++] = endPoint;
 			}
 			else
 			{
 				//If the edge is entirely within the clipping plane, keep it as it is
 				if (startInPlane && endInPlane)
 				{
-					output->push_back(endPoint);
+					output[num_output++] = endPoint;
 				}
 				//If the edge interesects the clipping plane, cut the edge along clip plane
 				else if (startInPlane && !endInPlane)
 				{
 					if (PlaneEdgeIntersection(plane, startPoint, endPoint, tempPoint))
-						output->push_back(tempPoint);
+						output[num_output++] = tempPoint;
 				}
 				else if (!startInPlane && endInPlane)
 				{
 					if (PlaneEdgeIntersection(plane, startPoint, endPoint, tempPoint))
-						output->push_back(tempPoint);
+						output[num_output++] = tempPoint;
 
-					output->push_back(endPoint);
+					output[num_output++] = endPoint;
 				}
 			}
 			//..otherwise the edge is entirely outside the clipping plane and should be removed/ignored
 
 			startPoint = endPoint;
+			startInPlane = endInPlane;
 		}
 
-		//Swap input/output polygons, and clear output list for us to generate afresh
+		//Swap input/output buffers, the output is overwritten on the next pass
 		std::swap(input, output);
-		output->clear();
+		num_input = num_output;
 	}
 
-	*out_polygon = *input;
-}
\ No newline at end of file
+	//Make sure the result ends up back in the caller's polygon
+	if (input != polygon)
+	{
+		for (int i = 0; i < num_input; ++i)
+			polygon[i] = input[i];
+	}
+	return num_input;
+}
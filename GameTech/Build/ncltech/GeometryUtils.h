@@ -1,11 +1,41 @@
 #pragma once
-#include <nclgl\Vector3.h>
-#include <nclgl\Plane.h>
-#include <list>
+#include <nclgl/Vector3.h>
+#include <nclgl/Plane.h>
 #include <vector>
+#include <cassert>
+
+//Capacity of the fixed size buffers used during contact generation. Clipping
+// can add at most one vertex to a polygon for each plane it is clipped by, so
+// shapes keep their faces to MAX_CLIP_PLANES vertices (one plane per edge).
+#define MAX_POLYGON_VERTICES	64
+#define MAX_CLIP_PLANES			32
 
 namespace GeometryUtils
 {
+	//Write access to the end of a fixed size array owned by the caller, e.g. the
+	// stack buffers polygons are built in during contact generation.
+	// - Pushing to it once it is full asserts, release builds drop the value and
+	//   set overflowed for the caller to report
+	template <typename T>
+	struct OutputSpan
+	{
+		OutputSpan(T* data, int capacity) : data(data), size(0), capacity(capacity), overflowed(false) {}
+
+		inline void push_back(const T& value)
+		{
+			assert(size < capacity && "OutputSpan is full");
+			if (size < capacity) data[size++] = value;
+			else overflowed = true;
+		}
+		inline void clear()						{ size = 0; overflowed = false; }
+		inline bool empty() const				{ return size == 0; }
+
+		T*		data;
+		int		size;
+		int		capacity;
+		bool	overflowed;
+	};
+
 	struct Edge
 	{
 		Edge() : _v0(0.0f, 0.0f, 0.0f) , _v1(0.0f, 0.0f, 0.0f) {}
@@ -28,7 +58,8 @@ namespace GeometryUtils
 	// resides on any of the given edges of the polygon.
 	Vector3 GetClosestPointPolygon(
 		const Vector3& pos,
-		const std::list<Vector3>& polygon);
+		const Vector3* polygon,
+		int num_verts);
 
 	// Iterates through all edges returning the the point X which is the closest
 	//   point along any of the given edges to the provided point A as possible.
@@ -48,10 +79,14 @@ namespace GeometryUtils
 	//Performs sutherland hodgman clipping algorithm to clip the provided polygon
 	// in regards to each of the provided clipping planes.
 	// https://en.wikipedia.org/wiki/Sutherland%E2%80%93Hodgman_algorithm
-	void SutherlandHodgmanClipping(
-		const std::list<Vector3>& input_polygon,
+	// - The polygon is clipped in place, ping-pong'ing with the scratch buffer,
+	//   both of which must hold MAX_POLYGON_VERTICES
+	// - Returns the number of vertices left in the polygon
+	int SutherlandHodgmanClipping(
+		Vector3* polygon,
+		int num_verts,
 		int num_clip_planes,
 		const Plane* clip_planes,
-		std::list<Vector3>* out_polygon,
+		Vector3* scratch,
 		bool removeNotClipToPlane);
 };
\ No newline at end of file
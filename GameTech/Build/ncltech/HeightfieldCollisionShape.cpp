@@ -0,0 +1,255 @@
+#include "HeightfieldCollisionShape.h"
+#ifndef NCLTECH_HEADLESS
+#include <nclgl/HeightMap.h>
+#endif
+#include <nclgl/Matrix3.h>
+#include <nclgl/NCLDebug.h>
+#include <cfloat>
+
+#ifndef NCLTECH_HEADLESS
+HeightfieldCollisionShape::HeightfieldCollisionShape(const HeightMap* heightmap)
+	: CollisionShape(COLLISIONSHAPE_HEIGHTFIELD)
+{
+	uint width = heightmap ? heightmap->GetRawWidth() : 0;
+	uint height = heightmap ? heightmap->GetRawHeight() : 0;
+	if (width < 2 || height < 2 || !heightmap->vertices)
+	{
+		NCLERROR("HeightfieldCollisionShape: Height map has no samples");
+		Build(NULL, 0, 0, 1.0f, 1.0f);
+		return;
+	}
+
+	//Vertex (x, z) is at vertices[x * rawWidth + z], see HeightMap
+	std::vector<float> samples(width * height);
+	for (uint x = 0; x < width; ++x)
+	{
+		for (uint z = 0; z < height; ++z)
+			samples[x * height + z] = heightmap->vertices[x * width + z].y;
+	}
+
+	const Vector3& origin = heightmap->vertices[0];
+	Build(&samples[0], width, height,
+		heightmap->vertices[width].x - origin.x,
+		heightmap->vertices[1].z - origin.z);
+}
+#endif
+
+HeightfieldCollisionShape::HeightfieldCollisionShape(const float* heights, uint numX, uint numZ, float cellSizeX, float cellSizeZ)
+	: CollisionShape(COLLISIONSHAPE_HEIGHTFIELD)
+{
+	Build(heights, numX, numZ, cellSizeX, cellSizeZ);
+}
+
+HeightfieldCollisionShape::~HeightfieldCollisionShape()
+{
+
+}
+
+void HeightfieldCollisionShape::Build(const float* in_heights, uint in_numX, uint in_numZ, float in_cellSizeX, float in_cellSizeZ)
+{
+	if (!in_heights || in_numX < 2 || in_numZ < 2)
+		in_numX = in_numZ = 0;
+
+	numX = in_numX;
+	numZ = in_numZ;
+	cellSizeX = in_cellSizeX;
+	cellSizeZ = in_cellSizeZ;
+	heights.assign(in_heights, in_heights + numX * numZ);
+	sizeX = (numX > 0) ? (numX - 1) * cellSizeX : 0.0f;
+	sizeZ = (numZ > 0) ? (numZ - 1) * cellSizeZ : 0.0f;
+
+	minHeight = maxHeight = 0.0f;
+	if (!heights.empty())
+	{
+		minHeight = maxHeight = heights[0];
+		for (float h : heights)
+		{
+			minHeight = min(minHeight, h);
+			maxHeight = max(maxHeight, h);
+		}
+	}
+
+	wsCentre = Vector3(0.0f, 0.0f, 0.0f);
+	wsAxes[0] = Vector3(1.0f, 0.0f, 0.0f);
+	wsAxes[1] = Vector3(0.0f, 1.0f, 0.0f);
+	wsAxes[2] = Vector3(0.0f, 0.0f, 1.0f);
+	UpdateWorldSpaceCache();
+}
+
+void HeightfieldCollisionShape::GetWorldTriangle(int tri, Vector3& out_a, Vector3& out_b, Vector3& out_c) const
+{
+	uint cell = tri / 2;
+	uint x = cell / (numZ - 1);
+	uint z = cell % (numZ - 1);
+
+	//Same winding as HeightMap's triangles
+	if (tri % 2 == 0)
+	{
+		out_a = ToWorld(GetLocalVertex(x + 1, z + 1));
+		out_b = ToWorld(GetLocalVertex(x + 1, z));
+		out_c = ToWorld(GetLocalVertex(x, z));
+	}
+	else
+	{
+		out_a = ToWorld(GetLocalVertex(x, z));
+		out_b = ToWorld(GetLocalVertex(x, z + 1));
+		out_c = ToWorld(GetLocalVertex(x + 1, z + 1));
+	}
+}
+
+int HeightfieldCollisionShape::FindOverlappingTriangles(const CollisionShape* other, int* out_triangles, int max_triangles) const
+{
+	if (heights.empty())
+		return 0;
+
+	//Bounds of the other shape along each of our local axes
+	float qMin[3], qMax[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		float centre = Vector3::Dot(wsAxes[i], wsCentre);
+		qMin[i] = Vector3::Dot(other->GetSupportPoint(-wsAxes[i]), wsAxes[i]) - centre;
+		qMax[i] = Vector3::Dot(other->GetSupportPoint(wsAxes[i]), wsAxes[i]) - centre;
+	}
+
+	if (qMin[1] > maxHeight || qMax[1] < minHeight)
+		return 0;
+
+	//Range of cells under the bounds, straight from the cell size
+	int x0 = max((int)floorf(qMin[0] / cellSizeX), 0);
+	int x1 = min((int)floorf(qMax[0] / cellSizeX), (int)numX - 2);
+	int z0 = max((int)floorf(qMin[2] / cellSizeZ), 0);
+	int z1 = min((int)floorf(qMax[2] / cellSizeZ), (int)numZ - 2);
+
+	int numFound = 0;
+	for (int x = x0; x <= x1; ++x)
+	{
+		for (int z = z0; z <= z1; ++z)
+		{
+			float h00 = heights[x * numZ + z];
+			float h10 = heights[(x + 1) * numZ + z];
+			float h01 = heights[x * numZ + z + 1];
+			float h11 = heights[(x + 1) * numZ + z + 1];
+
+			//Both triangles share the (x, z) - (x + 1, z + 1) diagonal
+			float diagMin = min(h00, h11), diagMax = max(h00, h11);
+			int tri = (x * (numZ - 1) + z) * 2;
+
+			//Carries on counting once the buffer is full
+			if (min(diagMin, h10) <= qMax[1] && max(diagMax, h10) >= qMin[1])
+			{
+				if (numFound < max_triangles) out_triangles[numFound] = tri;
+				++numFound;
+			}
+
+			if (min(diagMin, h01) <= qMax[1] && max(diagMax, h01) >= qMin[1])
+			{
+				if (numFound < max_triangles) out_triangles[numFound] = tri + 1;
+				++numFound;
+			}
+		}
+	}
+
+	return numFound;
+}
+
+float HeightfieldCollisionShape::GetBoundingRadius() const
+{
+	float maxY = max(fabs(minHeight), fabs(maxHeight));
+	return sqrtf(sizeX * sizeX + maxY * maxY + sizeZ * sizeZ);
+}
+
+void HeightfieldCollisionShape::UpdateWorldSpaceCache()
+{
+	Matrix3 rot;
+	wsCentre = Vector3(0.0f, 0.0f, 0.0f);
+	if (Parent())
+	{
+		rot = Parent()->GetOrientation().ToMatrix3();
+		wsCentre = Parent()->GetPosition();
+	}
+
+	for (int i = 0; i < 3; ++i)
+		wsAxes[i] = rot.GetCol(i);
+}
+
+Matrix3 HeightfieldCollisionShape::BuildInverseInertia(float invMass) const
+{
+	return Matrix3::ZeroMatrix;
+}
+
+void HeightfieldCollisionShape::GetCollisionAxes(
+	const PhysicsNode* otherObject,
+	std::vector<Vector3>& out_axes) const
+{
+	for (int i = 0; i < 3; ++i)
+		out_axes.push_back(wsAxes[i]);
+}
+
+Vector3 HeightfieldCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	//Clamped in to the bounding box, in local space
+	Vector3 local = point - wsCentre;
+	float x = min(max(Vector3::Dot(local, wsAxes[0]), 0.0f), sizeX);
+	float y = min(max(Vector3::Dot(local, wsAxes[1]), minHeight), maxHeight);
+	float z = min(max(Vector3::Dot(local, wsAxes[2]), 0.0f), sizeZ);
+	return ToWorld(Vector3(x, y, z));
+}
+
+void HeightfieldCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	float minCorrelation = FLT_MAX, maxCorrelation = -FLT_MAX;
+	out_min = out_max = wsCentre;
+	for (int i = 0; i < 8; ++i)
+	{
+		Vector3 corner = ToWorld(Vector3(
+			(i & 1) ? sizeX : 0.0f,
+			(i & 2) ? maxHeight : minHeight,
+			(i & 4) ? sizeZ : 0.0f));
+
+		float correlation = Vector3::Dot(axis, corner);
+		if (correlation < minCorrelation)
+		{
+			minCorrelation = correlation;
+			out_min = corner;
+		}
+		if (correlation > maxCorrelation)
+		{
+			maxCorrelation = correlation;
+			out_max = corner;
+		}
+	}
+}
+
+Vector3 HeightfieldCollisionShape::GetSupportPoint(const Vector3& axis) const
+{
+	Vector3 out_min, out_max;
+	GetMinMaxVertexOnAxis(axis, out_min, out_max);
+	return out_max;
+}
+
+void HeightfieldCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	OutputSpan<Vector3>& out_face,
+	Vector3& out_normal,
+	OutputSpan<Plane>& out_adjacent_planes) const
+{
+	out_face.push_back(GetSupportPoint(axis));
+	out_normal = axis;
+}
+
+void HeightfieldCollisionShape::DebugDraw() const
+{
+	//Just the grid, without each cell's diagonal
+	for (uint x = 0; x + 1 < numX; ++x)
+	{
+		for (uint z = 0; z + 1 < numZ; ++z)
+		{
+			Vector3 v = ToWorld(GetLocalVertex(x, z));
+			NCLDebug::DrawThickLineNDT(v, ToWorld(GetLocalVertex(x + 1, z)), 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
+			NCLDebug::DrawThickLineNDT(v, ToWorld(GetLocalVertex(x, z + 1)), 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
+		}
+	}
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+Class: HeightfieldCollisionShape
+Implements: CollisionShape
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Extends CollisionShape to collide against terrain, straight from the samples
+	of a HeightMap (or any other regular grid of heights), without turning it in
+	to boxes or a TriangleMeshCollisionShape first.
+
+	The grid starts at the node's origin and runs along its local x and z axes,
+	with each cell split in to the same two triangles HeightMap renders. As the
+	cells are evenly spaced, the ones under a body are found just by dividing the
+	body's bounds by the cell size, so there is nothing to search and terrain
+	collision costs the same however large the terrain is. Only those cells'
+	triangles (skipping any entirely above or below the body) are then tested,
+	through CollisionDispatch in exactly the same way as a triangle mesh's.
+
+	Only one float per sample is kept, copied from the height map's vertices, so
+	the render mesh can be freed or changed independently.
+
+	The heightfield must be static (inverse mass of zero), and the node's bounding
+	radius set to enclose it (see GetBoundingRadius).
+
+	Note: Every triangle under a body is tested, so a body covering lots of cells
+	costs that much more, and cells shouldn't be made much smaller than the
+	bodies resting on them.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionShape.h"
+#include "PhysicsNode.h"
+
+class HeightMap;
+
+class HeightfieldCollisionShape : public CollisionShape
+{
+public:
+#ifndef NCLTECH_HEADLESS
+	// Uses the height map's samples, at the spacing it was built with
+	HeightfieldCollisionShape(const HeightMap* heightmap);
+#endif
+
+	// Builds the grid from numX * numZ heights, where heights[x * numZ + z] is at
+	// (x * cellSizeX, heights[...], z * cellSizeZ)
+	HeightfieldCollisionShape(const float* heights, uint numX, uint numZ, float cellSizeX, float cellSizeZ);
+	virtual ~HeightfieldCollisionShape();
+
+	inline uint GetNumSamplesX() const						{ return numX; }
+	inline uint GetNumSamplesZ() const						{ return numZ; }
+	inline float GetHeight(uint x, uint z) const			{ return heights[x * numZ + z]; }
+
+	// Gets the triangle's vertices in world space, as of the node's last move
+	//  - Each cell (x, z) holds triangles (x * (numZ - 1) + z) * 2 and the one after
+	void GetWorldTriangle(int tri, Vector3& out_a, Vector3& out_b, Vector3& out_c) const;
+
+	// Finds the triangles under the bounds of the other shape (at its current
+	// world transform), writing up to max_triangles of them
+	// - Returns how many are under it, which is more than were written if the
+	//   buffer was too small, so the caller can grow it and query again
+	int FindOverlappingTriangles(const CollisionShape* other, int* out_triangles, int max_triangles) const;
+
+	// Distance of the furthest corner from the node's centre, to be used as its bounding radius
+	float GetBoundingRadius() const;
+
+	// Caches the parent node's transform for GetWorldTriangle and the overlap queries
+	virtual void UpdateWorldSpaceCache() override;
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+
+	// Terrain is only ever static
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	//  - These all treat the heightfield as its bounding box, and are only used by
+	//    anything that bypasses CollisionDispatch
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual Vector3 GetSupportPoint(const Vector3& axis) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		OutputSpan<Vector3>& out_face,
+		Vector3& out_normal,
+		OutputSpan<Plane>& out_adjacent_planes) const override;
+
+protected:
+	void Build(const float* in_heights, uint in_numX, uint in_numZ, float in_cellSizeX, float in_cellSizeZ);
+
+	inline Vector3 GetLocalVertex(uint x, uint z) const		{ return Vector3(x * cellSizeX, heights[x * numZ + z], z * cellSizeZ); }
+	inline Vector3 ToWorld(const Vector3& local) const		{ return wsCentre + wsAxes[0] * local.x + wsAxes[1] * local.y + wsAxes[2] * local.z; }
+
+protected:
+	std::vector<float>	heights;
+	uint				numX, numZ;
+	float				cellSizeX, cellSizeZ;
+	float				sizeX, sizeZ;		//Extent of the whole grid
+	float				minHeight, maxHeight;
+
+	//World space axes and centre of the parent node, as of its last move
+	Vector3				wsCentre;
+	Vector3				wsAxes[3];
+};
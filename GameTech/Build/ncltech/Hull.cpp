@@ -1,6 +1,7 @@
 #include "Hull.h"
 #include <algorithm>
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
+#include <cfloat>
 
 Hull::Hull()
 {
@@ -188,7 +189,7 @@ void Hull::RemoveFace(int faceidx)
 }
 
 
-void Hull::GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert, int* out_max_vert)
+void Hull::GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert, int* out_max_vert) const
 {
 	float cCorrelation;
 	int minVertex, maxVertex;
@@ -217,10 +218,10 @@ void Hull::GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert,
 }
 
 
-void Hull::DebugDraw(const Matrix4& transform)
+void Hull::DebugDraw(const Matrix4& transform) const
 {
 	//Draw all Hull Polygons
-	for (HullFace& face : m_vFaces)
+	for (const HullFace& face : m_vFaces)
 	{
 		//Render Polygon as triangle fan
 		if (face._vert_ids.size() > 2)
@@ -239,7 +240,7 @@ void Hull::DebugDraw(const Matrix4& transform)
 	}
 
 	//Draw all Hull Edges
-	for (HullEdge& edge : m_vEdges)
+	for (const HullEdge& edge : m_vEdges)
 	{
 		NCLDebug::DrawThickLineNDT(transform * m_vVertices[edge._vStart]._pos, transform * m_vVertices[edge._vEnd]._pos, 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
 	}
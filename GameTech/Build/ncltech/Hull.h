@@ -24,8 +24,8 @@ Description:
 
 #pragma once
 
-#include <nclgl\Vector3.h>
-#include <nclgl\Matrix4.h>
+#include <nclgl/Vector3.h>
+#include <nclgl/Matrix4.h>
 #include <vector>
 
 struct HullEdge;
@@ -65,14 +65,14 @@ public:
 	Hull();
 	~Hull();
 
-	void DebugDraw(const Matrix4& transform);
+	void DebugDraw(const Matrix4& transform) const;
 	void Clear();
 
 
 	int AddVertex(const Vector3& v);
 
 	int AddFace(const Vector3& _normal, int nVerts, const int* verts);
-	int AddFace(const Vector3& _normal, const std::vector<int>& vert_ids)		{ AddFace(_normal, (int)vert_ids.size(), &vert_ids[0]); }
+	int AddFace(const Vector3& _normal, const std::vector<int>& vert_ids)		{ return AddFace(_normal, (int)vert_ids.size(), &vert_ids[0]); }
 
 	
 	void RemoveFace(int faceidx);
@@ -82,16 +82,16 @@ public:
 	int FindEdge(int v0_idx, int v1_idx);
 	
 
-	const HullVertex& GetVertex(int idx)		{ return m_vVertices[idx]; }
-	const HullEdge& GetEdge(int idx)			{ return m_vEdges[idx]; }
-	const HullFace& GetFace(int idx)			{ return m_vFaces[idx]; }
+	const HullVertex& GetVertex(int idx) const	{ return m_vVertices[idx]; }
+	const HullEdge& GetEdge(int idx) const		{ return m_vEdges[idx]; }
+	const HullFace& GetFace(int idx) const		{ return m_vFaces[idx]; }
 
-	size_t GetNumVertices()					{ return m_vVertices.size(); }
-	size_t GetNumEdges()					{ return m_vEdges.size(); }
-	size_t GetNumFaces()					{ return m_vFaces.size(); }
+	size_t GetNumVertices() const			{ return m_vVertices.size(); }
+	size_t GetNumEdges() const				{ return m_vEdges.size(); }
+	size_t GetNumFaces() const				{ return m_vFaces.size(); }
 
 
-	void GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert, int* out_max_vert);
+	void GetMinMaxVerticesInAxis(const Vector3& local_axis, int* out_min_vert, int* out_max_vert) const;
 
 	int ConstructNewEdge(int parent_face_idx, int vert_start, int vert_end); //Called by AddFace
 	
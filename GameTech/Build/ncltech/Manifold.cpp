@@ -1,12 +1,14 @@
 #include "Manifold.h"
-#include <nclgl\Matrix3.h>
-#include <nclgl\NCLDebug.h>
+#include <nclgl/Matrix3.h>
+#include <nclgl/NCLDebug.h>
 #include "PhysicsEngine.h"
 #include <algorithm>
+#include <cfloat>
 
 Manifold::Manifold() 
 	: pnodeA(NULL)
 	, pnodeB(NULL)
+	, lastUsedStep(0)
 {
 }
 
@@ -17,12 +19,22 @@ Manifold::~Manifold()
 
 void Manifold::Initiate(PhysicsNode* nodeA, PhysicsNode* nodeB)
 {
+	//Pooled manifolds keep their storage, so this only allocates for new ones
 	contactPoints.clear();
+	prevContactPoints.clear();
+	contactPoints.reserve(MANIFOLD_RESERVED_CONTACTS);
+	prevContactPoints.reserve(MANIFOLD_RESERVED_CONTACTS);
 
 	pnodeA = nodeA;
 	pnodeB = nodeB;
 }
 
+void Manifold::BeginNewStep()
+{
+	prevContactPoints.swap(contactPoints);
+	contactPoints.clear();
+}
+
 void Manifold::ApplyImpulse()
 {
 	for (ContactPoint& contact : contactPoints)
@@ -52,24 +64,16 @@ void Manifold::SolveContactPoint(ContactPoint& c)
 
 	if (constraintMass > 0.0f)
 	{
-		float jn = max(-Vector3::Dot(dv, c.colNormal) + c.b_term, 0.0f);
+		float jn = -Vector3::Dot(dv, c.colNormal) + c.b_term;
 		jn = jn / constraintMass;
 
+		//Only the total may not pull the objects together, so this step's impulse
+		// can be negative to take back some of what was warm started
 		float oldSumImpulseContact = c.sumImpulseContact;
 		c.sumImpulseContact = max(c.sumImpulseContact + jn, 0.0f);
 		jn = c.sumImpulseContact - oldSumImpulseContact;
 
-		pnodeA->SetLinearVelocity(pnodeA->GetLinearVelocity()
-			- c.colNormal *(jn * pnodeA->GetInverseMass()));
-		pnodeB->SetLinearVelocity(pnodeB->GetLinearVelocity()
-			+ c.colNormal *(jn * pnodeB->GetInverseMass()));
-
-		pnodeA->SetAngularVelocity(pnodeA->GetAngularVelocity()
-			- pnodeA->GetInverseInertia()
-			* Vector3::Cross(r1, c.colNormal * jn));
-		pnodeB->SetAngularVelocity(pnodeB->GetAngularVelocity()
-			+ pnodeB->GetInverseInertia()
-			* Vector3::Cross(r2, c.colNormal * jn));
+		ApplyContactImpulse(c, c.colNormal * jn);
 	}
 
 	// Friction
@@ -102,40 +106,63 @@ void Manifold::SolveContactPoint(ContactPoint& c)
 			if (len > 0.0f && len > c.sumImpulseContact)
 				c.sumImpulseFriction = c.sumImpulseFriction / len * c.sumImpulseContact;
 	
-			tangent = c.sumImpulseFriction - oldImpulseFriction;
-			jt = 1.0f;
-
+			ApplyContactImpulse(c, c.sumImpulseFriction - oldImpulseFriction);
+		}
+	}
+}
 
-			pnodeA->SetLinearVelocity(pnodeA->GetLinearVelocity()
-				- tangent *(jt * pnodeA->GetInverseMass()));
-			pnodeB->SetLinearVelocity(pnodeB->GetLinearVelocity()
-				+ tangent *(jt * pnodeB->GetInverseMass()));
+void Manifold::ApplyContactImpulse(const ContactPoint& c, const Vector3& impulse)
+{
+	//Static objects are shared between islands being solved in parallel, so
+	// they must never be written to (the impulse would do nothing anyway)
+	if (!pnodeA->IsStatic())
+	{
+		pnodeA->SetLinearVelocity(pnodeA->GetLinearVelocity()
+			- impulse * pnodeA->GetInverseMass());
+		pnodeA->SetAngularVelocity(pnodeA->GetAngularVelocity()
+			- pnodeA->GetInverseInertia()
+			* Vector3::Cross(c.relPosA, impulse));
+	}
 
-			pnodeA->SetAngularVelocity(pnodeA->GetAngularVelocity()
-				- pnodeA->GetInverseInertia()
-				* Vector3::Cross(r1, tangent * jt));
-			pnodeB->SetAngularVelocity(pnodeB->GetAngularVelocity()
-				+ pnodeB->GetInverseInertia()
-				* Vector3::Cross(r2, tangent * jt));
-		}
+	if (!pnodeB->IsStatic())
+	{
+		pnodeB->SetLinearVelocity(pnodeB->GetLinearVelocity()
+			+ impulse * pnodeB->GetInverseMass());
+		pnodeB->SetAngularVelocity(pnodeB->GetAngularVelocity()
+			+ pnodeB->GetInverseInertia()
+			* Vector3::Cross(c.relPosB, impulse));
 	}
 }
 
 void Manifold::PreSolverStep(float dt)
 {
-	std::random_shuffle(contactPoints.begin(), contactPoints.end());
+	if (PhysicsEngine::Instance()->Deterministic())
+		std::shuffle(contactPoints.begin(), contactPoints.end(), PhysicsEngine::Instance()->GetShuffleGenerator());
+	else
+		std::random_shuffle(contactPoints.begin(), contactPoints.end());
 
 	for (ContactPoint& contact : contactPoints)
 	{
 		UpdateConstraint(contact);
 	}
+
+	//Warm start - reapply last step's impulses for any contacts that persisted. This
+	// has to happen after all the elasticity terms are computed from the incoming velocities.
+	for (ContactPoint& contact : contactPoints)
+	{
+		ApplyContactImpulse(contact, contact.colNormal * contact.sumImpulseContact + contact.sumImpulseFriction);
+	}
 }
 
 void Manifold::UpdateConstraint(ContactPoint& c)
 {
-	//Reset total impulse forces computed this physics timestep 
-	c.sumImpulseContact = 0.0f;
-	c.sumImpulseFriction = Vector3(0.0f, 0.0f, 0.0f);
+	//Total impulses are carried over from last step by AddContact (or zero for
+	// new contacts), so they only need resetting if warm starting is turned off
+	if (!PhysicsEngine::Instance()->WarmStarting())
+	{
+		c.sumImpulseContact = 0.0f;
+		c.sumImpulseFriction = Vector3(0.0f, 0.0f, 0.0f);
+	}
 	c.b_term = 0.0f;
 
 	/* TUTORIAL 6 CODE */
@@ -195,19 +222,46 @@ void Manifold::AddContact(const Vector3& globalOnA, const Vector3& globalOnB, co
 	contact.colNormal.Normalise();
 	contact.colPenetration = penetration;
 
-	contactPoints.push_back(contact);
+	contact.localPosA = Matrix3::Transpose(pnodeA->GetOrientation().ToMatrix3()) * r1;
+	contact.localPosB = Matrix3::Transpose(pnodeB->GetOrientation().ToMatrix3()) * r2;
 
+	contact.sumImpulseContact = 0.0f;
+	contact.sumImpulseFriction = Vector3(0.0f, 0.0f, 0.0f);
 
-	//What a stupid function!
-	// - Manifold's normally persist over multiple frames, as in two colliding objects
-	//   (especially in the case of stacking) will likely be colliding in a similar 
-	//   setup the following couple of frames. So the accuracy therefore can be increased
-	//   by using persistent manifolds, which will only be deleted when the two objects
-	//   fail a narrowphase check. This means the manifolds can be quite busy, with lots of
-	//   new contacts per frame, but to solve any convex manifold in 3D you really only need
-	//   3 contacts (4 max), so tldr; perhaps you want persistent manifolds.. perhaps
-	//   you want to put some code here to sort contact points.. perhaps this comment is even 
-	//   more pointless than a passthrough function.. perhaps I should just stop typ
+	//Find the closest of last step's contacts that is still in (roughly) the same
+	// place on both objects, and carry on from the impulse it finished with
+	const float matchDistSq = MANIFOLD_CONTACT_MATCH_DIST * MANIFOLD_CONTACT_MATCH_DIST;
+	int match = -1;
+	float matchScore = FLT_MAX;
+	for (size_t i = 0; i < prevContactPoints.size(); ++i)
+	{
+		const ContactPoint& prev = prevContactPoints[i];
+		Vector3 dA = prev.localPosA - contact.localPosA;
+		Vector3 dB = prev.localPosB - contact.localPosB;
+		float distA = Vector3::Dot(dA, dA);
+		float distB = Vector3::Dot(dB, dB);
+		if (distA < matchDistSq && distB < matchDistSq && distA + distB < matchScore)
+		{
+			match = (int)i;
+			matchScore = distA + distB;
+		}
+	}
+
+	if (match >= 0)
+	{
+		const ContactPoint& prev = prevContactPoints[match];
+		contact.sumImpulseContact = prev.sumImpulseContact;
+
+		//The normal may have tilted slightly, so keep the friction in the contact plane
+		contact.sumImpulseFriction = prev.sumImpulseFriction
+			- contact.colNormal * Vector3::Dot(prev.sumImpulseFriction, contact.colNormal);
+
+		//Each old contact can only be matched once
+		prevContactPoints[match] = prevContactPoints.back();
+		prevContactPoints.pop_back();
+	}
+
+	contactPoints.push_back(contact);
 }
 
 void Manifold::DebugDraw() const
@@ -14,12 +14,26 @@ Description:
 	additional constraints of friction and also elasticity in the form of a bias term to add
 	additional energy to the system (elasticity) or negate existing velocity (friction).
 
+	Manifolds are kept by the physics engine for as long as the two objects stay
+	in contact. Each step the new contacts are matched against last step's by their
+	position relative to each object, and any that match start the solver off with
+	the impulses from the previous step (warm starting) rather than from zero.
+
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
 
 #include "PhysicsNode.h"
-#include <nclgl\Vector3.h>
+#include <nclgl/Vector3.h>
+#include <vector>
+
+//Max distance (in each object's local space) a contact can move between
+// steps and still be treated as the same contact for warm starting
+#define MANIFOLD_CONTACT_MATCH_DIST	0.05f
+
+//Contacts reserved when a manifold is handed out by the pool, enough for two box
+// faces clipped against each other, so most never grow while they're in use
+#define MANIFOLD_RESERVED_CONTACTS	8
 
 /* A contact constraint is actually the summation of a distance constraint to handle the main collision (normal)
    along with two friction constraints going along the axes perpendicular to the collision
@@ -38,6 +52,9 @@ struct ContactPoint
 	Vector3 relPosA;			//Position relative to objectA
 	Vector3 relPosB;			//Position relative to objectB
 
+	Vector3 localPosA;			//Position in objectA's local space (rotation included)
+	Vector3 localPosB;			//Position in objectB's local space
+
 	//Solver - Total force added this frame
 	// - Used to clamp contact constraint over the course of the entire solver
 	//   to expected bounds.
@@ -53,9 +70,13 @@ public:
 	Manifold();
 	~Manifold();
 
-	//Initiate for collision pair
+	//Initiate for collision pair, reserving MANIFOLD_RESERVED_CONTACTS contacts
 	void Initiate(PhysicsNode* nodeA, PhysicsNode* nodeB);
 
+	//Keeps the current contacts to warm start from, and clears the manifold ready
+	// for this step's contacts to be added
+	void BeginNewStep();
+
 	//Called whenever a new collision contact between A & B are found
 	void AddContact(const Vector3& globalOnA, const Vector3& globalOnB, const Vector3& _normal, const float& _penetration);
 
@@ -75,8 +96,15 @@ protected:
 	void SolveContactPoint(ContactPoint& c);
 	void UpdateConstraint(ContactPoint& c);
 
+	//Applies an equal and opposite impulse to the two objects at the contact point
+	void ApplyContactImpulse(const ContactPoint& c, const Vector3& impulse);
+
 public:
 	PhysicsNode*				pnodeA;
 	PhysicsNode*				pnodeB;
 	std::vector<ContactPoint>	contactPoints;
+	std::vector<ContactPoint>	prevContactPoints;
+
+	//Physics step this manifold last had contacts added
+	uint						lastUsedStep;
 };
\ No newline at end of file
@@ -1,5 +1,5 @@
 #include "NetworkBase.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 
 NetworkBase::NetworkBase()
 	: m_pNetwork(NULL)
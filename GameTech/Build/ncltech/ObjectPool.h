@@ -0,0 +1,143 @@
+/******************************************************************************
+Class: ObjectPool, PoolAllocator
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Pooled allocation for things that are created and destroyed every step, so
+	that once the simulation has settled down the physics update doesn't need
+	to touch the heap at all.
+
+	ObjectPool hands out objects from pages of OBJECTPOOL_PAGE_SIZE. Released
+	objects are not destroyed, they just go back on the free list, so anything
+	they own (e.g. the contact point vectors of a Manifold) keeps its memory
+	for the next time the object is used.
+
+	PoolAllocator is an STL allocator that recycles single element allocations
+	(the nodes of std::list/std::unordered_map etc) through a free list shared
+	by every container with the same element type. Larger allocations (bucket
+	arrays) still go to the heap, but those only happen when the container grows.
+	Neither is thread safe.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+//Number of objects allocated at once whenever a pool runs out
+#define OBJECTPOOL_PAGE_SIZE	64
+
+template <typename T>
+class ObjectPool
+{
+public:
+	ObjectPool() : numInUse(0) {}
+
+	~ObjectPool()
+	{
+		for (T* page : pages)
+			delete[] page;
+	}
+
+	// Gets an unused object, which will still be in whatever state it was released in
+	T* Acquire()
+	{
+		if (freeList.empty())
+		{
+			T* page = new T[OBJECTPOOL_PAGE_SIZE];
+			pages.push_back(page);
+
+			//Reserved for every object, so releasing never has to allocate
+			freeList.reserve(pages.size() * OBJECTPOOL_PAGE_SIZE);
+			for (int i = OBJECTPOOL_PAGE_SIZE - 1; i >= 0; --i)
+				freeList.push_back(&page[i]);
+		}
+
+		T* obj = freeList.back();
+		freeList.pop_back();
+		++numInUse;
+		return obj;
+	}
+
+	void Release(T* obj)
+	{
+		freeList.push_back(obj);
+		--numInUse;
+	}
+
+	inline size_t NumInUse() const		{ return numInUse; }
+	inline size_t NumAllocated() const	{ return pages.size() * OBJECTPOOL_PAGE_SIZE; }
+
+private:
+	ObjectPool(const ObjectPool&);
+	ObjectPool& operator=(const ObjectPool&);
+
+	std::vector<T*>	pages;
+	std::vector<T*>	freeList;
+	size_t			numInUse;
+};
+
+
+template <typename T>
+struct PoolAllocator
+{
+	typedef T value_type;
+
+	PoolAllocator() {}
+	template <typename U> PoolAllocator(const PoolAllocator<U>&) {}
+
+	T* allocate(size_t n)
+	{
+		if (n != 1)
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+
+		Block*& head = FreeList();
+		if (head == NULL)
+		{
+			//Pages are kept for the lifetime of the program, as any of the
+			// blocks in them could still be in use by another container
+			Block* page = static_cast<Block*>(::operator new(OBJECTPOOL_PAGE_SIZE * sizeof(Block)));
+			for (int i = 0; i < OBJECTPOOL_PAGE_SIZE; ++i)
+				page[i].next = (i + 1 < OBJECTPOOL_PAGE_SIZE) ? &page[i + 1] : NULL;
+			head = page;
+		}
+
+		Block* block = head;
+		head = block->next;
+		return reinterpret_cast<T*>(block);
+	}
+
+	void deallocate(T* p, size_t n)
+	{
+		if (n != 1)
+		{
+			::operator delete(p);
+			return;
+		}
+
+		Block* block = reinterpret_cast<Block*>(p);
+		block->next = FreeList();
+		FreeList() = block;
+	}
+
+	template <typename U> bool operator==(const PoolAllocator<U>&) const { return true; }
+	template <typename U> bool operator!=(const PoolAllocator<U>&) const { return false; }
+
+private:
+	union Block
+	{
+		Block* next;
+		typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage;
+	};
+
+	static Block*& FreeList()
+	{
+		static Block* head = NULL;
+		return head;
+	}
+};
@@ -0,0 +1,290 @@
+#include "PhysicsBodyStorage.h"
+#include "PhysicsNode.h"
+#include <xmmintrin.h>
+#include <omp.h>
+
+static inline __m128 Select(__m128 mask, __m128 x, __m128 y)
+{
+	return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y));
+}
+
+//Each component of BODY_SIMD_WIDTH vectors in its own register, unused lanes are zero
+static inline void GatherVector3(const Vector3* src, size_t count, __m128 out[3])
+{
+	float lanes[3][BODY_SIMD_WIDTH] = {};
+	for (size_t i = 0; i < count; ++i)
+	{
+		lanes[0][i] = src[i].x;
+		lanes[1][i] = src[i].y;
+		lanes[2][i] = src[i].z;
+	}
+	for (int c = 0; c < 3; ++c)
+		out[c] = _mm_loadu_ps(lanes[c]);
+}
+
+static inline void ScatterVector3(Vector3* dst, int laneMask, const __m128 in[3])
+{
+	float lanes[3][BODY_SIMD_WIDTH];
+	for (int c = 0; c < 3; ++c)
+		_mm_storeu_ps(lanes[c], in[c]);
+
+	for (int i = 0; i < BODY_SIMD_WIDTH; ++i)
+	{
+		if (laneMask & (1 << i))
+			dst[i] = Vector3(lanes[0][i], lanes[1][i], lanes[2][i]);
+	}
+}
+
+static inline void GatherQuaternion(const Quaternion* src, size_t count, __m128 out[4])
+{
+	float lanes[4][BODY_SIMD_WIDTH] = {};
+	for (size_t i = 0; i < count; ++i)
+	{
+		lanes[0][i] = src[i].x;
+		lanes[1][i] = src[i].y;
+		lanes[2][i] = src[i].z;
+		lanes[3][i] = src[i].w;
+	}
+	for (int c = 0; c < 4; ++c)
+		out[c] = _mm_loadu_ps(lanes[c]);
+}
+
+static inline void ScatterQuaternion(Quaternion* dst, int laneMask, const __m128 in[4])
+{
+	float lanes[4][BODY_SIMD_WIDTH];
+	for (int c = 0; c < 4; ++c)
+		_mm_storeu_ps(lanes[c], in[c]);
+
+	for (int i = 0; i < BODY_SIMD_WIDTH; ++i)
+	{
+		if (laneMask & (1 << i))
+			dst[i] = Quaternion(lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]);
+	}
+}
+
+
+bool PhysicsBodyStorage::Add(const PhysicsNode* pnode)
+{
+	//All arrays are grown together, so the nodes only ever need binding again at once
+	bool grown = false;
+	if (Size() == positions.capacity())
+	{
+		Reserve(max(Size() * 2, (size_t)64));
+		grown = true;
+	}
+
+	positions.push_back(pnode->GetPosition());
+	linVelocities.push_back(pnode->GetLinearVelocity());
+	forces.push_back(pnode->GetForce());
+	invMasses.push_back(pnode->GetInverseMass());
+
+	orientations.push_back(pnode->GetOrientation());
+	angVelocities.push_back(pnode->GetAngularVelocity());
+	torques.push_back(pnode->GetTorque());
+	invInertias.push_back(pnode->GetInverseInertia());
+
+	awake.push_back(pnode->IsAwake() ? 1 : 0);
+	transformDirty.push_back(0);
+	return grown;
+}
+
+void PhysicsBodyStorage::Remove(size_t idx)
+{
+	positions.erase(positions.begin() + idx);
+	linVelocities.erase(linVelocities.begin() + idx);
+	forces.erase(forces.begin() + idx);
+	invMasses.erase(invMasses.begin() + idx);
+
+	orientations.erase(orientations.begin() + idx);
+	angVelocities.erase(angVelocities.begin() + idx);
+	torques.erase(torques.begin() + idx);
+	invInertias.erase(invInertias.begin() + idx);
+
+	awake.erase(awake.begin() + idx);
+	transformDirty.erase(transformDirty.begin() + idx);
+}
+
+void PhysicsBodyStorage::Clear()
+{
+	positions.clear();
+	linVelocities.clear();
+	forces.clear();
+	invMasses.clear();
+
+	orientations.clear();
+	angVelocities.clear();
+	torques.clear();
+	invInertias.clear();
+
+	awake.clear();
+	transformDirty.clear();
+}
+
+void PhysicsBodyStorage::Reserve(size_t capacity)
+{
+	positions.reserve(capacity);
+	linVelocities.reserve(capacity);
+	forces.reserve(capacity);
+	invMasses.reserve(capacity);
+
+	orientations.reserve(capacity);
+	angVelocities.reserve(capacity);
+	torques.reserve(capacity);
+	invInertias.reserve(capacity);
+
+	awake.reserve(capacity);
+	transformDirty.reserve(capacity);
+}
+
+int PhysicsBodyStorage::AwakeLanes(size_t first) const
+{
+	int mask = 0;
+	for (size_t i = first; i < Size() && i < first + BODY_SIMD_WIDTH; ++i)
+	{
+		if (awake[i])
+			mask |= 1 << (i - first);
+	}
+	return mask;
+}
+
+void PhysicsBodyStorage::IntegrateForVelocity(float dt, const Vector3& gravity, float dampingFactor)
+{
+	const Vector3 gravityDt = gravity * dt;
+	const int numBatches = (int)((Size() + BODY_SIMD_WIDTH - 1) / BODY_SIMD_WIDTH);
+
+	//Batches never share a body, so can be done in any order
+	#pragma omp parallel for schedule(static) if (Size() >= INTEGRATION_PARALLEL_MIN_BODIES)
+	for (int i = 0; i < numBatches; ++i)
+		IntegrateVelocityBatch((size_t)i * BODY_SIMD_WIDTH, dt, gravityDt, dampingFactor);
+}
+
+void PhysicsBodyStorage::IntegrateForPosition(float dt)
+{
+	const int numBatches = (int)((Size() + BODY_SIMD_WIDTH - 1) / BODY_SIMD_WIDTH);
+
+	#pragma omp parallel for schedule(static) if (Size() >= INTEGRATION_PARALLEL_MIN_BODIES)
+	for (int i = 0; i < numBatches; ++i)
+		IntegratePositionBatch((size_t)i * BODY_SIMD_WIDTH, dt);
+}
+
+void PhysicsBodyStorage::IntegrateVelocityBatch(size_t first, float dt, const Vector3& gravityDt, float dampingFactor)
+{
+	const int laneMask = AwakeLanes(first);
+	if (laneMask == 0)
+		return;
+
+	const size_t count = min(Size() - first, (size_t)BODY_SIMD_WIDTH);
+
+	__m128 linVel[3], force[3], angVel[3], torque[3];
+	GatherVector3(&linVelocities[first], count, linVel);
+	GatherVector3(&forces[first], count, force);
+	GatherVector3(&angVelocities[first], count, angVel);
+	GatherVector3(&torques[first], count, torque);
+
+	float massLanes[BODY_SIMD_WIDTH] = {};
+	float inertiaLanes[9][BODY_SIMD_WIDTH] = {};
+	for (size_t i = 0; i < count; ++i)
+	{
+		massLanes[i] = invMasses[first + i];
+		for (int e = 0; e < 9; ++e)
+			inertiaLanes[e][i] = invInertias[first + i][e];
+	}
+
+	const __m128 invMass = _mm_loadu_ps(massLanes);
+	const __m128 vdt = _mm_set1_ps(dt);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 damping = _mm_set1_ps(dampingFactor);
+
+	//Static bodies aren't pulled down by gravity
+	const __m128 dynamic = _mm_cmpgt_ps(invMass, _mm_setzero_ps());
+	const float gravityLanes[3] = { gravityDt.x, gravityDt.y, gravityDt.z };
+
+	//RK2 method (see the semi-implicit euler version in the tutorials)
+	for (int c = 0; c < 3; ++c)
+	{
+		__m128 v = Select(dynamic, _mm_add_ps(linVel[c], _mm_set1_ps(gravityLanes[c])), linVel[c]);
+		__m128 v_p1 = _mm_add_ps(v, _mm_mul_ps(_mm_mul_ps(force[c], invMass), vdt));
+		v = _mm_mul_ps(_mm_add_ps(v, v_p1), half);
+		linVel[c] = _mm_mul_ps(v, damping);
+	}
+
+	//invInertia * angVelocity, with the matrix stored column by column
+	__m128 inertia[9];
+	for (int e = 0; e < 9; ++e)
+		inertia[e] = _mm_loadu_ps(inertiaLanes[e]);
+
+	__m128 angVel_p1[3];
+	for (int c = 0; c < 3; ++c)
+	{
+		__m128 iw = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(inertia[c], angVel[0]),
+			_mm_mul_ps(inertia[3 + c], angVel[1])),
+			_mm_mul_ps(inertia[6 + c], angVel[2]));
+		angVel_p1[c] = _mm_add_ps(iw, _mm_mul_ps(torque[c], vdt));
+	}
+
+	for (int c = 0; c < 3; ++c)
+	{
+		__m128 w = _mm_mul_ps(_mm_add_ps(angVel[c], angVel_p1[c]), half);
+		angVel[c] = _mm_mul_ps(w, damping);
+	}
+
+	ScatterVector3(&linVelocities[first], laneMask, linVel);
+	ScatterVector3(&angVelocities[first], laneMask, angVel);
+}
+
+void PhysicsBodyStorage::IntegratePositionBatch(size_t first, float dt)
+{
+	const int laneMask = AwakeLanes(first);
+	if (laneMask == 0)
+		return;
+
+	const size_t count = min(Size() - first, (size_t)BODY_SIMD_WIDTH);
+
+	__m128 pos[3], linVel[3], angVel[3], rot[4];
+	GatherVector3(&positions[first], count, pos);
+	GatherVector3(&linVelocities[first], count, linVel);
+	GatherVector3(&angVelocities[first], count, angVel);
+	GatherQuaternion(&orientations[first], count, rot);
+
+	const __m128 vdt = _mm_set1_ps(dt);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (int c = 0; c < 3; ++c)
+		pos[c] = _mm_add_ps(pos[c], _mm_mul_ps(linVel[c], vdt));
+
+	//orientation + Quaternion(angVelocity * dt * 0.5f, 0.0f) * orientation
+	__m128 h[3];
+	for (int c = 0; c < 3; ++c)
+		h[c] = _mm_mul_ps(_mm_mul_ps(angVel[c], vdt), _mm_set1_ps(0.5f));
+
+	const __m128 &x = rot[0], &y = rot[1], &z = rot[2], &w = rot[3];
+	__m128 spin[4];
+	spin[3] = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(zero, w), _mm_mul_ps(h[0], x)), _mm_mul_ps(h[1], y)), _mm_mul_ps(h[2], z));
+	spin[0] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(zero, x), _mm_mul_ps(h[0], w)), _mm_mul_ps(h[1], z)), _mm_mul_ps(h[2], y));
+	spin[1] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(zero, y), _mm_mul_ps(h[1], w)), _mm_mul_ps(h[2], x)), _mm_mul_ps(h[0], z));
+	spin[2] = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(zero, z), _mm_mul_ps(h[2], w)), _mm_mul_ps(h[0], y)), _mm_mul_ps(h[1], x));
+
+	for (int c = 0; c < 4; ++c)
+		rot[c] = _mm_add_ps(rot[c], spin[c]);
+
+	//Normalise, with anything of zero length reset to no rotation (see Quaternion::Normalise)
+	__m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(
+		_mm_mul_ps(rot[0], rot[0]), _mm_mul_ps(rot[1], rot[1])),
+		_mm_mul_ps(rot[2], rot[2])), _mm_mul_ps(rot[3], rot[3])));
+	__m128 valid = _mm_cmpgt_ps(magnitude, zero);
+	__m128 t = _mm_div_ps(_mm_set1_ps(1.0f), magnitude);
+
+	for (int c = 0; c < 3; ++c)
+		rot[c] = Select(valid, _mm_mul_ps(rot[c], t), zero);
+	rot[3] = Select(valid, _mm_mul_ps(rot[3], t), _mm_set1_ps(1.0f));
+
+	ScatterVector3(&positions[first], laneMask, pos);
+	ScatterQuaternion(&orientations[first], laneMask, rot);
+
+	for (int i = 0; i < BODY_SIMD_WIDTH; ++i)
+	{
+		if (laneMask & (1 << i))
+			transformDirty[first + i] = 1;
+	}
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+Class: PhysicsBodyStorage
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	The state of every body in the PhysicsEngine that is integrated each step
+	(position, velocities, forces, orientation, inverse mass/inertia and whether
+	it is awake), kept as one array per field in the same order as the engine's
+	node list. Each PhysicsNode added to the engine is bound to its slot, with its
+	getters/setters reading and writing straight in to these arrays, so nothing
+	else has to know the state has moved.
+
+	Integration then runs over the arrays instead of calling in to every node:
+	bodies are taken BODY_SIMD_WIDTH at a time, with each field gathered in to
+	lanes, integrated with SSE and written back for just the awake ones. Gravity
+	and damping are passed in once for the whole step, and the batches are split
+	across threads with OpenMP once there are enough bodies to be worth it.
+
+	The maths (and order of operations) is exactly that of the old per node
+	integration, so results are unchanged, down to the last bit.
+
+	Each slot also has a flag set whenever the body is moved (by being integrated
+	or through PhysicsNode's setters), which PhysicsEngine::SyncTransforms clears
+	as it updates the world transforms of just those bodies.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <nclgl/Vector3.h>
+#include <nclgl/Quaternion.h>
+#include <nclgl/Matrix3.h>
+#include <vector>
+#include <cstdint>
+
+class PhysicsNode;
+
+//Bodies integrated at once
+#define BODY_SIMD_WIDTH					4
+
+//Fewest bodies the integration will be split across threads for
+#define INTEGRATION_PARALLEL_MIN_BODIES	512
+
+class PhysicsBodyStorage
+{
+public:
+	PhysicsBodyStorage() {}
+	~PhysicsBodyStorage() {}
+
+	inline size_t Size() const				{ return positions.size(); }
+
+	// Adds a slot to the end holding the node's current state
+	//  - Returns true if the arrays had to grow, moving every other slot, in which case
+	//    all of the nodes need binding again
+	bool Add(const PhysicsNode* pnode);
+
+	// Removes the slot, moving all of those after it down by one
+	void Remove(size_t idx);
+	void Clear();
+
+	// Velocity half of the step, adding gravity (to non-static bodies), forces and
+	// torques with RK2 and then damping
+	void IntegrateForVelocity(float dt, const Vector3& gravity, float dampingFactor);
+	// Moves and rotates every awake body by its final velocities, flagging their transforms
+	void IntegrateForPosition(float dt);
+
+public:
+	std::vector<Vector3>	positions;
+	std::vector<Vector3>	linVelocities;
+	std::vector<Vector3>	forces;
+	std::vector<float>		invMasses;
+
+	std::vector<Quaternion>	orientations;
+	std::vector<Vector3>	angVelocities;
+	std::vector<Vector3>	torques;
+	std::vector<Matrix3>	invInertias;
+
+	std::vector<uint8_t>	awake;
+	std::vector<uint8_t>	transformDirty;		//Moved since the last PhysicsEngine::SyncTransforms
+
+protected:
+	void Reserve(size_t capacity);
+
+	//Bitmask of the awake bodies in the batch starting at first
+	int AwakeLanes(size_t first) const;
+
+	void IntegrateVelocityBatch(size_t first, float dt, const Vector3& gravityDt, float dampingFactor);
+	void IntegratePositionBatch(size_t first, float dt);
+};
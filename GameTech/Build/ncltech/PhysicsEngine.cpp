@@ -1,17 +1,24 @@
 #include "PhysicsEngine.h"
+#ifndef NCLTECH_HEADLESS
 #include "GameObject.h"
-#include "CollisionDetectionSAT.h"
-#include <nclgl\NCLDebug.h>
-#include <nclgl\Window.h>
+#endif
+#include "AllocationCounter.h"
+#include "SphereCollisionShape.h"
+#include <nclgl/NCLDebug.h>
+#include <nclgl/GameTimer.h>
 #include <omp.h>
 #include <algorithm>
+#include <climits>
+#include <chrono>
 
+#ifdef USE_CUDA
 extern "C" int CUDA_run(Vector3* cu_pos, float* cu_radius,
 	Vector3* cu_globalOnA, Vector3* cu_globalOnB,
 	Vector3* cu_normal, float* cu_penetration, int* cuda_nodeAIndex,
 	int* cuda_nodeBIndex, int entities);
 extern "C" bool CUDA_init(int arrSize);
 extern "C" bool CUDA_free();
+#endif
 
 void PhysicsEngine::SetDefaults()
 {
@@ -20,6 +27,7 @@ void PhysicsEngine::SetDefaults()
 	updateRealTimeAccum = 0.0f;
 	gravity = Vector3(0.0f, -9.81f, 0.0f);
 	dampingFactor = 0.999f;
+	narrowphaseMode = NARROWPHASE_DISPATCH;
 }
 
 PhysicsEngine::PhysicsEngine()
@@ -27,12 +35,46 @@ PhysicsEngine::PhysicsEngine()
 	//Variables set here will /not/ be reset with each scene
 	isPaused = false;
 
-	useOctree = false;
-	ResetRoot();
+	broadphaseMode = BROADPHASE_BRUTEFORCE;
+
+	stepCount = 0;
+	stepAllocations = 0;
+	solverIterations = SOLVER_ITERATIONS;
+	warmStarting = true;
+
+	sleepingEnabled = true;
+	numAwakeNodes = 0;
+	numIslands = 0;
+
+	parallelSolver = true;
+	numSolverIslands = 0;
+
+	batchedSolver = true;
+	numSolverBatches = 0;
+
+	simdSolver = true;
+
+	deterministic = false;
+	deterministicSeed = DETERMINISTIC_SEED;
+	stepChecksum = 0;
+	memset(&lastStepStats, 0, sizeof(PhysicsStepStats));
+
+	physicsThreadRunning = false;
+	writeFrame = 0;
+	readyFrame = 1;
+	renderFrame = 2;
+	numDroppedSteps = 0;
+	ClearTransformFrames();
 
 	sphereSphere = false;
 
 	gpuAccel = false;
+	cudaCapacity = 0;
+#ifdef USE_CUDA
+	sphereAccelBackend = SPHEREACCEL_CUDA;
+#else
+	sphereAccelBackend = SPHEREACCEL_CPU;
+#endif
 
 	debugDrawFlags = 0;
 
@@ -41,22 +83,25 @@ PhysicsEngine::PhysicsEngine()
 
 PhysicsEngine::~PhysicsEngine()
 {
-	if (gpuAccel)
-		CUDA_free();
+	SetThreaded(false);
+
+	FreeCUDAMemory();
 
 	RemoveAllPhysicsObjects();
-	TerminateOctree(root);
 }
 
 void PhysicsEngine::AddPhysicsObject(PhysicsNode* obj)
 {
 	physicsNodes.push_back(obj);
 
-	if (InOctree(root, obj))
-		AddToOctree(root, obj);
+	//Nodes point straight in to the arrays, so if they moved everything needs pointing at them again
+	if (bodies.Add(obj))
+		BindBodies(0);
+	else
+		BindBodies(physicsNodes.size() - 1);
 
-	if (gpuAccel)
-		CUDA_init(physicsNodes.size());
+	sweepAndPrune.AddNode(obj);
+	aabbTree.AddNode(obj);
 }
 
 void PhysicsEngine::RemovePhysicsObject(PhysicsNode* obj)
@@ -67,12 +112,16 @@ void PhysicsEngine::RemovePhysicsObject(PhysicsNode* obj)
 	//If found, remove it from the list
 	if (found_loc != physicsNodes.end())
 	{
+		size_t idx = found_loc - physicsNodes.begin();
+		obj->UnbindBody();
+		bodies.Remove(idx);
 		physicsNodes.erase(found_loc);
-		Octree* tree = obj->GetOctree();
-		if (tree)
-		{
-			FindAndDelete(tree, obj);
-		}
+		BindBodies(idx);
+
+		RemoveNodeManifolds(obj);
+		ClearTransformFrames();
+		sweepAndPrune.RemoveNode(obj);
+		aabbTree.RemoveNode(obj);
 	}
 }
 
@@ -85,31 +134,59 @@ void PhysicsEngine::RemoveAllPhysicsObjects()
 		c = NULL;
 	}
 	constraints.clear();
+	activeConstraints.clear();
 
-	for (Manifold* m : manifolds)
+	for (auto& cached : manifoldCache)
 	{
-		delete m;
-		m = NULL;
+		manifoldPool.Release(cached.second);
+		cached.second = NULL;
 	}
+	manifoldCache.clear();
+	narrowphaseCache.clear();
 	manifolds.clear();
+	solverIslands.clear();
+	numSolverIslands = 0;
 
-	TerminateOctree(root);
-	ResetRoot();
+	octree.Clear();
+	sweepAndPrune.Clear();
+	aabbTree.Clear();
+	spatialHash.Clear();
 
 	//Delete and remove all physics objects
 	// - we also need to inform the (possibly) associated game-object
 	//   that the physics object no longer exists
 	for (PhysicsNode* obj : physicsNodes)
 	{
+#ifndef NCLTECH_HEADLESS
 		if (obj->GetParent()) obj->GetParent()->SetPhysics(NULL);
+#endif
 		delete obj;
 		obj = NULL;
 	}
 	physicsNodes.clear();
+	bodies.Clear();
+	ClearTransformFrames();
+
+	//Every run of the next scene starts from the same point, including
+	// any scenes that use rand() to set themselves up
+	shuffleGenerator.seed(deterministicSeed);
+	if (deterministic)
+		srand(deterministicSeed);
 }
 
 void PhysicsEngine::Update(float deltaTime)
 {
+	//The physics thread does the stepping, so all that is left is to show its results
+	if (IsThreaded())
+	{
+		SyncRenderTransforms();
+
+		//Anything moved from this thread (e.g. by the ScreenPicker while paused). The
+		// caller already holds the physics mutex, see SetThreaded.
+		SyncTransforms();
+		return;
+	}
+
 	//The physics engine should run independantly to the renderer
 	// - As our codebase is currently single threaded we just need
 	//   a way of calling "UpdatePhysics()" at regular intervals
@@ -137,35 +214,38 @@ void PhysicsEngine::Update(float deltaTime)
 			updateRealTimeAccum = 0.0f;
 		}
 	}
+
+	//Shows anything moved since the last step, even if there wasn't one
+	SyncTransforms();
 }
 
 void PhysicsEngine::UpdatePhysics()
 {
-	for (Manifold* m : manifolds)
-	{
-		delete m;
-		m = NULL;
-	}
+	size_t allocations = AllocationCounter::NumAllocations();
+
+	//Manifolds are owned by the cache, this is just the list of ones in contact this step
 	manifolds.clear();
+	++stepCount;
 
 	perfUpdate.UpdateRealElapsedTime(updateTimestep);
 	perfBroadphase.UpdateRealElapsedTime(updateTimestep);
 	perfNarrowphase.UpdateRealElapsedTime(updateTimestep);
 	perfSolver.UpdateRealElapsedTime(updateTimestep);
 
+	//Anything moved since the last step (e.g. by the game) needs its shape up to date first
+	SyncTransforms();
+
 	//A whole physics engine in 6 simple steps =D
 
 	//-- Using positions from last frame --
 	//1. Broadphase Collision Detection (Fast and dirty)
 	numSphereChecks = 0;
 	perfBroadphase.BeginTimingSection();
-#ifdef USE_CUDA
+	//The accelerated path makes its own pairs
 	if (!gpuAccel)
 		BroadPhaseCollisions();
-#elif _WIN32
-	BroadPhaseCollisions();
-#endif
 	perfBroadphase.EndTimingSection();
+	lastStepStats.broadphaseMs = perfBroadphase.GetLast();
 
 	//2. Narrowphase Collision Detection (Accurate but slow)
 	perfNarrowphase.BeginTimingSection();
@@ -174,189 +254,415 @@ void PhysicsEngine::UpdatePhysics()
 		GPUCollisionCheck();
 
 	NarrowPhaseCollisions();
+	PurgeManifolds();
+	PurgeNarrowphaseCache();
 	perfNarrowphase.EndTimingSection();
+	lastStepStats.narrowphaseMs = perfNarrowphase.GetLast();
+	lastStepStats.numColPairs = broadphaseColPairs.size();
+	lastStepStats.numSATCacheTests = colDetect.GetSAT().NumCachedAxisTests();
+	lastStepStats.numSATCacheHits = colDetect.GetSAT().NumCachedAxisHits();
+
+	lastStepStats.numManifolds = manifolds.size();
+	lastStepStats.numContacts = 0;
+	for (Manifold* m : manifolds) lastStepStats.numContacts += m->contactPoints.size();
 
-	std::random_shuffle(manifolds.begin(), manifolds.end());
-	std::random_shuffle(constraints.begin(), constraints.end());
+	//Any sleeping island touched by an awake object is woken up here
+	BuildIslands();
+
+	if (deterministic)
+	{
+		//Resting manifolds were added from the cache, whose order depends on the node addresses
+		std::sort(manifolds.begin(), manifolds.end(), [](Manifold* a, Manifold* b)
+		{
+			int a1 = a->NodeA()->GetIslandIndex(), a2 = a->NodeB()->GetIslandIndex();
+			int b1 = b->NodeA()->GetIslandIndex(), b2 = b->NodeB()->GetIslandIndex();
+			return std::make_pair(min(a1, a2), max(a1, a2)) < std::make_pair(min(b1, b2), max(b1, b2));
+		});
+		std::shuffle(manifolds.begin(), manifolds.end(), shuffleGenerator);
+		std::shuffle(activeConstraints.begin(), activeConstraints.end(), shuffleGenerator);
+	}
+	else
+	{
+		std::random_shuffle(manifolds.begin(), manifolds.end());
+		std::random_shuffle(activeConstraints.begin(), activeConstraints.end());
+	}
 
 	//3. Initialize Constraint Params (precompute elasticity/baumgarte factor etc)
 	//Optional step to allow constraints to 
 	// precompute values based off current velocities 
 	// before they are updated loop below.
 	for (Manifold* m : manifolds) m->PreSolverStep(updateTimestep);
-	for (Constraint* c : constraints) c->PreSolverStep(updateTimestep);
+	for (Constraint* c : activeConstraints) c->PreSolverStep(updateTimestep);
 
 	//4. Update Velocities
 	perfUpdate.BeginTimingSection();
-	for (PhysicsNode* obj : physicsNodes) obj->IntegrateForVelocity(updateTimestep);
+	bodies.IntegrateForVelocity(updateTimestep, gravity, dampingFactor);
 	perfUpdate.EndTimingSection();
+	lastStepStats.integrationMs = perfUpdate.GetLast();
 
 	//5. Constraint Solver
 	perfSolver.BeginTimingSection();
-	for (size_t i = 0; i < SOLVER_ITERATIONS; ++i)
+	BuildSolverIslands();
+
+	if (simdSolvers.size() < (size_t)omp_get_max_threads())
+		simdSolvers.resize(omp_get_max_threads());
+
+	if (batchedSolver)
 	{
-		for (Manifold* m : manifolds) m->ApplyImpulse();
-		for (Constraint* c : constraints) c->ApplyImpulse();
+		//Islands don't share dynamic objects, so the colors only need clearing once
+		batchColours.assign(physicsNodes.size(), 0);
+		for (size_t i = 1; i < numSolverIslands; ++i)
+		{
+			SolverIsland& island = solverIslands[i];
+			if (!SolvesWithSIMD(island)
+				&& island.numManifolds + island.numConstraints >= SOLVER_BATCH_MIN_SIZE)
+			{
+				BuildSolverBatches(island);
+				SolveBatches();
+				island.batched = true;
+			}
+		}
 	}
+
+	#pragma omp parallel for schedule(dynamic) if (parallelSolver)
+	for (int i = 1; i < (int)numSolverIslands; ++i)
+	{
+		if (!solverIslands[i].batched)
+			SolveIsland(solverIslands[i]);
+	}
+
+	SolveIsland(solverIslands[0]);
 	perfSolver.EndTimingSection();
+	lastStepStats.solverMs = perfSolver.GetLast();
 
 	//6. Update Positions (with final 'real' velocities)
 	perfUpdate.BeginTimingSection();
-	for (PhysicsNode* obj : physicsNodes) obj->IntegrateForPosition(updateTimestep);
+	bodies.IntegrateForPosition(updateTimestep);
+
+	//7. Put any islands that have come to rest to sleep
+	UpdateSleeping();
+
+	//8. Update the world transforms of everything that moved
+	SyncTransforms();
 	perfUpdate.EndTimingSection();
+	lastStepStats.integrationMs += perfUpdate.GetLast();
+	lastStepStats.numAwakeNodes = numAwakeNodes;
+
+	if (deterministic)
+		stepChecksum = ComputeStateChecksum();
+
+	stepAllocations = AllocationCounter::NumAllocations() - allocations;
 }
 
-void PhysicsEngine::BroadPhaseCollisions()
+void PhysicsEngine::SetDeterministic(bool deterministic, uint seed)
 {
-	broadphaseColPairs.clear();
+	this->deterministic = deterministic;
+	deterministicSeed = seed;
+	shuffleGenerator.seed(seed);
+	stepChecksum = 0;
+}
 
-	if (useOctree)
+size_t PhysicsEngine::NumDynamicNodes() const
+{
+	size_t numDynamic = 0;
+	for (const PhysicsNode* pnode : physicsNodes)
 	{
-		std::vector<PhysicsNode*> parentList;
-		GenColPairs(root, parentList);
-		DrawOctree(root);
+		if (!pnode->IsStatic())
+			++numDynamic;
+	}
+	return numDynamic;
+}
+
+uint64_t PhysicsEngine::ComputeStateChecksum() const
+{
+	uint64_t hash = 14695981039346656037ULL;
+	auto HashBytes = [&hash](const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	};
+
+	size_t numNodes = physicsNodes.size();
+	HashBytes(&numNodes, sizeof(numNodes));
+
+	for (const PhysicsNode* pnode : physicsNodes)
+	{
+		const Vector3& pos = pnode->GetPosition();
+		const Quaternion& rot = pnode->GetOrientation();
+		const Vector3& linVel = pnode->GetLinearVelocity();
+		const Vector3& angVel = pnode->GetAngularVelocity();
+		bool awake = pnode->IsAwake();
+
+		float state[13] = {
+			pos.x, pos.y, pos.z,
+			rot.x, rot.y, rot.z, rot.w,
+			linVel.x, linVel.y, linVel.z,
+			angVel.x, angVel.y, angVel.z };
+		HashBytes(state, sizeof(state));
+		HashBytes(&awake, sizeof(awake));
+	}
+
+	return hash;
+}
+
+void PhysicsEngine::SetThreaded(bool threaded)
+{
+	if (threaded == IsThreaded())
+		return;
+
+	if (threaded)
+	{
+		//The thread can't step until the lock is released, so it will always see its own id
+		std::lock_guard<std::mutex> lock(physicsMutex);
+		ClearTransformFrames();
+		updateRealTimeAccum = 0.0f;
+		physicsThreadRunning = true;
+		physicsThread = std::thread(&PhysicsEngine::PhysicsThreadLoop, this);
+		physicsThreadId = physicsThread.get_id();
 	}
 	else
 	{
-		PhysicsNode *pnodeA, *pnodeB;
-		//	The broadphase needs to build a list of all potentially colliding objects in the world,
-		//	which then get accurately assesed in narrowphase. If this is too coarse then the system slows down with
-		//	the complexity of narrowphase collision checking, if this is too fine then collisions may be missed.
+		physicsThreadRunning = false;
+		physicsThread.join();
+		physicsThreadId = std::thread::id();
+		updateRealTimeAccum = 0.0f;
+	}
+}
 
-		//	Brute force approach.
-		//  - For every object A, assume it could collide with every other object.. 
-		//    even if they are on the opposite sides of the world.
-		if (physicsNodes.size() > 0)
+void PhysicsEngine::PhysicsThreadLoop()
+{
+	float lastTime = engineTimer.GetMS();
+
+	while (physicsThreadRunning)
+	{
+		float waitTime;
 		{
-			for (size_t i = 0; i < physicsNodes.size() - 1; ++i)
-			{
-				for (size_t j = i + 1; j < physicsNodes.size(); ++j)
-				{
-					pnodeA = physicsNodes[i];
-					pnodeB = physicsNodes[j];
+			std::lock_guard<std::mutex> lock(physicsMutex);
 
-					//Check they both atleast have collision shapes
-					if (pnodeA->GetCollisionShape() != NULL
-						&& pnodeB->GetCollisionShape() != NULL)
-					{
-						CollisionPair cp;
-						cp.pObjectA = pnodeA;
-						cp.pObjectB = pnodeB;
+			float time = engineTimer.GetMS();
+			if (!isPaused)
+			{
+				updateRealTimeAccum += (time - lastTime) * 0.001f;
 
-						bool spherePass = true;
-						if (sphereSphere)
-						{
-							Vector3 ab = cp.pObjectA->GetPosition() - cp.pObjectB->GetPosition();
-							spherePass = ab.Length() <= pnodeA->GetBoundingRadius() + pnodeB->GetBoundingRadius() ? true : false;
-							++numSphereChecks;
-						}
+				int steps = 0;
+				for (; updateRealTimeAccum >= updateTimestep && steps < PHYSICS_THREAD_MAX_STEPS; ++steps)
+				{
+					updateRealTimeAccum -= updateTimestep;
+					BeginTransformFrame();
+					UpdatePhysics();
+				}
 
-						//do a coarse sphere-sphere check using bounding radii of the rendernodes
-						if (spherePass)
-							broadphaseColPairs.push_back(cp);
-					}
+				//Same as the single threaded version, rather than falling further and
+				// further behind just drop the time we couldn't keep up with
+				if (updateRealTimeAccum >= updateTimestep)
+				{
+					numDroppedSteps += (size_t)(updateRealTimeAccum / updateTimestep);
+					updateRealTimeAccum = 0.0f;
 				}
+
+				if (steps > 0)
+					PublishTransformFrame();
 			}
+			lastTime = time;
+
+			waitTime = updateTimestep - updateRealTimeAccum;
 		}
+
+		//Nothing to do until the next step is due
+		std::this_thread::sleep_for(std::chrono::microseconds((int)(waitTime * 1000000.0f)));
 	}
 }
 
-void PhysicsEngine::ResetRoot()
+void PhysicsEngine::BeginTransformFrame()
 {
-	root = new Octree;
-	for (int i = 0; i < 8; ++i)
-		root->children[i] = NULL;
-	root->parent = NULL;
-	root->pos = Vector3(2.0f, 0.0f, 2.0f);
-	//arbitrary - assign differently later (??) // - searchable token
-	root->dimensions = Vector3(30.0f, 30.0f, 30.0f);
+	TransformFrame& frame = transformFrames[writeFrame];
+	frame.nodes = physicsNodes;
+	frame.prevPositions.resize(physicsNodes.size());
+	frame.prevOrientations.resize(physicsNodes.size());
+	for (size_t i = 0; i < physicsNodes.size(); ++i)
+	{
+		frame.prevPositions[i] = physicsNodes[i]->GetPosition();
+		frame.prevOrientations[i] = physicsNodes[i]->GetOrientation();
+	}
 }
 
-void PhysicsEngine::DrawOctree(Octree* tree)
+void PhysicsEngine::PublishTransformFrame()
 {
-	Vector3 corner = tree->pos - tree->dimensions;
+	TransformFrame& frame = transformFrames[writeFrame];
 
-	for (int i = 0; i < 9; ++i)
+	//Anything added during the step just starts where it is now
+	if (frame.nodes != physicsNodes)
 	{
-		int x = i % 3;
-		int y = i / 3;
-		Vector3 start = corner + Vector3(tree->dimensions.x * x, tree->dimensions.y * y, 0);
-		Vector3 end = start + Vector3(0, 0, tree->dimensions.z * 2);
-		NCLDebug::DrawHairLineNDT(start, end, Vector4(0.0, 0.0f, 1.0f, 1.0f));
+		frame.nodes = physicsNodes;
+		frame.prevPositions.resize(physicsNodes.size());
+		frame.prevOrientations.resize(physicsNodes.size());
+		for (size_t i = 0; i < physicsNodes.size(); ++i)
+		{
+			frame.prevPositions[i] = physicsNodes[i]->GetPosition();
+			frame.prevOrientations[i] = physicsNodes[i]->GetOrientation();
+		}
 	}
-	for (int i = 0; i < 9; ++i)
+
+	frame.positions.resize(physicsNodes.size());
+	frame.orientations.resize(physicsNodes.size());
+	frame.awake.resize(physicsNodes.size());
+	for (size_t i = 0; i < physicsNodes.size(); ++i)
 	{
-		int y = i % 3;
-		int z = i / 3;
-		Vector3 start = corner + Vector3(0, tree->dimensions.y * y, tree->dimensions.z * z);
-		Vector3 end = start + Vector3(tree->dimensions.x * 2, 0, 0);
-		NCLDebug::DrawHairLineNDT(start, end, Vector4(1.0, 0.0f, 0.0f, 1.0f));
+		frame.positions[i] = physicsNodes[i]->GetPosition();
+		frame.orientations[i] = physicsNodes[i]->GetOrientation();
+		frame.awake[i] = physicsNodes[i]->IsAwake();
 	}
-	for (int i = 0; i < 9; ++i)
+	frame.leftoverAccum = updateRealTimeAccum;
+	frame.publishTime = engineTimer.GetMS();
+	frame.finished = false;
+
+	std::lock_guard<std::mutex> lock(transformMutex);
+	std::swap(writeFrame, readyFrame);
+	newFrameReady = true;
+}
+
+void PhysicsEngine::SyncRenderTransforms()
+{
 	{
-		int x = i % 3;
-		int z = i / 3;
-		Vector3 start = corner + Vector3(tree->dimensions.x * x, 0, tree->dimensions.z * z);
-		Vector3 end = start + Vector3(0, tree->dimensions.y * 2, 0);
-		NCLDebug::DrawHairLineNDT(start, end, Vector4(0.0, 1.0f, 0.0f, 1.0f));
+		std::lock_guard<std::mutex> lock(transformMutex);
+		if (newFrameReady)
+		{
+			std::swap(renderFrame, readyFrame);
+			newFrameReady = false;
+		}
 	}
 
-	for (int i = 0; i < 8; ++i)
+	//Once a frame has been shown fully it is left alone, so anything moving the
+	// nodes from this thread (e.g. the ScreenPicker while paused) isn't overwritten
+	TransformFrame& frame = transformFrames[renderFrame];
+	if (frame.finished)
+		return;
+
+	//Rendering is up to one step behind the simulation, with the time since the
+	// last step deciding how far between the last two steps to draw everything
+	float alpha = (frame.leftoverAccum + (engineTimer.GetMS() - frame.publishTime) * 0.001f) / updateTimestep;
+	if (alpha >= 1.0f)
 	{
-		if (tree->children[i] != NULL) DrawOctree(tree->children[i]);
+		alpha = 1.0f;
+		frame.finished = true;
+	}
+
+	for (size_t i = 0; i < frame.nodes.size(); ++i)
+	{
+		Matrix4 transform = Quaternion::Slerp(frame.prevOrientations[i], frame.orientations[i], alpha).ToMatrix4();
+		transform.SetPositionVector(frame.prevPositions[i] * (1.0f - alpha) + frame.positions[i] * alpha);
+
+		frame.nodes[i]->FireOnUpdateCallback(transform);
+		frame.nodes[i]->SetRenderAwake(frame.awake[i]);
 	}
 }
 
-void PhysicsEngine::GenColPairs(Octree* tree, std::vector<PhysicsNode*> parentPnodes)
+void PhysicsEngine::ClearTransformFrames()
 {
-	std::vector<PhysicsNode*> combinedList = parentPnodes;
-	combinedList.insert(combinedList.end(), tree->pnodesInZone.begin(), tree->pnodesInZone.end());
-
-	for (int i = 0; i < 8; ++i)
+	std::lock_guard<std::mutex> lock(transformMutex);
+	for (TransformFrame& frame : transformFrames)
 	{
-		if (tree->children[i])
-			GenColPairs(tree->children[i], combinedList);
+		frame.nodes.clear();
+		frame.finished = true;
 	}
-	if (tree->pnodesInZone.size() > 1)
+	newFrameReady = false;
+}
+
+void PhysicsEngine::SyncTransforms()
+{
+	movedNodes.clear();
+	for (size_t i = 0; i < physicsNodes.size(); ++i)
 	{
-		for (size_t i = 0; i < tree->pnodesInZone.size() - 1; ++i)
+		if (bodies.transformDirty[i])
 		{
-			for (size_t j = i + 1; j < tree->pnodesInZone.size(); ++j)
-			{
-				PhysicsNode *pnodeA, *pnodeB;
+			bodies.transformDirty[i] = 0;
+			movedNodes.push_back(physicsNodes[i]);
+		}
+	}
 
-				pnodeA = tree->pnodesInZone[i];
-				pnodeB = tree->pnodesInZone[j];
+	//Each node's transform and shape only depend on the node itself
+	#pragma omp parallel for schedule(static) if (movedNodes.size() >= TRANSFORM_SYNC_PARALLEL_MIN_NODES)
+	for (int i = 0; i < (int)movedNodes.size(); ++i)
+		movedNodes[i]->UpdateWorldTransform();
 
-				//Check they both atleast have collision shapes
-				if (pnodeA->GetCollisionShape() != NULL
-					&& pnodeB->GetCollisionShape() != NULL)
-				{
-					CollisionPair cp;
-					cp.pObjectA = pnodeA;
-					cp.pObjectB = pnodeB;
+	//Listeners (e.g. GameObject moving its RenderNode) aren't thread safe, so are all called
+	// afterwards. The physics thread leaves them to SyncRenderTransforms.
+	if (OnPhysicsThread())
+		return;
 
-					bool spherePass = true;
-					if (sphereSphere)
-					{
-						Vector3 ab = cp.pObjectA->GetPosition() - cp.pObjectB->GetPosition();
-						spherePass = ab.Length() <= pnodeA->GetBoundingRadius() + pnodeB->GetBoundingRadius() ? true : false;
-						++numSphereChecks;
-					}
+	for (PhysicsNode* pnode : movedNodes)
+		pnode->FireOnUpdateCallback(pnode->GetWorldSpaceTransform());
+}
 
-					//do a coarse sphere-sphere check using bounding radii of the rendernodes
-					if (spherePass)
-						broadphaseColPairs.push_back(cp);
-				}
-			}
-			if (parentPnodes.size() > 0)
+void PhysicsEngine::BindBodies(size_t first)
+{
+	for (size_t i = first; i < physicsNodes.size(); ++i)
+		physicsNodes[i]->BindBody(&bodies, i);
+}
+
+void PhysicsEngine::BroadPhaseCollisions()
+{
+	broadphaseColPairs.clear();
+
+	if (broadphaseMode == BROADPHASE_OCTREE)
+	{
+		//Rebuilt each step around the current extents of the scene
+		octree.Update(physicsNodes);
+		octree.GenColPairs(broadphaseColPairs);
+
+		if (sphereSphere)
+			SphereSphereCull();
+	}
+	else if (broadphaseMode == BROADPHASE_SWEEPANDPRUNE)
+	{
+		//Endpoint lists persist between steps, so this is mostly a
+		// cheap re-sort of already nearly sorted lists
+		sweepAndPrune.Update();
+		sweepAndPrune.GenColPairs(broadphaseColPairs);
+
+		if (sphereSphere)
+			SphereSphereCull();
+	}
+	else if (broadphaseMode == BROADPHASE_AABBTREE)
+	{
+		//Only nodes which have left their fat AABB get reinserted
+		aabbTree.Update(updateTimestep);
+		aabbTree.GenColPairs(broadphaseColPairs);
+
+		if (sphereSphere)
+			SphereSphereCull();
+	}
+	else if (broadphaseMode == BROADPHASE_SPATIALHASH)
+	{
+		//Grid is rebuilt from scratch each step with a (multithreaded) counting sort
+		spatialHash.Update(physicsNodes);
+		spatialHash.GenColPairs(broadphaseColPairs);
+
+		if (sphereSphere)
+			SphereSphereCull();
+	}
+	else
+	{
+		PhysicsNode *pnodeA, *pnodeB;
+		//	The broadphase needs to build a list of all potentially colliding objects in the world,
+		//	which then get accurately assesed in narrowphase. If this is too coarse then the system slows down with
+		//	the complexity of narrowphase collision checking, if this is too fine then collisions may be missed.
+
+		//	Brute force approach.
+		//  - For every object A, assume it could collide with every other object.. 
+		//    even if they are on the opposite sides of the world.
+		if (physicsNodes.size() > 0)
+		{
+			for (size_t i = 0; i < physicsNodes.size() - 1; ++i)
 			{
-				for (size_t k = 0; k < parentPnodes.size(); ++k)
+				for (size_t j = i + 1; j < physicsNodes.size(); ++j)
 				{
-					PhysicsNode *pnodeA, *pnodeB;
-
-					pnodeA = tree->pnodesInZone[i];
-					pnodeB = parentPnodes[k];
+					pnodeA = physicsNodes[i];
+					pnodeB = physicsNodes[j];
 
 					//Check they both atleast have collision shapes
 					if (pnodeA->GetCollisionShape() != NULL
@@ -383,331 +689,511 @@ void PhysicsEngine::GenColPairs(Octree* tree, std::vector<PhysicsNode*> parentPn
 		}
 	}
 
-	if (parentPnodes.size() > 0 && tree->pnodesInZone.size() > 0)
-	{
-		for (size_t k = 0; k < parentPnodes.size(); ++k)
-		{
-			PhysicsNode *pnodeA, *pnodeB;
-
-			pnodeA = tree->pnodesInZone[tree->pnodesInZone.size() - 1];
-			pnodeB = parentPnodes[k];
-
-			//Check they both atleast have collision shapes
-			if (pnodeA->GetCollisionShape() != NULL
-				&& pnodeB->GetCollisionShape() != NULL)
-			{
-				CollisionPair cp;
-				cp.pObjectA = pnodeA;
-				cp.pObjectB = pnodeB;
-
-				bool spherePass = true;
-				if (sphereSphere)
-				{
-					Vector3 ab = cp.pObjectA->GetPosition() - cp.pObjectB->GetPosition();
-					spherePass = ab.Length() <= pnodeA->GetBoundingRadius() + pnodeB->GetBoundingRadius() ? true : false;
-					++numSphereChecks;
-				}
+	if (deterministic)
+		SortCollisionPairs();
 
-				//do a coarse sphere-sphere check using bounding radii of the rendernodes
-				if (spherePass)
-					broadphaseColPairs.push_back(cp);
-			}
-		}
-	}
+	//Drop any pairs that can't move each other, so resting objects cost nothing
+	// past the broadphase. Sleeping objects touching awake ones are kept so they wake.
+	auto sleeping = std::remove_if(broadphaseColPairs.begin(), broadphaseColPairs.end(),
+		[this](const CollisionPair& cp) { return IsSleepingPair(cp.pObjectA, cp.pObjectB); });
+	broadphaseColPairs.erase(sleeping, broadphaseColPairs.end());
 }
 
-void PhysicsEngine::AddToOctree(Octree* tree, PhysicsNode* pnode)
+void PhysicsEngine::BuildIslands()
 {
-	Vector3 centre = tree->pos;
-	Vector3 dims = tree->dimensions;
-
-	float minSize = 0;
+	const int numNodes = (int)physicsNodes.size();
+	islandParent.resize(numNodes);
+	for (int i = 0; i < numNodes; ++i)
+	{
+		islandParent[i] = i;
+		physicsNodes[i]->SetIslandIndex(i);
+	}
 
-	if (dims.x < dims.y && dims.x < dims.z) minSize = dims.x;
-	else if (dims.y < dims.z && dims.y < dims.x) minSize = dims.y;
-	else minSize = dims.z;
+	//Manifolds between sleeping objects are kept in the cache, so resting
+	// contacts still hold the sleeping islands together
+	for (auto& cached : manifoldCache)
+		UnionIslands(cached.second->NodeA(), cached.second->NodeB());
 
-	std::bitset<8> zones = WhichZones(tree->pos, pnode);
+	for (Constraint* c : constraints)
+	{
+		if (c->GetNodeA() && c->GetNodeB())
+			UnionIslands(c->GetNodeA(), c->GetNodeB());
+	}
 
-	if (zones.count() == 1)	//node not stradling several octants
+	//Wake every island with an awake object in it
+	islandSleepCounter.assign(numNodes, UINT_MAX);
+	islandAwake.assign(numNodes, false);
+	for (int i = 0; i < numNodes; ++i)
 	{
-		int num = -1;
-		for (int i = 0; i < 8; ++i)
-			if (zones[i]) num = i;
+		if (physicsNodes[i]->IsAwake() && !physicsNodes[i]->IsStatic())
+			islandAwake[FindIsland(i)] = true;
+	}
 
-		Octree* leaf = tree->children[num];
-		if (!leaf)
-		{
-			int z = num / 4;
-			int y = (num / 2) % 2;
-			int x = num % 2;
-			// pos gives the top right corner of the octant 
-			Vector3 pos = centre + Vector3(x * dims.x, y * dims.y, z * dims.z);
-
-			leaf = new Octree();
-			for (int i = 0; i < 8; ++i)
-				leaf->children[i] = NULL;
-			leaf->parent = tree;
-			tree->children[num] = leaf;
-			leaf->pos = pos - (dims * 0.5);
-			leaf->dimensions = dims * 0.5;
-		}
+	numIslands = 0;
+	for (int i = 0; i < numNodes; ++i)
+	{
+		PhysicsNode* pnode = physicsNodes[i];
+		if (pnode->IsStatic())
+			continue;
 
-		leaf->pnodesInZone.push_back(pnode);
-		pnode->SetOctree(leaf);
+		int root = FindIsland(i);
+		if (root == i) ++numIslands;
+		if (islandAwake[root]) pnode->Wake();
+	}
 
-		// if a child of the octree has too many nodes, it needs splitting
-		if (leaf->pnodesInZone.size() > MAX_OBJECTS && minSize > MIN_OCTANT_SIZE)
+	//Resting contacts of any island that has just been woken are still valid,
+	// as nothing in it has moved, so they can be solved straight away
+	for (auto& cached : manifoldCache)
+	{
+		Manifold* m = cached.second;
+		if (m->lastUsedStep != stepCount && !IsSleepingPair(m->NodeA(), m->NodeB()))
 		{
-			vector<PhysicsNode*> temps;
-			for (int i = leaf->pnodesInZone.size() - 1; i >= 0; --i)
-			{
-				temps.push_back(leaf->pnodesInZone[i]);
-				leaf->pnodesInZone.pop_back();
-			}
-			for (int i = 0; i < temps.size(); ++i)
-			{
-				AddToOctree(leaf, temps[i]);
-			}
-			//AddToOctree(leaf, pnode);
+			m->lastUsedStep = stepCount;
+			manifolds.push_back(m);
 		}
-		return;
 	}
-	else
+
+	//Constraints are skipped once everything they act on is asleep
+	activeConstraints.clear();
+	for (Constraint* c : constraints)
 	{
-		tree->pnodesInZone.push_back(pnode);
-		pnode->SetOctree(tree);
+		PhysicsNode* pnodeA = c->GetNodeA();
+		PhysicsNode* pnodeB = c->GetNodeB();
+		bool asleep = (pnodeA || pnodeB)
+			&& (!pnodeA || !pnodeA->IsAwake())
+			&& (!pnodeB || !pnodeB->IsAwake());
+		if (!asleep)
+			activeConstraints.push_back(c);
 	}
 }
 
-void PhysicsEngine::UpdateNodePosition(PhysicsNode* pnode)
+void PhysicsEngine::BuildSolverIslands()
 {
-	Octree* tree = pnode->GetOctree();
-
-	if (!InOctree(root, pnode))
+	const size_t numManifolds = manifolds.size();
+	const size_t numConstraints = activeConstraints.size();
+
+	numSolverIslands = 1;
+	numSolverBatches = 0;
+	if (solverIslands.empty())
+		solverIslands.resize(1);
+	solverIslands[0] = SolverIsland();
+	islandSlot.assign(physicsNodes.size(), -1);
+
+	//Arrays are kept between steps, so they only allocate when the scene grows
+	solverManifolds.resize(numManifolds);
+	solverConstraints.resize(numConstraints);
+	solverEntrySlots.resize(numManifolds + numConstraints);
+
+	//1. Count what goes in each island
+	for (size_t i = 0; i < numManifolds; ++i)
 	{
-		if (tree)
-		{
-			if (FindAndDelete(tree, pnode))
-				TerminateOctree(tree);
-		}
-		return;
+		int slot = GetSolverIslandSlot(manifolds[i]->NodeA(), manifolds[i]->NodeB());
+		solverEntrySlots[i] = slot;
+		solverIslands[slot].numManifolds++;
 	}
 
-	bool destroy = false;
-	Octree* parent = NULL;
+	for (size_t i = 0; i < numConstraints; ++i)
+	{
+		int slot = GetSolverIslandSlot(activeConstraints[i]->GetNodeA(), activeConstraints[i]->GetNodeB());
+		solverEntrySlots[numManifolds + i] = slot;
+		solverIslands[slot].numConstraints++;
+	}
 
-	// if the node doesn't currently have a tree, don't run this code
-	if (tree)
+	//2. Give each island its range
+	size_t firstManifold = 0, firstConstraint = 0;
+	for (size_t i = 0; i < numSolverIslands; ++i)
 	{
-		parent = tree->parent;
-		//checks to make sure the pnode is in the octree it thinks it is.
+		SolverIsland& island = solverIslands[i];
+		island.firstManifold = firstManifold;
+		island.firstConstraint = firstConstraint;
+		firstManifold += island.numManifolds;
+		firstConstraint += island.numConstraints;
+		island.numManifolds = 0;
+		island.numConstraints = 0;
+	}
 
-		destroy = FindAndDelete(tree, pnode);
+	//3. Fill them in order
+	for (size_t i = 0; i < numManifolds; ++i)
+	{
+		SolverIsland& island = solverIslands[solverEntrySlots[i]];
+		solverManifolds[island.firstManifold + island.numManifolds++] = manifolds[i];
 	}
-	else
-		tree = root;
 
-	if (parent)
+	for (size_t i = 0; i < numConstraints; ++i)
 	{
-		if (destroy) TerminateOctree(tree);
-		MoveUp(parent, pnode);
+		SolverIsland& island = solverIslands[solverEntrySlots[numManifolds + i]];
+		solverConstraints[island.firstConstraint + island.numConstraints++] = activeConstraints[i];
 	}
-	else
-		AddToOctree(tree, pnode);
 }
 
-bool PhysicsEngine::FindAndDelete(Octree* tree, PhysicsNode* pnode)
+int PhysicsEngine::GetSolverIslandSlot(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
 {
-	auto location = std::find(tree->pnodesInZone.begin(), tree->pnodesInZone.end(), pnode);
-	if (location != tree->pnodesInZone.end())
+	//Anything with both nodes in an island is in the same one, so either will do
+	PhysicsNode* pnode = (pnodeA && !pnodeA->IsStatic()) ? pnodeA : pnodeB;
+	if (!pnode || pnode->IsStatic())
+		return 0;
+
+	int root = FindIsland(pnode->GetIslandIndex());
+	if (islandSlot[root] < 0)
 	{
-		tree->pnodesInZone.erase(location);
-		pnode->SetOctree(NULL);
+		islandSlot[root] = (int)numSolverIslands++;
+		if (solverIslands.size() < numSolverIslands)
+			solverIslands.resize(numSolverIslands);
+		solverIslands[islandSlot[root]] = SolverIsland();
+	}
+	return islandSlot[root];
+}
 
-		if (tree->pnodesInZone.size() == 0)
-		{
-			return true;
-			for (int i = 0; i < 8; ++i)
-				if (tree->children[i]) return false;
-		}
+void PhysicsEngine::SolveIsland(SolverIsland& island)
+{
+	Manifold* const* islandManifolds = solverManifolds.data() + island.firstManifold;
+	Constraint* const* islandConstraints = solverConstraints.data() + island.firstConstraint;
+
+	if (SolvesWithSIMD(island))
+	{
+		simdSolvers[omp_get_thread_num()].Solve(islandManifolds, island.numManifolds, solverIterations, physicsNodes.size());
+		return;
 	}
-	else
+
+	for (int i = 0; i < solverIterations; ++i)
 	{
-		__debugbreak;
-		return false;
+		for (size_t j = 0; j < island.numManifolds; ++j) islandManifolds[j]->ApplyImpulse();
+		for (size_t j = 0; j < island.numConstraints; ++j) islandConstraints[j]->ApplyImpulse();
 	}
-	return false;
 }
 
-void PhysicsEngine::MoveUp(Octree* tree, PhysicsNode* pnode)
+void PhysicsEngine::BenchmarkContactSolvers(int repeats)
 {
-	if (!InOctree(tree, pnode))
+	if (manifolds.empty())
 	{
-		if (tree->parent)
-		{
-			Octree* parent = tree->parent;
+		NCLLOG("[Solver Benchmark] No contacts to solve");
+		return;
+	}
 
-			bool destroy = false;
-			if (tree->pnodesInZone.size() == 0)
-			{
-				destroy = true;
-				for (int i = 0; i < 8; ++i)
-					if (tree->children[i]) destroy = false;
-			}
-			if (destroy) TerminateOctree(tree);
+	//Everything the solvers change is put back afterwards
+	std::vector<std::vector<ContactPoint>> savedContacts(manifolds.size());
+	std::vector<PhysicsNode*> savedNodes;
+	std::vector<Vector3> savedVelocities;
+	size_t numContacts = 0;
+	for (size_t i = 0; i < manifolds.size(); ++i)
+	{
+		Manifold* m = manifolds[i];
+		savedContacts[i] = m->contactPoints;
+		numContacts += m->contactPoints.size();
 
-			MoveUp(parent, pnode);
-		}
-		else	// node isn't in the bounds of even the root tree
+		PhysicsNode* pnodes[2] = { m->NodeA(), m->NodeB() };
+		for (PhysicsNode* pnode : pnodes)
 		{
-			//__debugbreak;
-			return;
+			savedNodes.push_back(pnode);
+			savedVelocities.push_back(pnode->GetLinearVelocity());
+			savedVelocities.push_back(pnode->GetAngularVelocity());
 		}
 	}
-	else
+
+	auto restore = [&]()
+	{
+		for (size_t i = 0; i < manifolds.size(); ++i)
+			manifolds[i]->contactPoints = savedContacts[i];
+
+		//Backwards, so a node in more than one manifold ends up with the first values saved
+		for (size_t i = savedNodes.size(); i-- > 0;)
+		{
+			if (savedNodes[i]->IsStatic())
+				continue;
+			savedNodes[i]->SetLinearVelocity(savedVelocities[i * 2]);
+			savedNodes[i]->SetAngularVelocity(savedVelocities[i * 2 + 1]);
+		}
+	};
+
+	if (simdSolvers.empty())
+		simdSolvers.resize(1);
+
+	GameTimer timer;
+	timer.GetTimedMS();
+	for (int r = 0; r < repeats; ++r)
 	{
-		AddToOctree(tree, pnode);
+		for (int i = 0; i < solverIterations; ++i)
+		{
+			for (Manifold* m : manifolds) m->ApplyImpulse();
+		}
 	}
+	float scalarMs = max(timer.GetTimedMS(), 1e-3f);
+	restore();
+
+	timer.GetTimedMS();
+	for (int r = 0; r < repeats; ++r)
+		simdSolvers[0].Solve(manifolds.data(), manifolds.size(), solverIterations, physicsNodes.size());
+	float simdMs = max(timer.GetTimedMS(), 1e-3f);
+	restore();
+
+	//Both are single threaded, and the SIMD time includes gathering/scattering the contacts
+	float solved = (float)numContacts * solverIterations * repeats;
+	NCLLOG("[Solver Benchmark] %d contacts, %d iterations, %d repeats", (int)numContacts, solverIterations, repeats);
+	NCLLOG("    Scalar         : %8.2fms (%.2fM contacts/s)", scalarMs, solved / (scalarMs * 1000.0f));
+	NCLLOG("    SIMD (%d wide)  : %8.2fms (%.2fM contacts/s)", CONTACT_SIMD_WIDTH, simdMs, solved / (simdMs * 1000.0f));
 }
 
-void PhysicsEngine::TerminateOctree(Octree* tree)
+void PhysicsEngine::BuildSolverBatches(const SolverIsland& island)
 {
-	for (int i = 0; i < tree->pnodesInZone.size(); ++i)
-		tree->pnodesInZone[i]->SetOctree(NULL);
-	for (int i = 0; i < 8; ++i)
+	const size_t numManifolds = island.numManifolds;
+	const size_t numConstraints = island.numConstraints;
+	Manifold* const* islandManifolds = solverManifolds.data() + island.firstManifold;
+	Constraint* const* islandConstraints = solverConstraints.data() + island.firstConstraint;
+
+	solverBatches.assign(SOLVER_MAX_BATCHES + 1, SolverBatch());
+	batchManifolds.resize(numManifolds);
+	batchConstraints.resize(numConstraints);
+	batchEntryColours.resize(numManifolds + numConstraints);
+
+	//1. Color and count each batch
+	// - Going through in order keeps the coloring the same run to run
+	for (size_t i = 0; i < numManifolds; ++i)
+	{
+		int colour = GetSolverBatchColour(islandManifolds[i]->NodeA(), islandManifolds[i]->NodeB());
+		batchEntryColours[i] = colour;
+		solverBatches[colour].numManifolds++;
+	}
+
+	for (size_t i = 0; i < numConstraints; ++i)
+	{
+		int colour = GetSolverBatchColour(islandConstraints[i]->GetNodeA(), islandConstraints[i]->GetNodeB());
+		batchEntryColours[numManifolds + i] = colour;
+		solverBatches[colour].numConstraints++;
+	}
+
+	//2. Give each batch its range
+	size_t firstManifold = 0, firstConstraint = 0;
+	for (SolverBatch& batch : solverBatches)
 	{
-		if (tree->children[i])
-			TerminateOctree(tree->children[i]);
+		batch.firstManifold = firstManifold;
+		batch.firstConstraint = firstConstraint;
+		firstManifold += batch.numManifolds;
+		firstConstraint += batch.numConstraints;
+		batch.numManifolds = 0;
+		batch.numConstraints = 0;
+	}
 
-		if (tree->parent)
-			if (tree->parent->children[i] == tree)
-				tree->parent->children[i] = NULL;
+	//3. Fill them in order
+	for (size_t i = 0; i < numManifolds; ++i)
+	{
+		SolverBatch& batch = solverBatches[batchEntryColours[i]];
+		batchManifolds[batch.firstManifold + batch.numManifolds++] = islandManifolds[i];
 	}
-	for (int i = 0; i < 8; ++i)
+
+	for (size_t i = 0; i < numConstraints; ++i)
 	{
-		tree->children[i] = NULL;
+		SolverBatch& batch = solverBatches[batchEntryColours[numManifolds + i]];
+		batchConstraints[batch.firstConstraint + batch.numConstraints++] = islandConstraints[i];
 	}
-	delete tree;
-	tree->parent = NULL;
-	tree = NULL;
 }
 
-// must check node is COMPLETELY within a tree when moving up the tree
-// assume node is in a tree when moving down and do not run this function
-bool PhysicsEngine::InOctree(Octree* tree, PhysicsNode* pnode)
+int PhysicsEngine::GetSolverBatchColour(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
 {
-	Vector3 pos = tree->pos;
-	Vector3 dims = tree->dimensions;
-	Vector3 pPos = pnode->GetPosition();
-	float radius = pnode->GetBoundingRadius();
+	//Static objects are never written to by the solver, so they can't conflict
+	uint* coloursA = (pnodeA && !pnodeA->IsStatic()) ? &batchColours[pnodeA->GetIslandIndex()] : NULL;
+	uint* coloursB = (pnodeB && !pnodeB->IsStatic()) ? &batchColours[pnodeB->GetIslandIndex()] : NULL;
+	if (!coloursA && !coloursB)
+		return SOLVER_MAX_BATCHES;
 
-	// normally make sure the node is entirely in the tree
-	// if the tree is the root, we want to check to see
-	// if ANY of the node is in the tree
-	if (tree == root)
-		radius = -radius;
+	uint used = (coloursA ? *coloursA : 0) | (coloursB ? *coloursB : 0);
 
-	float xBounds[2] = { pos.x - dims.x, pos.x + dims.x };
-	float yBounds[2] = { pos.y - dims.y, pos.y + dims.y };
-	float zBounds[2] = { pos.z - dims.z, pos.z + dims.z };
+	int colour = 0;
+	while (colour < SOLVER_MAX_BATCHES && (used & (1u << colour)))
+		++colour;
 
-	// check that the extremes of the node are entirely in the current tree
-	if (pPos.x - radius > xBounds[0])
+	if (colour == SOLVER_MAX_BATCHES)
+		return colour;
+
+	if (coloursA) *coloursA |= 1u << colour;
+	if (coloursB) *coloursB |= 1u << colour;
+	numSolverBatches = max(numSolverBatches, (size_t)colour + 1);
+	return colour;
+}
+
+void PhysicsEngine::SolveBatches()
+{
+	const int numBatches = (int)numSolverBatches;
+	const SolverBatch& serialBatch = solverBatches[SOLVER_MAX_BATCHES];
+
+	//One team of threads for all the iterations, the end of each batch is a barrier
+	#pragma omp parallel if (parallelSolver)
 	{
-		if (pPos.x + radius < xBounds[1])
+		for (int i = 0; i < solverIterations; ++i)
 		{
-			if (pPos.y - radius > yBounds[0])
+			for (int b = 0; b < numBatches; ++b)
 			{
-				if (pPos.y + radius < yBounds[1])
+				const SolverBatch& batch = solverBatches[b];
+				Manifold* const* ms = batchManifolds.data() + batch.firstManifold;
+				Constraint* const* cs = batchConstraints.data() + batch.firstConstraint;
+				const int numManifolds = (int)batch.numManifolds;
+				const int numEntries = numManifolds + (int)batch.numConstraints;
+
+				#pragma omp for schedule(static)
+				for (int j = 0; j < numEntries; ++j)
 				{
-					if (pPos.z - radius > zBounds[0])
-					{
-						if (pPos.z + radius < zBounds[1])
-						{
-							return true;
-						}
-					}
+					if (j < numManifolds)
+						ms[j]->ApplyImpulse();
+					else
+						cs[j - numManifolds]->ApplyImpulse();
 				}
 			}
+
+			#pragma omp single
+			{
+				Manifold* const* ms = batchManifolds.data() + serialBatch.firstManifold;
+				Constraint* const* cs = batchConstraints.data() + serialBatch.firstConstraint;
+				for (size_t j = 0; j < serialBatch.numManifolds; ++j) ms[j]->ApplyImpulse();
+				for (size_t j = 0; j < serialBatch.numConstraints; ++j) cs[j]->ApplyImpulse();
+			}
 		}
 	}
+}
 
-	return false;
+int PhysicsEngine::FindIsland(int idx)
+{
+	//Path halving keeps the trees flat
+	while (islandParent[idx] != idx)
+	{
+		islandParent[idx] = islandParent[islandParent[idx]];
+		idx = islandParent[idx];
+	}
+	return idx;
 }
 
-// the return value's 8 bits tell you which octants the pnode is in
-// so 11111111 is in all 8 octants of the octree
-std::bitset<8> PhysicsEngine::WhichZones(Vector3 pos, PhysicsNode* pnode)
+void PhysicsEngine::UnionIslands(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
 {
-	unsigned char output = 0x00;
-	Vector3 pPos = pnode->GetPosition();
-	float radius = pnode->GetBoundingRadius();
+	//Static objects don't join islands, otherwise everything resting on
+	// the floor would be in one big island
+	if (pnodeA->IsStatic() || pnodeB->IsStatic())
+		return;
 
-	if (pPos.x + radius > pos.x)			// 2nd half of x
+	int rootA = FindIsland(pnodeA->GetIslandIndex());
+	int rootB = FindIsland(pnodeB->GetIslandIndex());
+	if (rootA != rootB)
+		islandParent[rootB] = rootA;
+}
+
+void PhysicsEngine::UpdateSleeping()
+{
+	const int numNodes = (int)physicsNodes.size();
+	numAwakeNodes = 0;
+
+	//An island can only sleep once all of its objects have been resting for long enough
+	for (int i = 0; i < numNodes; ++i)
 	{
-		if (pPos.y + radius > pos.y)		// 2nd half of y
-		{
-			if (pPos.z + radius > pos.z)	// 2nd half of z
-				output |= 0x80;
-			if (pPos.z - radius < pos.z)	// 1st half of z
-				output |= 0x08;
-		}
-		if (pPos.y - radius < pos.y)		// 1st half of y
-		{
-			if (pPos.z + radius > pos.z)	// 2nd half of z
-				output |= 0x20;
-			if (pPos.z - radius < pos.z)	// 1st half of z
-				output |= 0x02;
-		}
+		PhysicsNode* pnode = physicsNodes[i];
+		if (pnode->IsStatic() || !pnode->IsAwake())
+			continue;
+
+		pnode->UpdateSleepCounter(SLEEP_LINEAR_VELOCITY, SLEEP_ANGULAR_VELOCITY);
+
+		uint& counter = islandSleepCounter[FindIsland(i)];
+		counter = min(counter, pnode->GetSleepCounter());
 	}
-	if (pPos.x - radius < pos.x)			// 1st half of x
+
+	for (int i = 0; i < numNodes; ++i)
 	{
-		if (pPos.y + radius > pos.y)		// 2nd half of y
-		{
-			if (pPos.z + radius > pos.z)	// 2nd half of z
-				output |= 0x40;
-			if (pPos.z - radius < pos.z)	// 1st half of z
-				output |= 0x04;
-		}
-		if (pPos.y - radius < pos.y)		// 1st half of y
-		{
-			if (pPos.z + radius > pos.z)	// 2nd half of z
-				output |= 0x10;
-			if (pPos.z - radius < pos.z)	// 1st half of z
-				output |= 0x01;
-		}
+		PhysicsNode* pnode = physicsNodes[i];
+		if (pnode->IsStatic() || !pnode->IsAwake())
+			continue;
+
+		if (sleepingEnabled && islandSleepCounter[FindIsland(i)] >= SLEEP_STEPS)
+			pnode->Sleep();
+		else
+			++numAwakeNodes;
 	}
+}
+
+void PhysicsEngine::ToggleSleeping()
+{
+	sleepingEnabled = !sleepingEnabled;
+
+	if (!sleepingEnabled)
+	{
+		for (PhysicsNode* pnode : physicsNodes)
+			pnode->Wake();
+	}
+}
 
-	return output;
+void PhysicsEngine::SphereSphereCull()
+{
+	//do a coarse sphere-sphere check using bounding radii of the rendernodes
+	auto culled = std::remove_if(broadphaseColPairs.begin(), broadphaseColPairs.end(),
+		[this](const CollisionPair& cp)
+	{
+		++numSphereChecks;
+		Vector3 ab = cp.pObjectA->GetPosition() - cp.pObjectB->GetPosition();
+		return ab.Length() > cp.pObjectA->GetBoundingRadius() + cp.pObjectB->GetBoundingRadius();
+	});
+	broadphaseColPairs.erase(culled, broadphaseColPairs.end());
+}
+
+void PhysicsEngine::SortCollisionPairs()
+{
+	for (size_t i = 0; i < physicsNodes.size(); ++i)
+		physicsNodes[i]->SetIslandIndex((int)i);
+
+	for (CollisionPair& cp : broadphaseColPairs)
+	{
+		if (cp.pObjectA->GetIslandIndex() > cp.pObjectB->GetIslandIndex())
+			std::swap(cp.pObjectA, cp.pObjectB);
+	}
+
+	std::sort(broadphaseColPairs.begin(), broadphaseColPairs.end(), [](const CollisionPair& a, const CollisionPair& b)
+	{
+		if (a.pObjectA->GetIslandIndex() != b.pObjectA->GetIslandIndex())
+			return a.pObjectA->GetIslandIndex() < b.pObjectA->GetIslandIndex();
+		return a.pObjectB->GetIslandIndex() < b.pObjectB->GetIslandIndex();
+	});
+}
+
+const char* PhysicsEngine::GetBroadphaseName()
+{
+	switch (broadphaseMode)
+	{
+	case BROADPHASE_OCTREE:			return "Octree";
+	case BROADPHASE_SWEEPANDPRUNE:	return "Sweep and Prune";
+	case BROADPHASE_AABBTREE:		return "AABB Tree";
+	case BROADPHASE_SPATIALHASH:	return "Spatial Hash";
+	default:						return "Brute Force";
+	}
+}
+
+const char* PhysicsEngine::GetNarrowphaseName()
+{
+	switch (narrowphaseMode)
+	{
+	case NARROWPHASE_SAT:			return "SAT";
+	case NARROWPHASE_GJK:			return "GJK/EPA";
+	default:						return "Shape Dispatch";
+	}
 }
 
 void PhysicsEngine::NarrowPhaseCollisions()
 {
+	colDetect.SetMode(narrowphaseMode);
+	colDetect.GetSAT().ResetCacheCounters();
+
 	if (broadphaseColPairs.size() > 0)
 	{
 		//Collision data to pass between detection and manifold generation stages.
 		CollisionData colData;
 
-		//Collision Detection Algorithm to use
-		CollisionDetectionSAT colDetect;
-
 		// Iterate over all possible collision pairs and perform accurate collision detection
 		for (size_t i = 0; i < broadphaseColPairs.size(); ++i)
 		{
 			CollisionPair& cp = broadphaseColPairs[i];
 
-			CollisionShape *shapeA = cp.pObjectA->GetCollisionShape();
-			CollisionShape *shapeB = cp.pObjectB->GetCollisionShape();
-
-			PhysicsNode* pnodeA = cp.pObjectA;
-			PhysicsNode* pnodeB = cp.pObjectB;
+			//Keep the pair in the order its manifold was created with, so the
+			// new contacts can be matched up with last step's
+			Manifold* manifold = FindManifold(cp.pObjectA, cp.pObjectB);
+			if (manifold && manifold->NodeA() != cp.pObjectA)
+				std::swap(cp.pObjectA, cp.pObjectB);
 
-			colDetect.BeginNewPair(
-				cp.pObjectA,
-				cp.pObjectB,
-				cp.pObjectA->GetCollisionShape(),
-				cp.pObjectB->GetCollisionShape());
+			//Picks the test for this pair of shape types, falling back on SAT
+			colDetect.BeginNewPair(cp.pObjectA, cp.pObjectB);
+			if (colDetect.UsesPairCache())
+				colDetect.SetPairCache(GetNarrowphaseCache(cp.pObjectA, cp.pObjectB));
 
 			//--TUTORIAL 4 CODE--
 			// Detects if the objects are colliding
@@ -720,7 +1206,7 @@ void PhysicsEngine::NarrowPhaseCollisions()
 
 				//Draw collision data to the window if requested
 				// - Have to do this here as colData is only temporary. 
-				if (debugDrawFlags & DEBUGDRAW_FLAGS_COLLISIONNORMALS)
+				if ((debugDrawFlags & DEBUGDRAW_FLAGS_COLLISIONNORMALS) && !OnPhysicsThread())
 				{
 					NCLDebug::DrawPointNDT(colData._pointOnPlane, 0.1f, Vector4(0.5f, 0.5f, 1.0f, 1.0f));
 					NCLDebug::DrawThickLineNDT(colData._pointOnPlane, colData._pointOnPlane - colData._normal * colData._penetration, 0.05f, Vector4(0.0f, 0.0f, 1.0f, 1.0f));
@@ -735,9 +1221,8 @@ void PhysicsEngine::NarrowPhaseCollisions()
 					/* TUTORIAL 5 CODE */
 					// Build full collision manifold that will also handle the
 					// collision response between the two objects in the solver stage
-					Manifold* manifold = new Manifold();
-
-					manifold->Initiate(cp.pObjectA, cp.pObjectB);
+					// Manifolds persist between steps, any without contacts are deleted by PurgeManifolds
+					manifold = BeginManifold(cp.pObjectA, cp.pObjectB);
 
 					// Construct contact points that form the perimeter of the collision manifold
 
@@ -749,170 +1234,297 @@ void PhysicsEngine::NarrowPhaseCollisions()
 						manifolds.push_back(manifold);
 
 						//Draw manifold data to the window if requested
-						if (debugDrawFlags & DEBUGDRAW_FLAGS_MANIFOLD)
+						if ((debugDrawFlags & DEBUGDRAW_FLAGS_MANIFOLD) && !OnPhysicsThread())
 							manifold->DebugDraw();
 					}
-					else
-					{
-						delete manifold;
-						manifold = NULL;
-					}
 				}
 			}
 		}
 	}
 }
 
-void PhysicsEngine::ToggleGPUAcceleration()
+Manifold* PhysicsEngine::FindManifold(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
 {
-	gpuAccel = !gpuAccel;
+	PhysicsNodePair key = pnodeA < pnodeB ? PhysicsNodePair(pnodeA, pnodeB) : PhysicsNodePair(pnodeB, pnodeA);
+	auto found = manifoldCache.find(key);
+	return found != manifoldCache.end() ? found->second : NULL;
+}
 
-	if (gpuAccel)
+Manifold* PhysicsEngine::BeginManifold(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
+{
+	PhysicsNodePair key = pnodeA < pnodeB ? PhysicsNodePair(pnodeA, pnodeB) : PhysicsNodePair(pnodeB, pnodeA);
+	Manifold*& manifold = manifoldCache[key];
+
+	if (manifold == NULL)
 	{
-		if (!CUDA_init(physicsNodes.size() - 5))
-			cout << "Error initialising CUDA memory" << endl;
+		manifold = manifoldPool.Acquire();
+		manifold->Initiate(pnodeA, pnodeB);
+	}
+	else if (manifold->lastUsedStep != stepCount)
+	{
+		manifold->BeginNewStep();
+	}
+
+	manifold->lastUsedStep = stepCount;
+	return manifold;
+}
+
+void PhysicsEngine::PurgeManifolds()
+{
+	for (auto itr = manifoldCache.begin(); itr != manifoldCache.end();)
+	{
+		Manifold* m = itr->second;
+
+		//Sleeping contacts aren't regenerated, but are kept to hold their island together
+		bool sleeping = m->lastUsedStep != stepCount && IsSleepingPair(m->NodeA(), m->NodeB());
 
-		for (int i = 0; i < physicsNodes.size(); ++i)
+		if (!sleeping && (m->lastUsedStep != stepCount || m->contactPoints.size() == 0))
 		{
+			manifoldPool.Release(m);
+			itr = manifoldCache.erase(itr);
+		}
+		else
+			++itr;
+	}
+}
 
+NarrowphaseCache* PhysicsEngine::GetNarrowphaseCache(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
+{
+	PhysicsNodePair key = pnodeA < pnodeB ? PhysicsNodePair(pnodeA, pnodeB) : PhysicsNodePair(pnodeB, pnodeA);
+	auto inserted = narrowphaseCache.insert(std::make_pair(key, NarrowphaseCache()));
+
+	NarrowphaseCache& cache = inserted.first->second;
+	if (inserted.second)
+	{
+		cache.nodeA = pnodeA;
+		cache.gjkValid = false;
+		cache.satValid = false;
+	}
+	cache.lastUsedStep = stepCount;
+	return &cache;
+}
+
+void PhysicsEngine::PurgeNarrowphaseCache()
+{
+	for (auto itr = narrowphaseCache.begin(); itr != narrowphaseCache.end();)
+	{
+		if (itr->second.lastUsedStep != stepCount)
+			itr = narrowphaseCache.erase(itr);
+		else
+			++itr;
+	}
+}
+
+void PhysicsEngine::RemoveNodeManifolds(PhysicsNode* pnode)
+{
+	auto active = std::remove_if(manifolds.begin(), manifolds.end(),
+		[pnode](Manifold* m) { return m->NodeA() == pnode || m->NodeB() == pnode; });
+	manifolds.erase(active, manifolds.end());
+
+	for (auto itr = manifoldCache.begin(); itr != manifoldCache.end();)
+	{
+		if (itr->first.first == pnode || itr->first.second == pnode)
+		{
+			manifoldPool.Release(itr->second);
+			itr = manifoldCache.erase(itr);
 		}
+		else
+			++itr;
 	}
-	else
+
+	for (auto itr = narrowphaseCache.begin(); itr != narrowphaseCache.end();)
 	{
-		if (!CUDA_free())
-			cout << "Error freeing CUDA memory" << endl;
+		if (itr->first.first == pnode || itr->first.second == pnode)
+			itr = narrowphaseCache.erase(itr);
+		else
+			++itr;
 	}
 }
 
+void PhysicsEngine::ToggleGPUAcceleration()
+{
+	gpuAccel = !gpuAccel;
+
+	if (!gpuAccel)
+		FreeCUDAMemory();
+}
+
+void PhysicsEngine::SetSphereAccelBackend(SphereAccelBackend backend)
+{
+#ifndef USE_CUDA
+	//Nothing to run the CUDA version on in this build
+	backend = SPHEREACCEL_CPU;
+#endif
+	if (backend != SPHEREACCEL_CUDA)
+		FreeCUDAMemory();
+
+	sphereAccelBackend = backend;
+}
+
+const char* PhysicsEngine::GetSphereAccelBackendName() const
+{
+	return sphereAccelBackend == SPHEREACCEL_CUDA ? "CUDA" : "CPU";
+}
+
+void PhysicsEngine::FreeCUDAMemory()
+{
+#ifdef USE_CUDA
+	if (cudaCapacity > 0 && !CUDA_free())
+		cout << "Error freeing CUDA memory" << endl;
+#endif
+	cudaCapacity = 0;
+}
+
 void PhysicsEngine::GPUCollisionCheck()
 {
 	broadphaseColPairs.clear();
+	accelSpheres.clear();
+	accelOthers.clear();
+
+	//Only dynamic spheres can go through the accelerated test. Static objects (walls,
+	// floors etc) and any other shapes are left for the narrowphase.
+	for (PhysicsNode* pnode : physicsNodes)
+	{
+		CollisionShape* shape = pnode->GetCollisionShape();
+		if (shape == NULL)
+			continue;
 
-	int arrSize = physicsNodes.size() - 5;   //5 is the number of walls and floors and ceilings
-	Vector3* positions = new Vector3[arrSize];
-	float* radii = new float[arrSize];
+		if (!pnode->IsStatic() && shape->GetType() == COLLISIONSHAPE_SPHERE)
+			accelSpheres.push_back(pnode);
+		else
+			accelOthers.push_back(pnode);
+	}
 
-	int index = 0;
-	for (int i = 0; i < physicsNodes.size(); ++i)
+	for (size_t i = 0; i < accelOthers.size(); ++i)
 	{
-		PhysicsNode* pnodeA = physicsNodes[i];
-		if (pnodeA->GetParent()->GetName().compare("Ground") == 0)
-		{
-			for (int j = 0; j < physicsNodes.size(); ++j)
-			{
-				if (j == i) continue;
+		for (size_t j = i + 1; j < accelOthers.size(); ++j)
+			AddAccelColPair(accelOthers[i], accelOthers[j]);
 
-				PhysicsNode* pnodeB = physicsNodes[j];
-				//Check they both atleast have collision shapes
-				if (pnodeA->GetCollisionShape() != NULL
-					&& pnodeB->GetCollisionShape() != NULL)
-				{
-					CollisionPair cp;
-					cp.pObjectA = pnodeA;
-					cp.pObjectB = pnodeB;
+		for (PhysicsNode* sphere : accelSpheres)
+			AddAccelColPair(accelOthers[i], sphere);
+	}
 
-					bool spherePass = true;
-					if (sphereSphere)
-					{
-						Vector3 ab = cp.pObjectA->GetPosition() - cp.pObjectB->GetPosition();
-						spherePass = ab.Length() <= pnodeA->GetBoundingRadius() + pnodeB->GetBoundingRadius() ? true : false;
-						++numSphereChecks;
-					}
+	if (sphereAccelBackend == SPHEREACCEL_CUDA)
+	{
+		CUDASphereContacts();
+		return;
+	}
 
-					//do a coarse sphere-sphere check using bounding radii of the rendernodes
-					if (spherePass)
-						broadphaseColPairs.push_back(cp);
-				}
-			}
-			continue;
-		}
-		if (pnodeA->GetParent()->GetName().compare("Wall") == 0)
-		{
-			for (int j = 0; j < physicsNodes.size(); ++j)
-			{
-				if (j == i) continue;
+	sphereCPU.Clear();
+	sphereCPU.Reserve(accelSpheres.size());
+	for (PhysicsNode* pnode : accelSpheres)
+		sphereCPU.AddSphere(pnode->GetPosition(), pnode->GetBoundingRadius());
 
-				PhysicsNode* pnodeB = physicsNodes[j];
-				//Check they both atleast have collision shapes
-				if (pnodeA->GetCollisionShape() != NULL
-					&& pnodeB->GetCollisionShape() != NULL)
-				{
-					CollisionPair cp;
-					cp.pObjectA = pnodeA;
-					cp.pObjectB = pnodeB;
+	sphereCPU.FindContacts();
+	numSphereChecks += (int)sphereCPU.NumTests();
 
-					bool spherePass = true;
-					if (sphereSphere)
-					{
-						Vector3 ab = cp.pObjectA->GetPosition() - cp.pObjectB->GetPosition();
-						spherePass = ab.Length() <= pnodeA->GetBoundingRadius() + pnodeB->GetBoundingRadius() ? true : false;
-						++numSphereChecks;
-					}
+	for (const SphereContact& c : sphereCPU.GetContacts())
+	{
+		AddSphereContact(accelSpheres[c.indexA], accelSpheres[c.indexB],
+			c.globalOnA, c.globalOnB, c.normal, c.penetration);
+	}
+}
 
-					//do a coarse sphere-sphere check using bounding radii of the rendernodes
-					if (spherePass)
-						broadphaseColPairs.push_back(cp);
-				}
-			}
-			continue;
-		}
+void PhysicsEngine::AddAccelColPair(PhysicsNode* pnodeA, PhysicsNode* pnodeB)
+{
+	//Static objects can't collide with each other
+	if (pnodeA->IsStatic() && pnodeB->IsStatic())
+		return;
 
-		if (index >= arrSize)
-		{
-			__debugbreak;
+	if (IsSleepingPair(pnodeA, pnodeB))
+		return;
+
+	//do a coarse sphere-sphere check using bounding radii of the rendernodes
+	if (sphereSphere)
+	{
+		++numSphereChecks;
+		Vector3 ab = pnodeA->GetPosition() - pnodeB->GetPosition();
+		if (ab.Length() > pnodeA->GetBoundingRadius() + pnodeB->GetBoundingRadius())
 			return;
-		}
+	}
 
-		positions[index] = pnodeA->GetPosition();
-		radii[index] = pnodeA->GetBoundingRadius();
+	CollisionPair cp;
+	cp.pObjectA = pnodeA;
+	cp.pObjectB = pnodeB;
+	broadphaseColPairs.push_back(cp);
+}
 
-		++index;
+void PhysicsEngine::AddSphereContact(PhysicsNode* pnodeA, PhysicsNode* pnodeB,
+	const Vector3& globalOnA, const Vector3& globalOnB, const Vector3& normal, float penetration)
+{
+	if (IsSleepingPair(pnodeA, pnodeB))
+		return;
+
+	if (!pnodeA->FireOnCollisionEvent(pnodeA, pnodeB) || !pnodeB->FireOnCollisionEvent(pnodeB, pnodeA))
+		return;
+
+	Manifold* manifold = BeginManifold(pnodeA, pnodeB);
+
+	//Flip the contact round if the manifold was made with the nodes the other way
+	if (manifold->NodeA() == pnodeA)
+		manifold->AddContact(globalOnA, globalOnB, normal, penetration);
+	else
+		manifold->AddContact(globalOnB, globalOnA, -normal, penetration);
+
+	//Spheres only ever have the one contact, so this is the first time it's been seen this step
+	if (manifold->contactPoints.size() == 1)
+		manifolds.push_back(manifold);
+}
+
+void PhysicsEngine::CUDASphereContacts()
+{
+#ifdef USE_CUDA
+	int arrSize = (int)accelSpheres.size();
+	if (arrSize < 2)
+		return;
+
+	//The kernel writes out a result for every pair, so the buffers are n^2/2 long.
+	// They are only reallocated when the number of spheres grows.
+	if (arrSize > cudaCapacity)
+	{
+		FreeCUDAMemory();
+		if (!CUDA_init(arrSize))
+			cout << "Error initialising CUDA memory" << endl;
+		cudaCapacity = arrSize;
+	}
+
+	cudaPositions.resize(arrSize);
+	cudaRadii.resize(arrSize);
+	for (int i = 0; i < arrSize; ++i)
+	{
+		cudaPositions[i] = accelSpheres[i]->GetPosition();
+		cudaRadii[i] = accelSpheres[i]->GetBoundingRadius();
 	}
 
 	int maxNumColPairs = arrSize * arrSize * 0.5;
-	Vector3* globalOnA = new Vector3[maxNumColPairs];
-	Vector3* globalOnB = new Vector3[maxNumColPairs];
-	Vector3* normal = new Vector3[maxNumColPairs];
-	float* penetration = new float[maxNumColPairs];
-	int* indexA = new int[maxNumColPairs];
-	int* indexB = new int[maxNumColPairs];
+	cudaGlobalOnA.resize(maxNumColPairs);
+	cudaGlobalOnB.resize(maxNumColPairs);
+	cudaNormals.resize(maxNumColPairs);
+	cudaPenetrations.resize(maxNumColPairs);
+	cudaIndexA.resize(maxNumColPairs);
+	cudaIndexB.resize(maxNumColPairs);
 
-	CUDA_run(positions, radii, globalOnA, globalOnB, normal, penetration, indexA, indexB, arrSize);
+	CUDA_run(&cudaPositions[0], &cudaRadii[0], &cudaGlobalOnA[0], &cudaGlobalOnB[0], &cudaNormals[0],
+		&cudaPenetrations[0], &cudaIndexA[0], &cudaIndexB[0], arrSize);
+	numSphereChecks += arrSize * (arrSize - 1) / 2;
 
 	for (int i = 0; i < maxNumColPairs; ++i)
 	{
-		if (indexA[i] != -1)
+		if (cudaIndexA[i] != -1)
 		{
-			Manifold* manifold = new Manifold;
-
-			manifold->Initiate(physicsNodes[indexA[i] + 5], physicsNodes[indexB[i] + 5]);
-
-			manifold->AddContact(globalOnA[i], globalOnB[i], normal[i], penetration[i]);
-			if (manifold->contactPoints.size() > 0)
-			{
-				// Add to list of manifolds that need solving
-				manifolds.push_back(manifold);
-			}
-			else
-			{
-				delete manifold;
-				manifold = NULL;
-			}
+			AddSphereContact(accelSpheres[cudaIndexA[i]], accelSpheres[cudaIndexB[i]],
+				cudaGlobalOnA[i], cudaGlobalOnB[i], cudaNormals[i], cudaPenetrations[i]);
 		}
 	}
-
-	delete[] positions;
-	delete[] radii;
-	delete[] globalOnA;
-	delete[] globalOnB;
-	delete[] normal;
-	delete[] penetration;
-	delete[] indexA;
-	delete[] indexB;
+#endif
 }
 
 void PhysicsEngine::DebugRender()
 {
+	//Built during the broadphase, but drawn here so it isn't drawn from the physics thread
+	if (broadphaseMode == BROADPHASE_OCTREE)
+		octree.DebugDraw();
+
 	// Draw all collision manifolds
 	if (debugDrawFlags & DEBUGDRAW_FLAGS_MANIFOLD)
 	{
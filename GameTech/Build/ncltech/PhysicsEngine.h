@@ -30,25 +30,71 @@ Description:
 
 			 - Update Physics Objects
 			   Moves all physics objects through time, updating positions/rotations
-			   etc. each iteration (Tutorial 2)
+			   etc. each iteration (Tutorial 2). This runs over the PhysicsBodyStorage
+			   arrays every node's state is kept in, rather than node by node.
+
+	With SetThreaded(true) UpdatePhysics is instead called at a fixed rate on a
+	separate thread. After each step it publishes the transforms of every object
+	(triple buffered), and Update just hands the renderer the transforms
+	interpolated between the last two steps, so rendering and simulation can run
+	at their own rates.
 
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
 #include "PhysicsNode.h"
+#include "PhysicsBodyStorage.h"
 #include "Constraint.h"
 #include "Manifold.h"
-#include <nclgl\TSingleton.h>
-#include <nclgl\PerfTimer.h>
+#include "BroadphaseOctree.h"
+#include "BroadphaseSAP.h"
+#include "BroadphaseAABBTree.h"
+#include "BroadphaseSpatialHash.h"
+#include "SphereCollisionCPU.h"
+#include "ContactSolverSIMD.h"
+#include "CollisionDispatch.h"
+#include "ObjectPool.h"
+#include <nclgl/TSingleton.h>
+#include <nclgl/PerfTimer.h>
 #include <vector>
 #include <mutex>
-#include <bitset>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <cstdint>
+#include <unordered_map>
 
-//Number of jacobi iterations to apply in order to
+//Default number of jacobi iterations to apply in order to
 // assure the constraints are solved. (Last tutorial)
+// - With warm starting, Phy7_Solver's stack drifts no more after 10s at 10
+//   iterations than it does at 50 without
 #define SOLVER_ITERATIONS 50
 
 
+//Objects moving slower than these (m/s and rad/s) for SLEEP_STEPS steps in a
+// row are put to sleep, but only once everything in their island is ready to
+#define SLEEP_LINEAR_VELOCITY	0.05f
+#define SLEEP_ANGULAR_VELOCITY	0.05f
+#define SLEEP_STEPS				60
+
+//Islands with at least this many manifolds and constraints are split into
+// colored batches, so even a single big island can be solved in parallel
+#define SOLVER_BATCH_MIN_SIZE	64
+
+//Number of colors tried before anything left is put into one serial batch
+#define SOLVER_MAX_BATCHES		32
+
+//Seed the shuffles are reset to in deterministic mode, whenever the scene is reset
+#define DETERMINISTIC_SEED		5489
+
+//Most steps the physics thread will run to catch up before it gives up and
+// drops the rest of the time it is behind by
+#define PHYSICS_THREAD_MAX_STEPS	5
+
+//Fewest moved nodes whose transforms will be updated across threads
+#define TRANSFORM_SYNC_PARALLEL_MIN_NODES	128
+
+
 //Just saves including windows.h for the sake of defining true/false
 #ifndef FALSE
 	#define FALSE	0
@@ -62,23 +108,85 @@ Description:
 #define DEBUGDRAW_FLAGS_COLLISIONVOLUMES		0x4
 #define DEBUGDRAW_FLAGS_COLLISIONNORMALS		0x8
 
-//define the max number of objects per octree zone
-#define MAX_OBJECTS 5
-#define MIN_OCTANT_SIZE 2.0f
-
 struct CollisionPair	//Forms the output of the broadphase collision detection
 {
 	PhysicsNode* pObjectA;
 	PhysicsNode* pObjectB;
 };
 
-struct Octree
+//Persistent manifolds are looked up by their pair of nodes, lowest address first
+typedef std::pair<PhysicsNode*, PhysicsNode*> PhysicsNodePair;
+struct PhysicsNodePairHash
+{
+	size_t operator()(const PhysicsNodePair& p) const
+	{
+		return std::hash<PhysicsNode*>()(p.first) ^ (std::hash<PhysicsNode*>()(p.second) * 31);
+	}
+};
+
+//Range of the step's manifolds and constraints acting on one island. Islands only
+// share static objects, which the solver never writes to, so they can be solved
+// in parallel
+struct SolverIsland
+{
+	size_t						firstManifold, numManifolds;		// In solverManifolds
+	size_t						firstConstraint, numConstraints;	// In solverConstraints
+	bool						batched;
+};
+
+//Batches hold the same ranges (in batchManifolds/batchConstraints), but no two
+// entries in one share a dynamic object
+typedef SolverIsland SolverBatch;
+
+//Every node's transform before and after a physics step, published by the
+// physics thread for the render side to interpolate between
+struct TransformFrame
+{
+	std::vector<PhysicsNode*>	nodes;
+	std::vector<Vector3>		prevPositions, positions;
+	std::vector<Quaternion>		prevOrientations, orientations;
+	std::vector<bool>			awake;
+
+	float						leftoverAccum;		//Time left in the accumulator after the step (seconds)
+	float						publishTime;		//When the frame was published (ms, from the engine's timer)
+	bool						finished;			//Set once the renderer has reached the end of the frame
+};
+
+//Timings (ms) and counts of the last physics step, for benchmarking without the
+// once-a-second averages of the PerfTimers
+struct PhysicsStepStats
+{
+	float	integrationMs;
+	float	broadphaseMs;
+	float	narrowphaseMs;
+	float	solverMs;
+
+	size_t	numColPairs;		//Broadphase pairs (after any sphere-sphere culling)
+	size_t	numManifolds;		//Pairs actually in contact
+	size_t	numContacts;		//Contact points across all manifolds
+	size_t	numAwakeNodes;
+
+	size_t	numSATCacheTests;	//SAT pairs that had last step's axis to try first
+	size_t	numSATCacheHits;	//...and were still separated by it
+};
+
+//Backend used for the sphere-sphere tests when acceleration is turned on
+enum SphereAccelBackend
 {
-	Vector3 pos;
-	Vector3 dimensions;
-	std::vector<PhysicsNode*> pnodesInZone;
-	Octree* children[8];
-	Octree* parent;
+	SPHEREACCEL_CPU = 0,	//Grid culled, multithreaded tests (SphereCollisionCPU)
+	SPHEREACCEL_CUDA,		//All pairs on the GPU (CUDA_SphereSphereCheck.cu), only built with USE_CUDA
+	SPHEREACCEL_MAX
+};
+
+//Broadphase algorithm used to generate the collision pairs each step
+enum BroadphaseMode
+{
+	BROADPHASE_BRUTEFORCE = 0,
+	BROADPHASE_OCTREE,
+	BROADPHASE_SWEEPANDPRUNE,
+	BROADPHASE_AABBTREE,
+	BROADPHASE_SPATIALHASH,
+	BROADPHASE_MAX
 };
 
 class PhysicsEngine : public TSingleton<PhysicsEngine>
@@ -98,6 +206,22 @@ public:
 	
 	//Update Physics Engine
 	void Update(float deltaTime);			//DeltaTime here is 'seconds' since last update not milliseconds
+
+	//Updates the world transform and shape of every node moved since the last sync, then
+	// passes them on to their listeners all at once. This is done at the start and end of
+	// each step and every Update, but can be called to see a move straight away.
+	void SyncTransforms();
+
+	//Runs the fixed timestep simulation on its own thread instead of in Update. While
+	// this is on anything else touching the physics objects must hold GetPhysicsMutex(),
+	// including the call to Update, which just copies the latest (interpolated) transforms
+	// over to the renderer and passes on anything moved since.
+	void SetThreaded(bool threaded);
+	inline void ToggleThreaded()				{ SetThreaded(!IsThreaded()); }
+	inline bool IsThreaded() const				{ return physicsThread.joinable(); }
+	inline bool OnPhysicsThread() const			{ return std::this_thread::get_id() == physicsThreadId; }
+	inline std::mutex& GetPhysicsMutex()		{ return physicsMutex; }
+	inline size_t NumDroppedSteps() const		{ return numDroppedSteps; }
 	
 	//Debug draw all physics objects, manifolds and constraints
 	void DebugRender();
@@ -120,25 +244,118 @@ public:
 
 	inline float GetDeltaTime() const			{ return updateTimestep; }
 
-	inline void ToggleOctrees()					{ useOctree = !useOctree; }
-	inline bool Octrees()						{ return useOctree; }
-	void UpdateNodePosition(PhysicsNode* pnode);
+	inline int  GetSolverIterations() const		{ return solverIterations; }
+	inline void SetSolverIterations(int num)	{ solverIterations = max(num, 1); }
+
+	//Seeds each persistent contact with the impulses it ended last step with
+	inline void ToggleWarmStarting()			{ warmStarting = !warmStarting; }
+	inline bool WarmStarting() const			{ return warmStarting; }
+	inline size_t NumManifolds() const			{ return manifolds.size(); }
+
+	//Makes two runs of the same scene with the same inputs give bit identical results.
+	// Collision pairs and manifolds are put in node order every step, and the solver
+	// shuffles use a generator that is reseeded whenever the scene is reset.
+	void SetDeterministic(bool deterministic, uint seed = DETERMINISTIC_SEED);
+	inline void ToggleDeterministic()			{ SetDeterministic(!deterministic, deterministicSeed); }
+	inline bool Deterministic() const			{ return deterministic; }
+	inline std::mt19937& GetShuffleGenerator()	{ return shuffleGenerator; }
+
+	//Hash (FNV-1a) of the position, orientation, velocities and sleep state of every node
+	uint64_t ComputeStateChecksum() const;
+	//Checksum of the state at the end of the last step (only kept in deterministic mode)
+	inline uint64_t StepChecksum() const		{ return stepChecksum; }
+
+	//Resting islands are put to sleep and skipped until something wakes them
+	void ToggleSleeping();
+	inline bool Sleeping() const				{ return sleepingEnabled; }
+	inline size_t NumAwakeNodes() const			{ return numAwakeNodes; }
+	inline size_t NumIslands() const			{ return numIslands; }
+	//Nodes that aren't static (counted each call)
+	size_t NumDynamicNodes() const;
+
+	//Heap allocations made by the thread running the last physics step (only counted in
+	// debug builds, see AllocationCounter). Once everything has settled down this should stay at zero.
+	inline size_t NumStepAllocations() const	{ return stepAllocations; }
+	inline size_t NumPooledManifolds() const	{ return manifoldPool.NumAllocated(); }
+
+	//Independent islands are solved at the same time across all available cores
+	inline void ToggleParallelSolver()			{ parallelSolver = !parallelSolver; }
+	inline bool ParallelSolver() const			{ return parallelSolver; }
+	inline size_t NumSolverIslands() const		{ return numSolverIslands > 0 ? numSolverIslands - 1 : 0; }
+
+	//Large islands are graph colored into batches that are solved in parallel
+	// within each iteration (the order is fixed, so results are reproducible)
+	inline void ToggleBatchedSolver()			{ batchedSolver = !batchedSolver; }
+	inline bool BatchedSolver() const			{ return batchedSolver; }
+	inline size_t NumSolverBatches() const		{ return numSolverBatches; }
+
+	//Islands with only contacts in them are solved with the SIMD contact solver
+	// (others, and everything when disabled, go through Manifold::ApplyImpulse)
+	inline void ToggleSIMDSolver()				{ simdSolver = !simdSolver; }
+	inline bool SIMDSolver() const				{ return simdSolver; }
+
+	//Times both contact solvers over this step's manifolds and logs the number of
+	// contacts solved per second by each. The manifolds and velocities are left as they were.
+	void BenchmarkContactSolvers(int repeats);
+
+	inline void ToggleOctrees()					{ SetBroadphaseMode(broadphaseMode == BROADPHASE_OCTREE ? BROADPHASE_BRUTEFORCE : BROADPHASE_OCTREE); }
+	inline bool Octrees()						{ return broadphaseMode == BROADPHASE_OCTREE; }
+
+	//Split parameters of the octree can be changed at runtime
+	inline BroadphaseOctree& GetOctree()		{ return octree; }
+
+	inline void ToggleSweepAndPrune()			{ SetBroadphaseMode(broadphaseMode == BROADPHASE_SWEEPANDPRUNE ? BROADPHASE_BRUTEFORCE : BROADPHASE_SWEEPANDPRUNE); }
+	inline bool SweepAndPrune()					{ return broadphaseMode == BROADPHASE_SWEEPANDPRUNE; }
+
+	inline void ToggleAABBTree()				{ SetBroadphaseMode(broadphaseMode == BROADPHASE_AABBTREE ? BROADPHASE_BRUTEFORCE : BROADPHASE_AABBTREE); }
+	inline bool AABBTree()						{ return broadphaseMode == BROADPHASE_AABBTREE; }
+
+	inline void ToggleSpatialHash()				{ SetBroadphaseMode(broadphaseMode == BROADPHASE_SPATIALHASH ? BROADPHASE_BRUTEFORCE : BROADPHASE_SPATIALHASH); }
+	inline bool SpatialHash()					{ return broadphaseMode == BROADPHASE_SPATIALHASH; }
+
+	inline BroadphaseMode GetBroadphaseMode()	{ return broadphaseMode; }
+	inline void SetBroadphaseMode(BroadphaseMode mode) { broadphaseMode = mode; }
+	inline void CycleBroadphase()				{ SetBroadphaseMode((BroadphaseMode)((broadphaseMode + 1) % BROADPHASE_MAX)); }
+	const char* GetBroadphaseName();
+
+	//Test used by the narrowphase, reset to NARROWPHASE_DISPATCH with each scene
+	inline NarrowphaseMode GetNarrowphaseMode()	{ return narrowphaseMode; }
+	inline void SetNarrowphaseMode(NarrowphaseMode mode) { narrowphaseMode = mode; }
+	inline void CycleNarrowphase()				{ SetNarrowphaseMode((NarrowphaseMode)((narrowphaseMode + 1) % NARROWPHASE_MAX)); }
+	const char* GetNarrowphaseName();
 
 	inline void ToggleSphereCheck()				{ sphereSphere = !sphereSphere; }
 	inline bool SphereCheck()					{ return sphereSphere; }
 	inline int NumSphereChecks()				{ return numSphereChecks; }
 
+	//Dynamic spheres skip the broadphase and narrowphase and are collided with each other
+	// by the accelerated backend. Static objects and other shapes are paired with everything.
 	void ToggleGPUAcceleration();
 	inline bool GetGPUAccelerationState()		{ return gpuAccel; }
 
+	void SetSphereAccelBackend(SphereAccelBackend backend);
+	inline SphereAccelBackend GetSphereAccelBackend() const { return sphereAccelBackend; }
+	inline void CycleSphereAccelBackend()		{ SetSphereAccelBackend((SphereAccelBackend)((sphereAccelBackend + 1) % SPHEREACCEL_MAX)); }
+	const char* GetSphereAccelBackendName() const;
+
 	inline size_t NumColPairs()			{ return broadphaseColPairs.size(); }
 
+	//Per-stage timings and pair/contact counts of the last step (see Benchmark_Physics)
+	inline const PhysicsStepStats& GetLastStepStats() const { return lastStepStats; }
+
 	void PrintPerformanceTimers(const Vector4& color)
 	{
 		perfUpdate.PrintOutputToStatusEntry(color,		"    Integration :");
 		perfBroadphase.PrintOutputToStatusEntry(color,	"    Broadphase  :");
 		perfNarrowphase.PrintOutputToStatusEntry(color,	"    Narrowphase :");
 		perfSolver.PrintOutputToStatusEntry(color,		"    Solver      :");
+
+		if (lastStepStats.numSATCacheTests > 0)
+		{
+			NCLDebug::AddStatusEntry(color, "    SAT Cached Axis Hits : %5.1f%% (%d/%d)",
+				100.0f * lastStepStats.numSATCacheHits / lastStepStats.numSATCacheTests,
+				(int)lastStepStats.numSATCacheHits, (int)lastStepStats.numSATCacheTests);
+		}
 	}
 
 protected:
@@ -148,28 +365,89 @@ protected:
 	//The actual time-independant update function
 	void UpdatePhysics();
 
+	//Main loop of the physics thread
+	void PhysicsThreadLoop();
+	//Copies the transform of every node before/after the step into the back buffer
+	// and swaps it with the one ready for the renderer
+	void BeginTransformFrame();
+	void PublishTransformFrame();
+	//Passes the interpolated transforms of the latest frame on to each node's update callback
+	void SyncRenderTransforms();
+	//Forgets any published transforms, for when nodes are removed
+	void ClearTransformFrames();
+
+	//Points every node from first onwards at its slot in the body arrays
+	void BindBodies(size_t first);
+
 	//Handles broadphase collision detection
 	void BroadPhaseCollisions();
-	//Generates Collsion pairs from an Octree
-	void GenColPairs(Octree* tree, std::vector<PhysicsNode*> parentPnodes);
-	void AddToOctree(Octree* tree, PhysicsNode* pnode);
-	void DrawOctree(Octree* tree);
-	void MoveUp(Octree* tree, PhysicsNode* pnode);
-	void ResetRoot();
-	bool FindAndDelete(Octree* tree, PhysicsNode* pnode);
-	//delete all heap Octree structs
-	void TerminateOctree(Octree* tree);
-	//checks to see which zones a node is in
-	std::bitset<8> WhichZones(Vector3 pos, PhysicsNode* pnode);
-	bool InOctree(Octree* tree, PhysicsNode* pnode);
+
+	//Removes any broadphase pairs whose bounding spheres don't overlap
+	void SphereSphereCull();
+
+	//True if neither node can be moved by a collision between them this step
+	// (both asleep, or one asleep and the other static)
+	inline bool IsSleepingPair(PhysicsNode* pnodeA, PhysicsNode* pnodeB) const
+	{
+		return (!pnodeA->IsAwake() || pnodeA->IsStatic())
+			&& (!pnodeB->IsAwake() || pnodeB->IsStatic())
+			&& (!pnodeA->IsAwake() || !pnodeB->IsAwake());
+	}
+
+	//Joins all non-static nodes touching through a manifold or constraint into islands
+	// and wakes any island with an awake node in it
+	void BuildIslands();
+	int  FindIsland(int idx);
+	void UnionIslands(PhysicsNode* pnodeA, PhysicsNode* pnodeB);
+	//Puts any island which has been resting for SLEEP_STEPS to sleep
+	void UpdateSleeping();
+
+	//Sorts this step's manifolds and constraints by the island they act on, keeping
+	// their (shuffled) order within each island. Each island is counted first, so
+	// they all fit in one array that is reused step to step
+	void BuildSolverIslands();
+	int  GetSolverIslandSlot(PhysicsNode* pnodeA, PhysicsNode* pnodeB);
+	//Runs all solver iterations over a single island
+	void SolveIsland(SolverIsland& island);
+	inline bool SolvesWithSIMD(const SolverIsland& island) const { return simdSolver && island.numConstraints == 0; }
+
+	//Greedily colors the island's manifolds and constraints so that no two with
+	// the same color act on the same dynamic object
+	void BuildSolverBatches(const SolverIsland& island);
+	int  GetSolverBatchColour(PhysicsNode* pnodeA, PhysicsNode* pnodeB);
+	//Runs all solver iterations over the batches, one batch at a time
+	void SolveBatches();
+
+	//Puts the collision pairs in order of the nodes' indices, so the narrowphase (and every
+	// manifold list built from it) no longer depends on the broadphase used or its history
+	void SortCollisionPairs();
 
 	//Handles narrowphase collision detection
 	void NarrowPhaseCollisions();
 
-	//Sends info to GPU to perform narrowphase collision checks on sphere-sphere collisions
+	//Persistent manifold for the pair of nodes (NULL if they weren't in contact last step)
+	Manifold* FindManifold(PhysicsNode* pnodeA, PhysicsNode* pnodeB);
+	//Gets (or creates) the manifold for the pair, ready to have this step's contacts added
+	Manifold* BeginManifold(PhysicsNode* pnodeA, PhysicsNode* pnodeB);
+	//Releases any manifolds that didn't get any contacts this step (unless they are asleep)
+	void PurgeManifolds();
+	void RemoveNodeManifolds(PhysicsNode* pnode);
+
+	//State kept between steps by the narrowphase test of each pair (e.g. GJK's last axis)
+	NarrowphaseCache* GetNarrowphaseCache(PhysicsNode* pnodeA, PhysicsNode* pnodeB);
+	//Releases the state of any pairs that weren't tested this step
+	void PurgeNarrowphaseCache();
+
+	//Collides all dynamic spheres with the accelerated backend, and pairs everything
+	// else up for the narrowphase
 	void GPUCollisionCheck();
-	void InitCPUMemory();
-	void FreeCPUMemory();
+	//Pair of a static object or non-sphere with any other node, for the narrowphase
+	void AddAccelColPair(PhysicsNode* pnodeA, PhysicsNode* pnodeB);
+	//Adds one sphere-sphere contact straight to the pair's manifold
+	void AddSphereContact(PhysicsNode* pnodeA, PhysicsNode* pnodeB,
+		const Vector3& globalOnA, const Vector3& globalOnB, const Vector3& normal, float penetration);
+	void CUDASphereContacts();
+	void FreeCUDAMemory();
 
 protected:
 	bool		isPaused;
@@ -180,22 +458,90 @@ protected:
 	float		dampingFactor;
 
 	std::vector<CollisionPair>  broadphaseColPairs;
-	Octree*						root;
-	bool						useOctree;
+	BroadphaseOctree			octree;
+	BroadphaseSAP				sweepAndPrune;
+	BroadphaseAABBTree			aabbTree;
+	BroadphaseSpatialHash		spatialHash;
+	BroadphaseMode				broadphaseMode;
 	bool						sphereSphere;
 	int							numSphereChecks;
 
-	bool		gpuAccel;
-	Vector3* positions;
-	float* radii;
+	bool						gpuAccel;
+	SphereAccelBackend			sphereAccelBackend;
+	SphereCollisionCPU			sphereCPU;
+	std::vector<PhysicsNode*>	accelSpheres;		// Dynamic spheres, in the order given to the backend
+	std::vector<PhysicsNode*>	accelOthers;		// Everything else with a collision shape
 
-	Vector3* velocityIn;
-	Vector3* velocityOut;
+	int							cudaCapacity;		// Number of spheres the GPU buffers were allocated for
+	std::vector<Vector3>		cudaPositions, cudaGlobalOnA, cudaGlobalOnB, cudaNormals;
+	std::vector<float>			cudaRadii, cudaPenetrations;
+	std::vector<int>			cudaIndexA, cudaIndexB;
 
 	std::vector<PhysicsNode*>	physicsNodes;
+	PhysicsBodyStorage			bodies;				// Integrated state of each node, in the same order
+	std::vector<PhysicsNode*>	movedNodes;			// Nodes found by the last SyncTransforms
 
 	std::vector<Constraint*>	constraints;		// Misc constraints applying to one or more physics objects e.g our DistanceConstraint
-	std::vector<Manifold*>		manifolds;			// Contact constraints between pairs of objects
+	std::vector<Manifold*>		manifolds;			// Contact constraints between pairs of objects (active this step)
+
+	ObjectPool<Manifold>		manifoldPool;		// Manifolds are recycled, keeping their contact point storage
+	std::unordered_map<PhysicsNodePair, Manifold*, PhysicsNodePairHash,
+		std::equal_to<PhysicsNodePair>, PoolAllocator<std::pair<const PhysicsNodePair, Manifold*>>>
+								manifoldCache;		// All manifolds in use, persisting between steps
+	CollisionDispatch			colDetect;			// Per shape pair tests, with SAT kept between steps to reuse its scratch memory
+	NarrowphaseMode				narrowphaseMode;
+	std::unordered_map<PhysicsNodePair, NarrowphaseCache, PhysicsNodePairHash,
+		std::equal_to<PhysicsNodePair>, PoolAllocator<std::pair<const PhysicsNodePair, NarrowphaseCache>>>
+								narrowphaseCache;	// Per pair state of the narrowphase test, for pairs tested last step
+	size_t						stepAllocations;
+
+	bool						deterministic;
+	uint						deterministicSeed;
+	std::mt19937				shuffleGenerator;
+	uint64_t					stepChecksum;
+	uint						stepCount;
+	int							solverIterations;
+	bool						warmStarting;
+
+	bool						sleepingEnabled;
+	std::vector<int>			islandParent;		// Union-find forest over physicsNodes indices
+	std::vector<uint>			islandSleepCounter;	// Lowest sleep counter of each island (at its root)
+	std::vector<bool>			islandAwake;		// Whether each island (at its root) has an awake node in it
+	std::vector<Constraint*>	activeConstraints;	// Constraints with at least one awake node this step
+	size_t						numAwakeNodes;
+	size_t						numIslands;
+
+	bool						parallelSolver;
+	std::vector<SolverIsland>	solverIslands;		// Slot 0 holds anything not tied to one island, solved serially
+	std::vector<int>			islandSlot;			// Solver island slot of each island root (-1 if unused)
+	size_t						numSolverIslands;
+	std::vector<Manifold*>		solverManifolds;	// This step's manifolds, grouped by solver island
+	std::vector<Constraint*>	solverConstraints;	// This step's active constraints, grouped by solver island
+	std::vector<int>			solverEntrySlots;	// Solver island slot of each manifold, then each constraint
+
+	bool						batchedSolver;
+	std::vector<SolverBatch>	solverBatches;		// The last one holds anything that ran out of colors
+	std::vector<uint>			batchColours;		// Colors used by each node's manifolds/constraints so far
+	size_t						numSolverBatches;
+	std::vector<Manifold*>		batchManifolds;		// The batched island's manifolds, grouped by color
+	std::vector<Constraint*>	batchConstraints;	// The batched island's constraints, grouped by color
+	std::vector<int>			batchEntryColours;	// Color of each of the island's manifolds, then each constraint
+
+	bool						simdSolver;
+	std::vector<ContactSolverSIMD> simdSolvers;	// One per OpenMP thread
+
+	std::thread					physicsThread;
+	std::thread::id				physicsThreadId;
+	std::atomic<bool>			physicsThreadRunning;
+	std::mutex					physicsMutex;		// Held by the physics thread during each step
+	std::mutex					transformMutex;		// Only guards swapping the frame indices below
+	TransformFrame				transformFrames[3];	// Triple buffered, so neither side waits on the other
+	int							writeFrame, readyFrame, renderFrame;
+	bool						newFrameReady;
+	GameTimer					engineTimer;
+	size_t						numDroppedSteps;
+
+	PhysicsStepStats			lastStepStats;
 
 	PerfTimer perfUpdate;
 	PerfTimer perfBroadphase;
@@ -1,67 +1,119 @@
 #include "PhysicsNode.h"
 #include "PhysicsEngine.h"
+#ifndef NCLTECH_HEADLESS
+#include "GameObject.h"
+#endif
+#include "PhysicsBodyStorage.h"
 
 
-void PhysicsNode::IntegrateForVelocity(float dt)
+void PhysicsNode::BindBody(PhysicsBodyStorage* bodies, size_t idx)
 {
-	if (invMass > 0.0f)
+	if (bodies)
 	{
-		linVelocity += PhysicsEngine::Instance()->GetGravity() * dt;
+		pPosition		= &bodies->positions[idx];
+		pLinVelocity	= &bodies->linVelocities[idx];
+		pForce			= &bodies->forces[idx];
+		pInvMass		= &bodies->invMasses[idx];
+		pOrientation	= &bodies->orientations[idx];
+		pAngVelocity	= &bodies->angVelocities[idx];
+		pTorque			= &bodies->torques[idx];
+		pInvInertia		= &bodies->invInertias[idx];
+		pAwake			= &bodies->awake[idx];
+		pTransformDirty	= &bodies->transformDirty[idx];
 	}
-	//Semi-Implicit Euler Method
-	/*
-	linVelocity += force * invMass * dt;
-	angVelocity += invInertia * torque * dt;
-	*/
+	else
+	{
+		pPosition		= &position;
+		pLinVelocity	= &linVelocity;
+		pForce			= &force;
+		pInvMass		= &invMass;
+		pOrientation	= &orientation;
+		pAngVelocity	= &angVelocity;
+		pTorque			= &torque;
+		pInvInertia		= &invInertia;
+		pAwake			= &awake;
+		pTransformDirty	= NULL;
+	}
+}
 
-	//RK2 method
-	Vector3 linVelocity_p1 = linVelocity + force * invMass * dt;
-	linVelocity = (linVelocity + linVelocity_p1) * 0.5;
-	Vector3 angVelocity_p1 = invInertia * angVelocity + torque * dt;
-	angVelocity = (angVelocity + angVelocity_p1) * 0.5;
+void PhysicsNode::UnbindBody()
+{
+	//Taken before the slot it was bound to is removed, so the node carries on where it left off
+	bool dirty	= pTransformDirty && *pTransformDirty;
+	position	= *pPosition;
+	linVelocity	= *pLinVelocity;
+	force		= *pForce;
+	invMass		= *pInvMass;
+	orientation	= *pOrientation;
+	angVelocity	= *pAngVelocity;
+	torque		= *pTorque;
+	invInertia	= *pInvInertia;
+	awake		= *pAwake;
 
-	linVelocity = linVelocity * PhysicsEngine::Instance()->GetDampingFactor();
-	angVelocity = angVelocity * PhysicsEngine::Instance()->GetDampingFactor();
+	BindBody(NULL, 0);
 
-	//if (linVelocity != Vector3(0, 0, 0))
-	//	PhysicsEngine::Instance()->UpdateNodePosition(this);
+	//Won't be picked up by the engine any more
+	if (dirty)
+		FireOnUpdateCallback();
 }
 
-/* Between these two functions the physics engine will solve for velocity
-   based on collisions/constraints etc. So we need to integrate velocity, solve 
-   constraints, then use final velocity to update position. 
-*/
-
-void PhysicsNode::IntegrateForPosition(float dt)
+void PhysicsNode::FireOnUpdateCallback()
 {
-	position += linVelocity * dt;
-	orientation = orientation + Quaternion(angVelocity * dt * 0.5f, 0.0f) * orientation;
-	orientation.Normalise();
+	UpdateWorldTransform();
 
-	distMoved += linVelocity * dt;
-	//Finally: Notify any listener's that this PhysicsNode has a new world transform.
-	// - This is used by GameObject to set the worldTransform of any RenderNode's. 
-	//   Please don't delete this!!!!!
-	FireOnUpdateCallback();
+	//Fire the OnUpdateCallback, notifying GameObject's and other potential
+	// listeners that this PhysicsNode has a new world transform.
+	// - The physics thread leaves this to PhysicsEngine::SyncRenderTransforms, as the
+	//   listeners (RenderNodes) belong to the render thread
+	if (onUpdateCallback && !PhysicsEngine::Instance()->OnPhysicsThread())
+		onUpdateCallback(worldTransform);
 }
 
-void PhysicsNode::FireOnUpdateCallback()
+void PhysicsNode::UpdateWorldTransform()
 {
 	//Build world transform
-	worldTransform = orientation.ToMatrix4();
-	worldTransform.SetPositionVector(position);
+	worldTransform = pOrientation->ToMatrix4();
+	worldTransform.SetPositionVector(*pPosition);
 
-	//Fire the OnUpdateCallback, notifying GameObject's and other potential
-	// listeners that this PhysicsNode has a new world transform.
-	if (onUpdateCallback) onUpdateCallback(worldTransform);
+	//Shapes keep their world space geometry up to date here, once per move,
+	// rather than rebuilding it for every pair they are tested in
+	if (collisionShape)
+		collisionShape->UpdateWorldSpaceCache();
+}
 
-	float deltaLength = 0.01f;
-	if (octree)
-		deltaLength = 0.01 * octree->dimensions.Length() / boundingRadius;
+void PhysicsNode::SetAwake(bool state)
+{
+	*pAwake = state ? 1 : 0;
+	sleepCounter = 0;
 
-	if (distMoved.Length() > deltaLength)
+	//Sleeping objects don't carry on drifting when they are woken up
+	if (!state)
 	{
-		PhysicsEngine::Instance()->UpdateNodePosition(this);
-		distMoved.ToZero();
+		pLinVelocity->ToZero();
+		pAngVelocity->ToZero();
 	}
+
+	//Let the render side follow the physics state
+	if (!PhysicsEngine::Instance()->OnPhysicsThread())
+		SetRenderAwake(state);
+}
+
+void PhysicsNode::SetRenderAwake(bool state)
+{
+#ifndef NCLTECH_HEADLESS
+	if (parent && parent->HasRender())
+	{
+		if (state) parent->Render()->Wake();
+		else parent->Render()->Sleep();
+	}
+#endif
+}
+
+void PhysicsNode::UpdateSleepCounter(float linearThreshold, float angularThreshold)
+{
+	if (Vector3::Dot(*pLinVelocity, *pLinVelocity) < linearThreshold * linearThreshold
+		&& Vector3::Dot(*pAngVelocity, *pAngVelocity) < angularThreshold * angularThreshold)
+		++sleepCounter;
+	else
+		sleepCounter = 0;
 }
\ No newline at end of file
@@ -26,16 +26,27 @@ Description:
 		Vector3		torque;
 		Matrix3     invInertia;
 
+	Once the node is added to the PhysicsEngine these (and whether it is awake)
+	are actually kept in the engine's PhysicsBodyStorage, with the node just
+	pointing at its slot, so the getters/setters below work the same either way.
+
+	Moving a node in the engine (by setting its position/orientation, or by it
+	being integrated) only flags its transform as out of date. Its world transform
+	and shape are then updated, and any listeners told, once by
+	PhysicsEngine::SyncTransforms however many times it was moved.
+
 
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include <nclgl\Quaternion.h>
-#include <nclgl\Matrix3.h>
+#include <nclgl/Quaternion.h>
+#include <nclgl/Matrix3.h>
 #include "CollisionShape.h"
 #include <functional>
+#include <cstdint>
 
 class PhysicsNode;
+class PhysicsBodyStorage;
 
 //Callback function called whenever a collision is detected between two objects
 //Params:
@@ -53,7 +64,6 @@ typedef std::function<bool(PhysicsNode* this_obj, PhysicsNode* colliding_obj)> P
 //	const Matrix4& transform - New World transform of the physics node
 typedef std::function<void(const Matrix4& transform)> PhysicsUpdateCallback;
 
-struct Octree;
 class GameObject;
 class PhysicsNode
 {
@@ -69,12 +79,16 @@ public:
 		, invInertia(Matrix3::ZeroMatrix)
 		, collisionShape(NULL)
 		, parent(NULL)
-		, octree(NULL)
-		, distMoved(0.0f, 0.0f, 0.0f)
+		, broadphaseProxy(-1)
+		, sapProxy(-1)
+		, islandIndex(-1)
+		, awake(true)
+		, sleepCounter(0)
 		, friction(0.5f)
 		, elasticity(0.9f)
 		, boundingRadius(100.0f)
 	{
+		BindBody(NULL, 0);
 	}
 
 	virtual ~PhysicsNode()
@@ -83,11 +97,18 @@ public:
 	}
 
 
-	//<-------- Integration --------->
-	// Called automatically by PhysicsEngine on all physics nodes each frame
-	void IntegrateForVelocity(float dt);
-	//<-- Between calling these two functions the physics engine will solve velocity to get 'true' final velocity -->
-	void IntegrateForPosition(float dt);
+	//Nodes point at their own state (or their slot in the engine's), so can't be copied
+	PhysicsNode(const PhysicsNode&) = delete;
+	PhysicsNode& operator=(const PhysicsNode&) = delete;
+
+
+	//<-------- Body Storage --------->
+	// Called by PhysicsEngine as the node is added (or moved within the arrays), so the
+	// state below is read/written in the engine's arrays rather than the node itself
+	//  - NULL points it back at its own members, without copying anything over
+	void BindBody(PhysicsBodyStorage* bodies, size_t idx);
+	// Copies the state back in to the node and points it at its own members again
+	void UnbindBody();
 
 
 	//<--------- GETTERS ------------->
@@ -96,22 +117,31 @@ public:
 	inline float				GetElasticity()				const { return elasticity; }
 	inline float				GetFriction()				const { return friction; }
 
-	inline const Vector3&		GetPosition()				const { return position; }
-	inline const Vector3&		GetLinearVelocity()			const { return linVelocity; }
-	inline const Vector3&		GetForce()					const { return force; }
-	inline float				GetInverseMass()			const { return invMass; }
+	inline const Vector3&		GetPosition()				const { return *pPosition; }
+	inline const Vector3&		GetLinearVelocity()			const { return *pLinVelocity; }
+	inline const Vector3&		GetForce()					const { return *pForce; }
+	inline float				GetInverseMass()			const { return *pInvMass; }
 
-	inline const Quaternion&	GetOrientation()			const { return orientation; }
-	inline const Vector3&		GetAngularVelocity()		const { return angVelocity; }
-	inline const Vector3&		GetTorque()					const { return torque; }
-	inline const Matrix3&		GetInverseInertia()			const { return invInertia; }
+	inline const Quaternion&	GetOrientation()			const { return *pOrientation; }
+	inline const Vector3&		GetAngularVelocity()		const { return *pAngVelocity; }
+	inline const Vector3&		GetTorque()					const { return *pTorque; }
+	inline const Matrix3&		GetInverseInertia()			const { return *pInvInertia; }
 
 	inline CollisionShape*		GetCollisionShape()			const { return collisionShape; }
 	inline float				GetBoundingRadius()			const { return boundingRadius; }
 
 	const Matrix4&				GetWorldSpaceTransform()    const { return worldTransform; }
 
-	inline Octree*				GetOctree()					const { return octree; }
+	//Id of this node's leaf in the broadphase AABB tree (-1 if not in the tree)
+	inline int					GetBroadphaseProxy()		const { return broadphaseProxy; }
+	//Index of this node's proxy in the sweep and prune broadphase (-1 if it has none)
+	inline int					GetSAPProxy()				const { return sapProxy; }
+
+	//Sleeping nodes are skipped by the physics engine until something wakes them up
+	inline bool					IsAwake()					const { return *pAwake != 0; }
+	inline bool					IsStatic()					const { return *pInvMass == 0.0f; }
+	inline uint					GetSleepCounter()			const { return sleepCounter; }
+	inline int					GetIslandIndex()			const { return islandIndex; }
 
 
 	//<--------- SETTERS ------------->
@@ -120,17 +150,26 @@ public:
 	inline void SetElasticity(float elasticityCoeff)				{ elasticity = elasticityCoeff; }
 	inline void SetFriction(float frictionCoeff)					{ friction = frictionCoeff; }
 
-	inline void SetPosition(const Vector3& v)						{ position = v; FireOnUpdateCallback(); }
-	inline void SetLinearVelocity(const Vector3& v)					{ linVelocity = v; }
-	inline void SetForce(const Vector3& v)							{ force = v; }
-	inline void SetInverseMass(const float& v)						{ invMass = v; }
+	inline void SetPosition(const Vector3& v)						{ *pPosition = v; Wake(); MarkTransformDirty(); }
+	inline void SetLinearVelocity(const Vector3& v)					{ *pLinVelocity = v; Wake(); }
+	inline void SetForce(const Vector3& v)							{ *pForce = v; Wake(); }
+	inline void SetInverseMass(const float& v)						{ *pInvMass = v; }
+
+	inline void SetOrientation(const Quaternion& v)					{ *pOrientation = v; Wake(); MarkTransformDirty(); }
+	inline void SetAngularVelocity(const Vector3& v)				{ *pAngVelocity = v; Wake(); }
+	inline void SetTorque(const Vector3& v)							{ *pTorque = v; Wake(); }
+	inline void SetInverseInertia(const Matrix3& v)					{ *pInvInertia = v; }
 
-	inline void SetOrientation(const Quaternion& v)					{ orientation = v; FireOnUpdateCallback(); }
-	inline void SetAngularVelocity(const Vector3& v)				{ angVelocity = v; }
-	inline void SetTorque(const Vector3& v)							{ torque = v; }
-	inline void SetInverseInertia(const Matrix3& v)					{ invInertia = v; }
+	inline void SetBroadphaseProxy(int id)							{ broadphaseProxy = id; }
+	inline void SetSAPProxy(int id)									{ sapProxy = id; }
+	inline void SetIslandIndex(int idx)								{ islandIndex = idx; }
 
-	inline void SetOctree(Octree* o)								{ octree = o; }
+	inline void Wake()												{ if (!*pAwake) SetAwake(true); }
+	inline void Sleep()												{ if (*pAwake) SetAwake(false); }
+	void SetAwake(bool state);
+
+	//Counts the number of steps in a row the node has been moving slower than the given speeds
+	void UpdateSleepCounter(float linearThreshold, float angularThreshold);
 
 	inline void SetCollisionShape(CollisionShape* colShape)
 	{ 
@@ -150,7 +189,19 @@ public:
 	}
 
 	inline void SetOnUpdateCallback(PhysicsUpdateCallback callback) { onUpdateCallback = callback; }
+	//Updates the world transform and passes it on straight away
 	void FireOnUpdateCallback();
+	//Passes on a transform other than the node's own, e.g. one interpolated between two steps
+	inline void FireOnUpdateCallback(const Matrix4& transform)		{ if (onUpdateCallback) onUpdateCallback(transform); }
+
+	//Nodes in the engine just have their transform flagged for the next PhysicsEngine::SyncTransforms,
+	// anything else (e.g. before it has been added) is updated straight away
+	inline void MarkTransformDirty()								{ if (pTransformDirty) *pTransformDirty = 1; else FireOnUpdateCallback(); }
+	//Rebuilds the world transform and the shape's world space cache, without telling any listeners
+	void UpdateWorldTransform();
+
+	//Wakes/sleeps the render node to match, done by PhysicsEngine when it's running on its own thread
+	void SetRenderAwake(bool state);
 	
 
 protected:
@@ -159,9 +210,12 @@ protected:
 	Matrix4					worldTransform;
 	PhysicsUpdateCallback	onUpdateCallback;
 
-	Octree*					octree;
-	bool					octreeEnabled;
-	Vector3					distMoved;
+	int						broadphaseProxy;
+	int						sapProxy;
+	int						islandIndex;		//Index in the engine's node list, used to build islands
+
+	uint8_t					awake;
+	uint					sleepCounter;
 
 
 //Added in Tutorial 2
@@ -177,6 +231,19 @@ protected:
 	Vector3		torque;
 	Matrix3     invInertia;
 
+	//Where the state above is actually read/written, either those members or the
+	// node's slot in the engine's PhysicsBodyStorage
+	Vector3*	pPosition;
+	Vector3*	pLinVelocity;
+	Vector3*	pForce;
+	float*		pInvMass;
+	Quaternion*	pOrientation;
+	Vector3*	pAngVelocity;
+	Vector3*	pTorque;
+	Matrix3*	pInvInertia;
+	uint8_t*	pAwake;
+	uint8_t*	pTransformDirty;	//NULL unless the node is in the engine
+
 
 //Added in Tutorial 4/5
 	//<----------COLLISION------------>
@@ -30,8 +30,8 @@ Description:
 
 #include "GameObject.h"
 #include "PhysicsEngine.h"
-#include <nclgl\NCLDebug.h>
-#include <nclgl\TSingleton.h>
+#include <nclgl/NCLDebug.h>
+#include <nclgl/TSingleton.h>
 #include <functional>
 #include <algorithm>
 #include <unordered_map>
@@ -33,10 +33,10 @@ which can be extended (with the new physics collision shapes) to provide an accu
 *//////////////////////////////////////////////////////////////////////////////
 
 #pragma once
-#include <nclgl\TSingleton.h>
-#include <nclgl\RenderNode.h>
-#include <nclgl\Shader.h>
-#include <GL\glew.h>
+#include <nclgl/TSingleton.h>
+#include <nclgl/RenderNode.h>
+#include <nclgl/Shader.h>
+#include <GL/glew.h>
 
 //Our texture only stores 16bit unsigned shorts, so has a hard limit on the number of values it can store. 
 //  Hopefully you will never be able to trigger this value though. 
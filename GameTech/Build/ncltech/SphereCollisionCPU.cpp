@@ -0,0 +1,244 @@
+#include "SphereCollisionCPU.h"
+#include <omp.h>
+#include <cmath>
+#include <cstring>
+
+//Smallest number of buckets in the hash table (must be a power of two)
+#define SPHERECPU_MIN_TABLE_SIZE	1024
+
+SphereCollisionCPU::SphereCollisionCPU()
+	: invCellSize(1.0f)
+	, tableSize(0)
+	, numThreads(max(omp_get_max_threads(), 1))
+	, numTests(0)
+{
+	threadContacts.resize(numThreads);
+	threadDistSq.resize(numThreads);
+}
+
+SphereCollisionCPU::~SphereCollisionCPU()
+{
+	Clear();
+}
+
+void SphereCollisionCPU::Clear()
+{
+	posX.clear();
+	posY.clear();
+	posZ.clear();
+	radius.clear();
+}
+
+void SphereCollisionCPU::GetCell(float x, float y, float z, int* cell) const
+{
+	cell[0] = (int)floor(x * invCellSize);
+	cell[1] = (int)floor(y * invCellSize);
+	cell[2] = (int)floor(z * invCellSize);
+}
+
+uint SphereCollisionCPU::GetCellHash(int x, int y, int z) const
+{
+	uint h = ((uint)x * 73856093u) ^ ((uint)y * 19349663u) ^ ((uint)z * 83492791u);
+	return h & (tableSize - 1);
+}
+
+void SphereCollisionCPU::SortSpheres()
+{
+	const int numSpheres = (int)radius.size();
+
+	//Every sphere has to fit inside a single cell
+	float maxRadius = 0.0f;
+	for (int i = 0; i < numSpheres; ++i)
+		maxRadius = max(maxRadius, radius[i]);
+	invCellSize = 1.0f / max(maxRadius * 2.0f, 1e-3f);
+
+	//Keep the buckets sparse enough that distant cells rarely share one
+	uint wantedSize = SPHERECPU_MIN_TABLE_SIZE;
+	while (wantedSize < (uint)numSpheres * 2)
+		wantedSize <<= 1;
+	if (wantedSize != tableSize)
+	{
+		tableSize = wantedSize;
+		threadCounts.resize(numThreads * tableSize);
+		cellStart.resize(tableSize + 1);
+	}
+
+	cellHashes.resize(numSpheres);
+	sortedX.resize(numSpheres);
+	sortedY.resize(numSpheres);
+	sortedZ.resize(numSpheres);
+	sortedRadius.resize(numSpheres);
+	sortedIndex.resize(numSpheres);
+
+	//1. Hash and count each thread's contiguous chunk of the spheres
+#pragma omp parallel for schedule(static)
+	for (int t = 0; t < numThreads; ++t)
+	{
+		uint* counts = &threadCounts[t * tableSize];
+		memset(counts, 0, tableSize * sizeof(uint));
+
+		int start = numSpheres * t / numThreads;
+		int end = numSpheres * (t + 1) / numThreads;
+		for (int i = start; i < end; ++i)
+		{
+			int cell[3];
+			GetCell(posX[i], posY[i], posZ[i], cell);
+			uint hash = GetCellHash(cell[0], cell[1], cell[2]);
+			cellHashes[i] = hash;
+			++counts[hash];
+		}
+	}
+
+	//2. Prefix sum the counts in (cell, thread) order
+	uint sum = 0;
+	for (uint h = 0; h < tableSize; ++h)
+	{
+		cellStart[h] = sum;
+		for (int t = 0; t < numThreads; ++t)
+		{
+			uint& count = threadCounts[t * tableSize + h];
+			uint tmp = count;
+			count = sum;
+			sum += tmp;
+		}
+	}
+	cellStart[tableSize] = sum;
+
+	//3. Scatter the spheres into their sorted positions
+#pragma omp parallel for schedule(static)
+	for (int t = 0; t < numThreads; ++t)
+	{
+		uint* offsets = &threadCounts[t * tableSize];
+
+		int start = numSpheres * t / numThreads;
+		int end = numSpheres * (t + 1) / numThreads;
+		for (int i = start; i < end; ++i)
+		{
+			uint dst = offsets[cellHashes[i]]++;
+			sortedX[dst] = posX[i];
+			sortedY[dst] = posY[i];
+			sortedZ[dst] = posZ[i];
+			sortedRadius[dst] = radius[i];
+			sortedIndex[dst] = i;
+		}
+	}
+}
+
+size_t SphereCollisionCPU::FindGridContacts(uint start, uint end, std::vector<SphereContact>& out_contacts, std::vector<float>& distSq)
+{
+	size_t tests = 0;
+
+	for (uint i = start; i < end; ++i)
+	{
+		const float ax = sortedX[i], ay = sortedY[i], az = sortedZ[i], ar = sortedRadius[i];
+
+		int cell[3];
+		GetCell(ax, ay, az, cell);
+
+		//Neighbouring cells can hash to the same bucket, so each bucket is only checked once
+		uint checked[27];
+		uint numChecked = 0;
+
+		for (int z = -1; z <= 1; ++z)
+		{
+			for (int x = -1; x <= 1; ++x)
+			{
+				for (int y = -1; y <= 1; ++y)
+				{
+					uint hash = GetCellHash(cell[0] + x, cell[1] + y, cell[2] + z);
+
+					bool duplicate = false;
+					for (uint k = 0; k < numChecked && !duplicate; ++k)
+						duplicate = (checked[k] == hash);
+					if (duplicate)
+						continue;
+					checked[numChecked++] = hash;
+
+					//Only test against spheres after this one, so each pair is found once
+					uint first = max(cellStart[hash], i + 1);
+					uint last = cellStart[hash + 1];
+					if (first >= last)
+						continue;
+
+					//Squared overlap of every sphere in the bucket, as one branch free loop
+					const int count = (int)(last - first);
+					if (distSq.size() < (size_t)count)
+						distSq.resize(count);
+
+					const float* bx = &sortedX[first];
+					const float* by = &sortedY[first];
+					const float* bz = &sortedZ[first];
+					const float* br = &sortedRadius[first];
+					float* out = &distSq[0];
+					for (int j = 0; j < count; ++j)
+					{
+						float dx = bx[j] - ax, dy = by[j] - ay, dz = bz[j] - az;
+						float r = ar + br[j];
+						out[j] = (dx * dx + dy * dy + dz * dz) - r * r;
+					}
+					tests += count;
+
+					for (int j = 0; j < count; ++j)
+					{
+						if (out[j] >= 0.0f)
+							continue;
+
+						uint b = first + j;
+						Vector3 ab(sortedX[b] - ax, sortedY[b] - ay, sortedZ[b] - az);
+						float length = ab.Length();
+						Vector3 normal = length > 1e-6f ? ab / length : Vector3(0.0f, 1.0f, 0.0f);
+
+						//Keep the lower index as A, so the output doesn't depend on the grid order
+						SphereContact c;
+						if (sortedIndex[i] < sortedIndex[b])
+						{
+							c.indexA = sortedIndex[i];
+							c.indexB = sortedIndex[b];
+							c.globalOnA = Vector3(ax, ay, az) + normal * ar;
+							c.globalOnB = Vector3(sortedX[b], sortedY[b], sortedZ[b]) - normal * sortedRadius[b];
+							c.normal = normal;
+						}
+						else
+						{
+							c.indexA = sortedIndex[b];
+							c.indexB = sortedIndex[i];
+							c.globalOnA = Vector3(sortedX[b], sortedY[b], sortedZ[b]) - normal * sortedRadius[b];
+							c.globalOnB = Vector3(ax, ay, az) + normal * ar;
+							c.normal = -normal;
+						}
+						c.penetration = length - (ar + sortedRadius[b]);
+						out_contacts.push_back(c);
+					}
+				}
+			}
+		}
+	}
+
+	return tests;
+}
+
+void SphereCollisionCPU::FindContacts()
+{
+	contacts.clear();
+	numTests = 0;
+
+	if (radius.size() < 2)
+		return;
+
+	SortSpheres();
+
+	const int numSpheres = (int)radius.size();
+	size_t tests = 0;
+#pragma omp parallel for schedule(static) reduction(+:tests)
+	for (int t = 0; t < numThreads; ++t)
+	{
+		threadContacts[t].clear();
+		tests += FindGridContacts(numSpheres * t / numThreads, numSpheres * (t + 1) / numThreads,
+			threadContacts[t], threadDistSq[t]);
+	}
+	numTests = tests;
+
+	//Compact the per-thread lists into one
+	for (std::vector<SphereContact>& threadList : threadContacts)
+		contacts.insert(contacts.end(), threadList.begin(), threadList.end());
+}
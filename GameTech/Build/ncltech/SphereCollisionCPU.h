@@ -0,0 +1,98 @@
+/******************************************************************************
+Class: SphereCollisionCPU
+Implements:
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	CPU backend for the accelerated sphere-sphere collision path, doing the same
+	job as CUDA_SphereSphereCheck.cu on machines without a CUDA device.
+
+	The spheres are stored as structure of arrays and sorted into a uniform grid
+	with the same counting sort as BroadphaseSpatialHash. The cell size is the
+	largest sphere diameter, so every overlap is between neighbouring cells.
+	Each thread then tests its own share of the sorted spheres against the
+	contiguous runs of spheres in the 27 cells around them. The distance checks
+	for a run are done up front in a tight loop the compiler can vectorize.
+
+	Unlike the CUDA version, which writes a result for all n^2/2 pairs, only the
+	pairs actually touching are written out. Each thread appends to its own list,
+	and these are joined in thread order, so the contacts always come out in the
+	same order for the same input.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <nclgl/common.h>
+#include <nclgl/Vector3.h>
+#include <vector>
+
+//One contact between two overlapping spheres, matching the outputs of CUDA_run
+struct SphereContact
+{
+	int		indexA;			//Index of each sphere, in the order they were added
+	int		indexB;
+	Vector3	globalOnA;		//Deepest point of each sphere inside the other one
+	Vector3	globalOnB;
+	Vector3	normal;			//From A to B
+	float	penetration;	//Negative when overlapping
+};
+
+class SphereCollisionCPU
+{
+public:
+	SphereCollisionCPU();
+	~SphereCollisionCPU();
+
+	void Clear();
+
+	inline void Reserve(size_t numSpheres)
+	{
+		posX.reserve(numSpheres); posY.reserve(numSpheres); posZ.reserve(numSpheres); radius.reserve(numSpheres);
+	}
+
+	inline void AddSphere(const Vector3& pos, float r)
+	{
+		posX.push_back(pos.x); posY.push_back(pos.y); posZ.push_back(pos.z); radius.push_back(r);
+	}
+
+	inline size_t NumSpheres() const	{ return radius.size(); }
+
+	// Finds every pair of overlapping spheres added since the last Clear
+	void FindContacts();
+
+	inline const std::vector<SphereContact>& GetContacts() const	{ return contacts; }
+
+	// Number of sphere pairs whose distance was checked in the last FindContacts
+	inline size_t NumTests() const		{ return numTests; }
+
+protected:
+	void GetCell(float x, float y, float z, int* cell) const;
+	uint GetCellHash(int x, int y, int z) const;
+
+	// Sorts the spheres into the grid, filling the sorted arrays
+	void SortSpheres();
+
+	// Finds all contacts for the sorted spheres in [start, end) and appends them to out_contacts
+	size_t FindGridContacts(uint start, uint end, std::vector<SphereContact>& out_contacts, std::vector<float>& distSq);
+
+protected:
+	float	invCellSize;
+	uint	tableSize;		//Power of two, grown to at least twice the number of spheres
+	int		numThreads;
+
+	std::vector<float>	posX, posY, posZ, radius;			//In the order the spheres were added
+	std::vector<uint>	cellHashes;
+
+	std::vector<uint>	threadCounts;	//numThreads * tableSize counting sort histogram
+	std::vector<uint>	cellStart;		//tableSize + 1 entries
+
+	std::vector<float>	sortedX, sortedY, sortedZ, sortedRadius;
+	std::vector<int>	sortedIndex;	//Original index of each sorted sphere
+
+	std::vector<std::vector<SphereContact>>	threadContacts;
+	std::vector<std::vector<float>>			threadDistSq;	//Scratch space for each thread's distance checks
+	std::vector<SphereContact>				contacts;
+	size_t									numTests;
+};
@@ -1,16 +1,18 @@
 #include "SphereCollisionShape.h"
 #include "PhysicsNode.h"
-#include <nclgl\NCLDebug.h>
-#include <nclgl\Matrix3.h>
-#include <nclgl\Vector3.h>
+#include <nclgl/NCLDebug.h>
+#include <nclgl/Matrix3.h>
+#include <nclgl/Vector3.h>
 
 
 SphereCollisionShape::SphereCollisionShape()
+	: CollisionShape(COLLISIONSHAPE_SPHERE)
 {
 	m_Radius = 1.0f;
 }
 
 SphereCollisionShape::SphereCollisionShape(float radius)
+	: CollisionShape(COLLISIONSHAPE_SPHERE)
 {
 	m_Radius = radius;
 }
@@ -63,14 +65,23 @@ void SphereCollisionShape::GetMinMaxVertexOnAxis(
 	out_min = Parent()->GetPosition() - axis * m_Radius;
 	out_max = Parent()->GetPosition() + axis * m_Radius;
 }
+
+Vector3 SphereCollisionShape::GetSupportPoint(const Vector3& axis) const
+{
+	float length = axis.Length();
+	if (length < 1e-6f)
+		return Parent()->GetPosition();
+
+	return Parent()->GetPosition() + axis * (m_Radius / length);
+}
 //-------------
 
 
 void SphereCollisionShape::GetIncidentReferencePolygon(
 	const Vector3& axis,
-	std::list<Vector3>& out_face,
+	OutputSpan<Vector3>& out_face,
 	Vector3& out_normal,
-	std::vector<Plane>& out_adjacent_planes) const
+	OutputSpan<Plane>& out_adjacent_planes) const
 {
 	//This is used in Tutorial 5
 	out_face.push_back(Parent()->GetPosition() + axis * m_Radius);
@@ -52,12 +52,14 @@ public:
 		const Vector3& axis,
 		Vector3& out_min,
 		Vector3& out_max) const override;
+
+	virtual Vector3 GetSupportPoint(const Vector3& axis) const override;
 	
 	virtual void GetIncidentReferencePolygon(
 		const Vector3& axis,
-		std::list<Vector3>& out_face,
+		OutputSpan<Vector3>& out_face,
 		Vector3& out_normal,
-		std::vector<Plane>& out_adjacent_planes) const override;
+		OutputSpan<Plane>& out_adjacent_planes) const override;
 
 protected:
 	float	m_Radius;
@@ -108,24 +108,40 @@ void SpringConstraint::ApplyImpulse()
 
 		// Apply linear velocity impulse
 
+		//Targets are damped and kept from spinning (only GameObjects have names, so
+		// nodes without one, e.g. in Benchmark_Physics, never are)
+		bool isTarget = false;
+#ifndef NCLTECH_HEADLESS
+		isTarget = pnodeA->GetParent() && pnodeA->GetParent()->GetName().compare(0, 6, "Target") == 0;
+#endif
+
 		float damping = 1.0f;
-		if (pnodeA->GetParent()->GetName().compare(0, 6, "Target") == 0)
+		if (isTarget)
 			damping = 0.999f;
 
-		pnodeA->SetLinearVelocity((pnodeA->GetLinearVelocity() + force * pnodeA->GetInverseMass()) * damping);
+		// Static objects are skipped as they can be shared with islands
+		// solved on other threads
+		const bool updateA = !pnodeA->IsStatic();
+		const bool updateB = pnodeB && !pnodeB->IsStatic();
+
+		if (updateA)
+			pnodeA->SetLinearVelocity((pnodeA->GetLinearVelocity() + force * pnodeA->GetInverseMass()) * damping);
 
-		if (pnodeB)
+		if (updateB)
 			pnodeB->SetLinearVelocity(pnodeB->GetLinearVelocity() - force * pnodeB->GetInverseMass());
 
 
 		// This function prevents objects from rotating
 		// maybe change to a "can rotate?" bool (??)
-		if (pnodeA->GetParent()->GetName().compare(0, 6, "Target") == 0)
-			pnodeA->SetAngularVelocity(orientationA.ToMatrix3() * 0.1f * pnodeA->GetAngularVelocity());
-		else
-			pnodeA->SetAngularVelocity(pnodeA->GetAngularVelocity() + pnodeA->GetInverseInertia() * Vector3::Cross(r1, abn * jn));
-
-		if (pnodeB)
+		if (updateA)
+		{
+			if (isTarget)
+				pnodeA->SetAngularVelocity(orientationA.ToMatrix3() * 0.1f * pnodeA->GetAngularVelocity());
+			else
+				pnodeA->SetAngularVelocity(pnodeA->GetAngularVelocity() + pnodeA->GetInverseInertia() * Vector3::Cross(r1, abn * jn));
+		}
+
+		if (updateB)
 			pnodeB->SetAngularVelocity(pnodeB->GetAngularVelocity() - pnodeB->GetInverseInertia() * Vector3::Cross(r2, abn * jn));
 	}
 }
\ No newline at end of file
@@ -18,9 +18,11 @@ opposite to the displacement
 #endif
 
 #include "Constraint.h"
+#ifndef NCLTECH_HEADLESS
 #include "GameObject.h"
+#endif
 #include "PhysicsEngine.h"
-#include <nclgl\NCLDebug.h>
+#include <nclgl/NCLDebug.h>
 
 class SpringConstraint : public Constraint
 {
@@ -72,6 +74,9 @@ public:
 	// objects in order to satisfy the constraint.
 	virtual void ApplyImpulse() override;
 
+	virtual PhysicsNode* GetNodeA() const override { return pnodeA; }
+	virtual PhysicsNode* GetNodeB() const override { return pnodeB; }
+
 	//Draw the constraint visually to the screen for debugging
 	virtual void DebugDraw() const
 	{
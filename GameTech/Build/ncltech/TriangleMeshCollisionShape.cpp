@@ -0,0 +1,624 @@
+#include "TriangleMeshCollisionShape.h"
+#include "GeometryUtils.h"
+#ifndef NCLTECH_HEADLESS
+#include <nclgl/Mesh.h>
+#endif
+#include <nclgl/Matrix3.h>
+#include <nclgl/NCLDebug.h>
+#include <fstream>
+#include <algorithm>
+#include <cfloat>
+#include <cassert>
+
+//Number of buckets the triangles' centres are sorted in to when looking for the best split
+#define TRIANGLEMESH_SAH_BINS			12
+
+//Depth past which nodes are split in half instead of by SAH, so the hierarchy can
+// never be more than this plus log2(triangles) deep however the triangles lie
+#define TRIANGLEMESH_BVH_SAH_MAX_DEPTH	32
+
+//Entries in the traversal stack, which needs one more than the depth of the
+// hierarchy: enough for any mesh of less than 2^31 triangles (see above)
+#define TRIANGLEMESH_BVH_STACK_SIZE		64
+
+namespace
+{
+	float SurfaceArea(const BoundingBox& box)
+	{
+		Vector3 size = box._max - box._min;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	void ExpandToFit(BoundingBox& box, const BoundingBox& other)
+	{
+		box.ExpandToFit(other._min);
+		box.ExpandToFit(other._max);
+	}
+
+	inline float Component(const Vector3& v, int axis)
+	{
+		return (axis == 0) ? v.x : (axis == 1) ? v.y : v.z;
+	}
+}
+
+
+//<---------- TriangleCollisionShape ---------->
+
+TriangleCollisionShape::TriangleCollisionShape()
+	: CollisionShape(COLLISIONSHAPE_CONVEX)
+{
+	SetVertices(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 0.0f, -1.0f));
+}
+
+void TriangleCollisionShape::SetVertices(const Vector3& a, const Vector3& b, const Vector3& c)
+{
+	vertices[0] = a;
+	vertices[1] = b;
+	vertices[2] = c;
+
+	normal = Vector3::Cross(b - a, c - a);
+	normal.Normalise();
+
+	for (int i = 0; i < 3; ++i)
+	{
+		edgeNormals[i] = Vector3::Cross(vertices[(i + 1) % 3] - vertices[i], normal);
+		edgeNormals[i].Normalise();
+	}
+}
+
+Matrix3 TriangleCollisionShape::BuildInverseInertia(float invMass) const
+{
+	return Matrix3::ZeroMatrix;
+}
+
+void TriangleCollisionShape::GetCollisionAxes(
+	const PhysicsNode* otherObject,
+	std::vector<Vector3>& out_axes) const
+{
+	//The rest come from crossing the edges with the other shape's
+	out_axes.push_back(normal);
+}
+
+bool TriangleCollisionShape::GetEdgeDirections(std::vector<Vector3>& out_edges) const
+{
+	for (int i = 0; i < 3; ++i)
+		out_edges.push_back((vertices[(i + 1) % 3] - vertices[i]).Normalise());
+	return true;
+}
+
+Vector3 TriangleCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	//Inside all three edges, the closest point is straight down on to the triangle
+	Vector3 onPlane = point - normal * Vector3::Dot(point - vertices[0], normal);
+	if (Vector3::Dot(onPlane - vertices[0], edgeNormals[0]) <= 0.0f
+		&& Vector3::Dot(onPlane - vertices[1], edgeNormals[1]) <= 0.0f
+		&& Vector3::Dot(onPlane - vertices[2], edgeNormals[2]) <= 0.0f)
+	{
+		return onPlane;
+	}
+
+	return GeometryUtils::GetClosestPointPolygon(point, vertices, 3);
+}
+
+void TriangleCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	float minCorrelation = FLT_MAX, maxCorrelation = -FLT_MAX;
+	for (int i = 0; i < 3; ++i)
+	{
+		float correlation = Vector3::Dot(axis, vertices[i]);
+		if (correlation < minCorrelation)
+		{
+			minCorrelation = correlation;
+			out_min = vertices[i];
+		}
+		if (correlation > maxCorrelation)
+		{
+			maxCorrelation = correlation;
+			out_max = vertices[i];
+		}
+	}
+}
+
+Vector3 TriangleCollisionShape::GetSupportPoint(const Vector3& axis) const
+{
+	int best = 0;
+	float maxCorrelation = Vector3::Dot(axis, vertices[0]);
+	for (int i = 1; i < 3; ++i)
+	{
+		float correlation = Vector3::Dot(axis, vertices[i]);
+		if (correlation > maxCorrelation)
+		{
+			maxCorrelation = correlation;
+			best = i;
+		}
+	}
+	return vertices[best];
+}
+
+void TriangleCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	OutputSpan<Vector3>& out_face,
+	Vector3& out_normal,
+	OutputSpan<Plane>& out_adjacent_planes) const
+{
+	//Both sides are the same face, facing whichever way is closest to the axis
+	out_normal = (Vector3::Dot(axis, normal) >= 0.0f) ? normal : -normal;
+
+	for (int i = 0; i < 3; ++i)
+		out_face.push_back(vertices[i]);
+
+	//The 'adjacent faces' are the planes standing up along each edge
+	for (int i = 0; i < 3; ++i)
+	{
+		Vector3 planeNrml = -edgeNormals[i];
+		float planeDist = -Vector3::Dot(planeNrml, vertices[i]);
+
+		out_adjacent_planes.push_back(Plane(planeNrml, planeDist));
+	}
+}
+
+void TriangleCollisionShape::DebugDraw() const
+{
+	NCLDebug::DrawTriangleNDT(vertices[0], vertices[1], vertices[2], Vector4(1.0f, 1.0f, 1.0f, 0.2f));
+	for (int i = 0; i < 3; ++i)
+		NCLDebug::DrawThickLineNDT(vertices[i], vertices[(i + 1) % 3], 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
+}
+
+
+//<---------- TriangleMeshCollisionShape ---------->
+
+#ifndef NCLTECH_HEADLESS
+TriangleMeshCollisionShape::TriangleMeshCollisionShape(const Mesh* mesh, const Vector3& scale)
+	: CollisionShape(COLLISIONSHAPE_TRIANGLEMESH)
+{
+	std::vector<Vector3> meshVertices;
+	std::vector<uint> meshIndices;
+	if (mesh && mesh->vertices)
+	{
+		if (mesh->type != GL_TRIANGLES)
+		{
+			NCLERROR("TriangleMeshCollisionShape: Only GL_TRIANGLES meshes are supported");
+		}
+		else
+		{
+			meshVertices.resize(mesh->numVertices);
+			for (GLuint i = 0; i < mesh->numVertices; ++i)
+				meshVertices[i] = mesh->vertices[i] * scale;
+
+			//Unindexed meshes just list each triangle's vertices in turn
+			if (mesh->indices)
+			{
+				meshIndices.assign(mesh->indices, mesh->indices + mesh->numIndices);
+			}
+			else
+			{
+				meshIndices.resize(mesh->numVertices);
+				for (GLuint i = 0; i < mesh->numVertices; ++i)
+					meshIndices[i] = i;
+			}
+		}
+	}
+
+	BuildBVH(meshVertices, meshIndices);
+}
+#endif
+
+TriangleMeshCollisionShape::TriangleMeshCollisionShape(const std::string& filename, const Matrix4& transform)
+	: CollisionShape(COLLISIONSHAPE_TRIANGLEMESH)
+{
+	std::vector<Vector3> fileVertices;
+	std::vector<uint> fileIndices;
+
+	std::ifstream file;
+	file.open(filename.c_str());
+	if (!file.is_open())
+	{
+		NCLERROR("TriangleMeshCollisionShape: Unable to load file - \"%s\"", filename.c_str());
+	}
+	else
+	{
+		//First two values in the file represent the number of vertices, and number of indices
+		uint numVerts = 0, numIndices = 0;
+		file >> numVerts;
+		file >> numIndices;
+
+		fileVertices.resize(numVerts);
+		for (Vector3& vertex : fileVertices)
+		{
+			file >> vertex.x;
+			file >> vertex.y;
+			file >> vertex.z;
+
+			vertex = transform * vertex;
+		}
+
+		fileIndices.resize(numIndices);
+		for (uint& index : fileIndices)
+			file >> index;
+
+		file.close();
+	}
+
+	BuildBVH(fileVertices, fileIndices);
+}
+
+TriangleMeshCollisionShape::TriangleMeshCollisionShape(const Vector3* vertices, uint numVertices, const uint* indices, uint numIndices)
+	: CollisionShape(COLLISIONSHAPE_TRIANGLEMESH)
+{
+	BuildBVH(std::vector<Vector3>(vertices, vertices + numVertices), std::vector<uint>(indices, indices + numIndices));
+}
+
+TriangleMeshCollisionShape::~TriangleMeshCollisionShape()
+{
+
+}
+
+void TriangleMeshCollisionShape::BuildBVH(const std::vector<Vector3>& in_vertices, const std::vector<uint>& in_indices)
+{
+	vertices = in_vertices;
+	triangles.clear();
+	bvhNodes.clear();
+	bvhDepth = 0;
+
+	//Bounds and centre of every triangle, skipping any with no area (or out of range
+	// indices) as they can't be collided with anyway
+	std::vector<int> triIds;
+	std::vector<BoundingBox> triBounds(in_indices.size() / 3);
+	std::vector<Vector3> triCentres(in_indices.size() / 3);
+	for (size_t tri = 0; tri < triBounds.size(); ++tri)
+	{
+		const uint* idx = &in_indices[tri * 3];
+		if (idx[0] >= vertices.size() || idx[1] >= vertices.size() || idx[2] >= vertices.size())
+			continue;
+
+		const Vector3& a = vertices[idx[0]];
+		const Vector3& b = vertices[idx[1]];
+		const Vector3& c = vertices[idx[2]];
+		Vector3 n = Vector3::Cross(b - a, c - a);
+		if (Vector3::Dot(n, n) < 1e-12f)
+			continue;
+
+		triBounds[tri].ExpandToFit(a);
+		triBounds[tri].ExpandToFit(b);
+		triBounds[tri].ExpandToFit(c);
+		triCentres[tri] = (triBounds[tri]._min + triBounds[tri]._max) * 0.5f;
+		triIds.push_back((int)tri);
+	}
+
+	if (!triIds.empty())
+	{
+		bvhNodes.reserve(triIds.size() * 2);
+		bvhNodes.push_back(TriangleMeshBVHNode());
+		BuildBVHNode(0, 0, 0, (int)triIds.size(), triIds, triBounds, triCentres);
+
+		//Store the triangles in the order the leaves reference them
+		triangles.reserve(triIds.size() * 3);
+		for (int id : triIds)
+		{
+			triangles.push_back(in_indices[id * 3]);
+			triangles.push_back(in_indices[id * 3 + 1]);
+			triangles.push_back(in_indices[id * 3 + 2]);
+		}
+	}
+
+	vertices.shrink_to_fit();
+	bvhNodes.shrink_to_fit();
+	assert(bvhDepth < TRIANGLEMESH_BVH_STACK_SIZE);
+
+	NCLLOG("TriangleMeshCollisionShape: %d triangles, %d nodes (%d deep), %.1f bytes per triangle",
+		(int)GetNumTriangles(), (int)bvhNodes.size(), bvhDepth, GetMemoryPerTriangle());
+
+	wsCentre = Vector3(0.0f, 0.0f, 0.0f);
+	wsAxes[0] = Vector3(1.0f, 0.0f, 0.0f);
+	wsAxes[1] = Vector3(0.0f, 1.0f, 0.0f);
+	wsAxes[2] = Vector3(0.0f, 0.0f, 1.0f);
+	UpdateWorldSpaceCache();
+}
+
+void TriangleMeshCollisionShape::BuildBVHNode(int nodeIdx, int depth, int first, int count, std::vector<int>& tri_ids, const std::vector<BoundingBox>& tri_bounds, const std::vector<Vector3>& tri_centres)
+{
+	BoundingBox bounds, centreBounds;
+	for (int i = first; i < first + count; ++i)
+	{
+		ExpandToFit(bounds, tri_bounds[tri_ids[i]]);
+		centreBounds.ExpandToFit(tri_centres[tri_ids[i]]);
+	}
+
+	bvhNodes[nodeIdx].bounds = bounds;
+	bvhNodes[nodeIdx].first = first;
+	bvhNodes[nodeIdx].count = count;
+	bvhDepth = max(bvhDepth, depth);
+	if (count == 1)
+		return;
+
+	//Find the split with the lowest surface area heuristic cost: the chance of a query
+	// reaching each side (its area) times the number of triangles it then has to test
+	// - Unless already too deep, as nothing stops SAH peeling off a few triangles at
+	//   a time, in which case the median split below is used
+	float bestCost = FLT_MAX;
+	int bestAxis = -1, bestSplit = 0;
+	const bool useSAH = depth < TRIANGLEMESH_BVH_SAH_MAX_DEPTH;
+	for (int axis = 0; useSAH && axis < 3; ++axis)
+	{
+		float axisMin = Component(centreBounds._min, axis);
+		float axisSize = Component(centreBounds._max, axis) - axisMin;
+		if (axisSize <= 0.0f)
+			continue;
+
+		int binCounts[TRIANGLEMESH_SAH_BINS] = { 0 };
+		BoundingBox binBounds[TRIANGLEMESH_SAH_BINS];
+		for (int i = first; i < first + count; ++i)
+		{
+			int bin = min((int)((Component(tri_centres[tri_ids[i]], axis) - axisMin) / axisSize * TRIANGLEMESH_SAH_BINS), TRIANGLEMESH_SAH_BINS - 1);
+			binCounts[bin]++;
+			ExpandToFit(binBounds[bin], tri_bounds[tri_ids[i]]);
+		}
+
+		//Sweep from the right to get the cost of everything after each split..
+		float rightCost[TRIANGLEMESH_SAH_BINS];
+		BoundingBox rightBounds;
+		int rightCount = 0;
+		for (int bin = TRIANGLEMESH_SAH_BINS - 1; bin > 0; --bin)
+		{
+			rightCount += binCounts[bin];
+			if (binCounts[bin] > 0) ExpandToFit(rightBounds, binBounds[bin]);
+			rightCost[bin] = rightCount > 0 ? SurfaceArea(rightBounds) * rightCount : 0.0f;
+		}
+
+		//..and then from the left to add on everything before it
+		BoundingBox leftBounds;
+		int leftCount = 0;
+		for (int split = 1; split < TRIANGLEMESH_SAH_BINS; ++split)
+		{
+			leftCount += binCounts[split - 1];
+			if (binCounts[split - 1] > 0) ExpandToFit(leftBounds, binBounds[split - 1]);
+			if (leftCount == 0 || leftCount == count)
+				continue;
+
+			float cost = SurfaceArea(leftBounds) * leftCount + rightCost[split];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = split;
+			}
+		}
+	}
+
+	//Stop if splitting costs more than testing all of the triangles here
+	bool canStop = count <= TRIANGLEMESH_MAX_LEAF_TRIANGLES;
+	if (canStop && (bestAxis < 0 || bestCost >= SurfaceArea(bounds) * count))
+		return;
+
+	int mid = first + count / 2;
+	if (bestAxis >= 0)
+	{
+		float axisMin = Component(centreBounds._min, bestAxis);
+		float axisSize = Component(centreBounds._max, bestAxis) - axisMin;
+		int* midPtr = std::partition(&tri_ids[0] + first, &tri_ids[0] + first + count,
+			[&tri_centres, bestAxis, bestSplit, axisMin, axisSize](int id)
+		{
+			int bin = min((int)((Component(tri_centres[id], bestAxis) - axisMin) / axisSize * TRIANGLEMESH_SAH_BINS), TRIANGLEMESH_SAH_BINS - 1);
+			return bin < bestSplit;
+		});
+		mid = (int)(midPtr - &tri_ids[0]);
+	}
+	else
+	{
+		//Split at the median of the centres, along the longest side (if they are all in
+		// the same place any split is as good as another)
+		Vector3 size = centreBounds._max - centreBounds._min;
+		int axis = (size.x > size.y && size.x > size.z) ? 0 : (size.y > size.z ? 1 : 2);
+		std::nth_element(&tri_ids[0] + first, &tri_ids[0] + mid, &tri_ids[0] + first + count,
+			[&tri_centres, axis](int a, int b)
+		{
+			return Component(tri_centres[a], axis) < Component(tri_centres[b], axis);
+		});
+	}
+
+	int left = (int)bvhNodes.size();
+	bvhNodes.push_back(TriangleMeshBVHNode());
+	bvhNodes.push_back(TriangleMeshBVHNode());
+	bvhNodes[nodeIdx].first = left;
+	bvhNodes[nodeIdx].count = 0;
+
+	BuildBVHNode(left, depth + 1, first, mid - first, tri_ids, tri_bounds, tri_centres);
+	BuildBVHNode(left + 1, depth + 1, mid, first + count - mid, tri_ids, tri_bounds, tri_centres);
+}
+
+void TriangleMeshCollisionShape::GetWorldTriangle(int tri, Vector3& out_a, Vector3& out_b, Vector3& out_c) const
+{
+	const uint* idx = &triangles[tri * 3];
+	out_a = ToWorld(vertices[idx[0]]);
+	out_b = ToWorld(vertices[idx[1]]);
+	out_c = ToWorld(vertices[idx[2]]);
+}
+
+int TriangleMeshCollisionShape::FindOverlappingTriangles(const CollisionShape* other, int* out_triangles, int max_triangles) const
+{
+	if (bvhNodes.empty())
+		return 0;
+
+	//Bounds of the other shape along each of our local axes
+	float qMin[3], qMax[3];
+	for (int i = 0; i < 3; ++i)
+	{
+		float centre = Vector3::Dot(wsAxes[i], wsCentre);
+		qMin[i] = Vector3::Dot(other->GetSupportPoint(-wsAxes[i]), wsAxes[i]) - centre;
+		qMax[i] = Vector3::Dot(other->GetSupportPoint(wsAxes[i]), wsAxes[i]) - centre;
+	}
+
+	int numFound = 0;
+	int stack[TRIANGLEMESH_BVH_STACK_SIZE];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const TriangleMeshBVHNode& node = bvhNodes[stack[--stackSize]];
+		if (node.bounds._min.x > qMax[0] || node.bounds._max.x < qMin[0]
+			|| node.bounds._min.y > qMax[1] || node.bounds._max.y < qMin[1]
+			|| node.bounds._min.z > qMax[2] || node.bounds._max.z < qMin[2])
+			continue;
+
+		if (node.count == 0)
+		{
+			//Always fits, as the hierarchy's depth is limited when it is built
+			assert(stackSize + 2 <= TRIANGLEMESH_BVH_STACK_SIZE);
+			stack[stackSize++] = node.first;
+			stack[stackSize++] = node.first + 1;
+			continue;
+		}
+
+		//Leaves only hold a few triangles, so their own bounds are worked out here
+		// rather than stored
+		for (int tri = node.first; tri < node.first + node.count; ++tri)
+		{
+			const Vector3& a = vertices[triangles[tri * 3]];
+			const Vector3& b = vertices[triangles[tri * 3 + 1]];
+			const Vector3& c = vertices[triangles[tri * 3 + 2]];
+			if (min(a.x, min(b.x, c.x)) > qMax[0] || max(a.x, max(b.x, c.x)) < qMin[0]
+				|| min(a.y, min(b.y, c.y)) > qMax[1] || max(a.y, max(b.y, c.y)) < qMin[1]
+				|| min(a.z, min(b.z, c.z)) > qMax[2] || max(a.z, max(b.z, c.z)) < qMin[2])
+				continue;
+
+			//Carries on counting once the buffer is full
+			if (numFound < max_triangles)
+				out_triangles[numFound] = tri;
+			++numFound;
+		}
+	}
+
+	return numFound;
+}
+
+float TriangleMeshCollisionShape::GetBoundingRadius() const
+{
+	float maxDistSq = 0.0f;
+	for (const Vector3& v : vertices)
+		maxDistSq = max(maxDistSq, Vector3::Dot(v, v));
+	return sqrtf(maxDistSq);
+}
+
+size_t TriangleMeshCollisionShape::GetMemoryUsage() const
+{
+	return sizeof(TriangleMeshCollisionShape)
+		+ vertices.capacity() * sizeof(Vector3)
+		+ triangles.capacity() * sizeof(uint)
+		+ bvhNodes.capacity() * sizeof(TriangleMeshBVHNode);
+}
+
+void TriangleMeshCollisionShape::UpdateWorldSpaceCache()
+{
+	Matrix3 rot;
+	wsCentre = Vector3(0.0f, 0.0f, 0.0f);
+	if (Parent())
+	{
+		rot = Parent()->GetOrientation().ToMatrix3();
+		wsCentre = Parent()->GetPosition();
+	}
+
+	for (int i = 0; i < 3; ++i)
+		wsAxes[i] = rot.GetCol(i);
+}
+
+Matrix3 TriangleMeshCollisionShape::BuildInverseInertia(float invMass) const
+{
+	return Matrix3::ZeroMatrix;
+}
+
+void TriangleMeshCollisionShape::GetCollisionAxes(
+	const PhysicsNode* otherObject,
+	std::vector<Vector3>& out_axes) const
+{
+	for (int i = 0; i < 3; ++i)
+		out_axes.push_back(wsAxes[i]);
+}
+
+Vector3 TriangleMeshCollisionShape::GetClosestPoint(const Vector3& point) const
+{
+	float out_distSq = FLT_MAX;
+	Vector3 out_point = wsCentre;
+
+	TriangleCollisionShape tri;
+	Vector3 a, b, c;
+	for (uint i = 0; i < GetNumTriangles(); ++i)
+	{
+		GetWorldTriangle(i, a, b, c);
+		tri.SetVertices(a, b, c);
+		Vector3 p = tri.GetClosestPoint(point);
+
+		float distSq = Vector3::Dot(p - point, p - point);
+		if (distSq < out_distSq)
+		{
+			out_distSq = distSq;
+			out_point = p;
+		}
+	}
+
+	return out_point;
+}
+
+void TriangleMeshCollisionShape::GetMinMaxVertexOnAxis(
+	const Vector3& axis,
+	Vector3& out_min,
+	Vector3& out_max) const
+{
+	float minCorrelation = FLT_MAX, maxCorrelation = -FLT_MAX;
+	out_min = out_max = wsCentre;
+	for (const Vector3& v : vertices)
+	{
+		Vector3 wsVertex = ToWorld(v);
+		float correlation = Vector3::Dot(axis, wsVertex);
+		if (correlation < minCorrelation)
+		{
+			minCorrelation = correlation;
+			out_min = wsVertex;
+		}
+		if (correlation > maxCorrelation)
+		{
+			maxCorrelation = correlation;
+			out_max = wsVertex;
+		}
+	}
+}
+
+Vector3 TriangleMeshCollisionShape::GetSupportPoint(const Vector3& axis) const
+{
+	Vector3 out_min, out_max;
+	GetMinMaxVertexOnAxis(axis, out_min, out_max);
+	return out_max;
+}
+
+void TriangleMeshCollisionShape::GetIncidentReferencePolygon(
+	const Vector3& axis,
+	OutputSpan<Vector3>& out_face,
+	Vector3& out_normal,
+	OutputSpan<Plane>& out_adjacent_planes) const
+{
+	out_face.push_back(GetSupportPoint(axis));
+	out_normal = axis;
+}
+
+void TriangleMeshCollisionShape::DebugDraw() const
+{
+	Vector3 a, b, c;
+	for (uint i = 0; i < GetNumTriangles(); ++i)
+	{
+		GetWorldTriangle(i, a, b, c);
+		NCLDebug::DrawThickLineNDT(a, b, 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
+		NCLDebug::DrawThickLineNDT(b, c, 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
+		NCLDebug::DrawThickLineNDT(c, a, 0.02f, Vector4(1.0f, 0.2f, 1.0f, 1.0f));
+	}
+}
+
+
+//<---------- TriangleMeshProxyNode ---------->
+
+void TriangleMeshProxyNode::SetTriangle(const Vector3& a, const Vector3& b, const Vector3& c)
+{
+	*pPosition = (a + b + c) / 3.0f;
+	static_cast<TriangleCollisionShape*>(collisionShape)->SetVertices(a, b, c);
+}
@@ -0,0 +1,203 @@
+/******************************************************************************
+Class: TriangleMeshCollisionShape
+Implements: CollisionShape
+Author:
+	Will Hinds      <w.hinds2@newcastle.ac.uk>
+Description:
+
+	Extends CollisionShape to collide against a list of triangles, for static
+	level geometry that can't be made out of a few cuboids. The triangles can come
+	from a render mesh (e.g. an OBJMesh), a NavMesh.txt style file, or any list of
+	vertices and indices.
+
+	The mesh doesn't have to be convex, so it is never tested as a whole. Instead
+	the triangles are put in a bounding volume hierarchy, split using the surface
+	area heuristic (SAH) so that a box query touches as few of them as possible.
+	CollisionDispatch uses FindOverlappingTriangles to descend it with the bounds of
+	the other shape, and only those triangles are then tested, one at a time,
+	against it. Each is loaded on to a hidden TriangleMeshProxyNode, holding a
+	TriangleCollisionShape, so they go through the normal narrowphase as a
+	convex shape of their own.
+
+	Triangles are two sided, so anything pushed more than half way through one
+	will come out of the other side.
+
+	The mesh must be static (inverse mass of zero), and the node's bounding radius
+	set to enclose it (see GetBoundingRadius).
+
+	GetMemoryUsage reports how much the vertices, triangles and hierarchy take up,
+	which is also logged as each mesh is built, to help budget large levels.
+
+	Note: Only the mesh's own vertices are used, not those of any child meshes.
+
+*//////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "CollisionShape.h"
+#include "PhysicsNode.h"
+#include "BoundingBox.h"
+#include <nclgl/Matrix4.h>
+#include <string>
+
+class Mesh;
+
+//Size of the overlap query buffer CollisionDispatch starts with, grown if a query finds more
+#define TRIANGLEMESH_MAX_QUERY_TRIANGLES	128
+
+//Most triangles kept in one leaf of the hierarchy
+#define TRIANGLEMESH_MAX_LEAF_TRIANGLES		4
+
+
+//One triangle, in world space
+class TriangleCollisionShape : public CollisionShape
+{
+public:
+	TriangleCollisionShape();
+	virtual ~TriangleCollisionShape() {}
+
+	void SetVertices(const Vector3& a, const Vector3& b, const Vector3& c);
+
+	inline const Vector3& GetVertex(int i) const	{ return vertices[i]; }
+	inline const Vector3& GetNormal() const			{ return normal; }
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+
+	// Triangles are only ever static
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual bool GetEdgeDirections(std::vector<Vector3>& out_edges) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual Vector3 GetSupportPoint(const Vector3& axis) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		OutputSpan<Vector3>& out_face,
+		Vector3& out_normal,
+		OutputSpan<Plane>& out_adjacent_planes) const override;
+
+protected:
+	Vector3		vertices[3];
+	Vector3		normal;
+	Vector3		edgeNormals[3];	//Outward, in the triangle's plane, edge i runs from vertex i to i + 1
+};
+
+
+struct TriangleMeshBVHNode
+{
+	BoundingBox	bounds;
+	int			first;		//Leaves: first triangle, otherwise the left child (the right being first + 1)
+	int			count;		//Leaves: number of triangles, otherwise zero
+};
+
+class TriangleMeshCollisionShape : public CollisionShape
+{
+public:
+#ifndef NCLTECH_HEADLESS
+	// Uses the mesh's triangles, with each vertex multiplied by scale
+	//  - Only GL_TRIANGLES meshes, indexed or not, are supported
+	TriangleMeshCollisionShape(const Mesh* mesh, const Vector3& scale = Vector3(1.0f, 1.0f, 1.0f));
+#endif
+
+	// Loads a NavMesh.txt style file: the number of vertices and indices,
+	// followed by all of the vertices and then all of the indices
+	TriangleMeshCollisionShape(const std::string& filename, const Matrix4& transform = Matrix4());
+
+	TriangleMeshCollisionShape(const Vector3* vertices, uint numVertices, const uint* indices, uint numIndices);
+	virtual ~TriangleMeshCollisionShape();
+
+	inline uint GetNumTriangles() const						{ return (uint)(triangles.size() / 3); }
+
+	// Gets the triangle's vertices in world space, as of the node's last move
+	void GetWorldTriangle(int tri, Vector3& out_a, Vector3& out_b, Vector3& out_c) const;
+
+	// Finds the triangles whose bounds overlap the bounds of the other shape (at
+	// its current world transform), writing up to max_triangles of them
+	// - Returns how many overlap, which is more than were written if the buffer
+	//   was too small, so the caller can grow it and query again
+	int FindOverlappingTriangles(const CollisionShape* other, int* out_triangles, int max_triangles) const;
+
+	// Distance of the furthest vertex from the node's centre, to be used as its bounding radius
+	float GetBoundingRadius() const;
+
+	// Bytes used by the vertices, triangles and hierarchy
+	size_t GetMemoryUsage() const;
+	inline float GetMemoryPerTriangle() const				{ return triangles.empty() ? 0.0f : (float)GetMemoryUsage() / (float)GetNumTriangles(); }
+
+	// Caches the parent node's transform for GetWorldTriangle and the overlap queries
+	virtual void UpdateWorldSpaceCache() override;
+
+	// Debug Collision Shape
+	virtual void DebugDraw() const override;
+
+
+	// Level geometry is only ever static
+	virtual Matrix3 BuildInverseInertia(float invMass) const override;
+
+
+	// Generic Collision Detection Routines
+	//  - These all treat the mesh as the convex hull of its vertices, and are only
+	//    used by anything that bypasses CollisionDispatch
+	virtual void GetCollisionAxes(
+		const PhysicsNode* otherObject,
+		std::vector<Vector3>& out_axes) const override;
+
+	virtual Vector3 GetClosestPoint(const Vector3& point) const override;
+
+	virtual void GetMinMaxVertexOnAxis(
+		const Vector3& axis,
+		Vector3& out_min,
+		Vector3& out_max) const override;
+
+	virtual Vector3 GetSupportPoint(const Vector3& axis) const override;
+
+	virtual void GetIncidentReferencePolygon(
+		const Vector3& axis,
+		OutputSpan<Vector3>& out_face,
+		Vector3& out_normal,
+		OutputSpan<Plane>& out_adjacent_planes) const override;
+
+protected:
+	//Builds the hierarchy, reordering the triangles to match, see description above
+	void BuildBVH(const std::vector<Vector3>& in_vertices, const std::vector<uint>& in_indices);
+	void BuildBVHNode(int nodeIdx, int depth, int first, int count, std::vector<int>& tri_ids, const std::vector<BoundingBox>& tri_bounds, const std::vector<Vector3>& tri_centres);
+
+	inline Vector3 ToWorld(const Vector3& local) const		{ return wsCentre + wsAxes[0] * local.x + wsAxes[1] * local.y + wsAxes[2] * local.z; }
+
+protected:
+	std::vector<Vector3>				vertices;		//Local space
+	std::vector<uint>					triangles;		//Three vertex indices per triangle, in leaf order
+	std::vector<TriangleMeshBVHNode>	bvhNodes;		//Root is the first node
+	int									bvhDepth;		//Of the deepest leaf, the root being 0
+
+	//World space axes and centre of the parent node, as of its last move
+	Vector3								wsCentre;
+	Vector3								wsAxes[3];
+};
+
+
+//Hidden node that the mesh's (or a heightfield's) triangles are loaded on to, one
+// at a time, to be passed to the narrowphase
+class TriangleMeshProxyNode : public PhysicsNode
+{
+public:
+	TriangleMeshProxyNode()											{ SetCollisionShape(new TriangleCollisionShape()); }
+
+	// Moves the node on to the world space triangle, without waking it
+	void SetTriangle(const Vector3& a, const Vector3& b, const Vector3& c);
+};